@@ -35,10 +35,11 @@
 
 */
 #include <Arduino.h>
-#include <FastLED.h>
 
+#include "BadgeColor.h"
 #include "Debounce.h"
 #include "OHS2024Badge.h"
+#include "Oscillator.h"
 
 // badge LED control
 OHS2024Badge badge = {};
@@ -51,7 +52,7 @@ const byte mode_button_pin = 26;
 // Animation
 const byte anim_num_modes = 3;
 const unsigned long anim_speed_period_ms = 1000;
-unsigned long anim_time = 0;
+Oscillator anim_breathing = {};
 byte anim_mode = 0;
 
 // colors
@@ -69,6 +70,13 @@ void setup() {
     // initialize badge LEDs
     badge.Setup();
 
+    // perceptual brightness curve so fades look even
+    OHS2024BadgeColorCorrection correction = {};
+    correction.curve_red = ColorCurve::Cie1931;
+    correction.curve_green = ColorCurve::Cie1931;
+    correction.curve_blue = ColorCurve::Cie1931;
+    badge.SetColorCorrection(correction);
+
     // Button mode
     pinMode(mode_button_pin, INPUT_PULLUP);
     DebounceConfiguration debounce_config = {};
@@ -80,12 +88,11 @@ void setup() {
 
     // initial animation
     anim_mode = 0;
-    anim_time = 0;
+    anim_breathing.SetPeriod(anim_speed_period_ms, timer_step);
+    anim_breathing.SetPhase(0);
 
     // Start with eyes on
-    badge.TurnOffBodyLEDs();
-    badge.TurnOffHeadLEDs();
-    badge.TurnOnEyeLEDs();
+    badge.SetLEDMask(OHS2024BadgeLEDMask::Eyes);
 
     // timer begin
     timer_prev = millis();
@@ -113,30 +120,24 @@ void loop() {
         if (button_press && !button_press_processed) {
             button_press_processed = true;
             // button pressed: go to next animation mode
-            anim_mode = (anim_mode + 1) % anim_mode;
+            anim_mode = (anim_mode + 1) % anim_num_modes;
             // transition state
             switch (anim_mode) {
                 case 0:
                     // Transition to Eyes
-                    badge.TurnOffBodyLEDs();
-                    badge.TurnOffHeadLEDs();
-                    badge.TurnOnEyeLEDs();
+                    badge.SetLEDMask(OHS2024BadgeLEDMask::Eyes);
                     color_current = color_eyes;
                     break;
 
                 case 1:
                     // Transition to Body
-                    badge.TurnOffEyeLEDs();
-                    badge.TurnOffHeadLEDs();
-                    badge.TurnOnBodyLEDs();
+                    badge.SetLEDMask(OHS2024BadgeLEDMask::Body);
                     color_current = color_body;
                     break;
 
                 case 2:
                     // Transition to Head
-                    badge.TurnOffBodyLEDs();
-                    badge.TurnOffEyeLEDs();
-                    badge.TurnOnHeadLEDs();
+                    badge.SetLEDMask(OHS2024BadgeLEDMask::Head);
                     color_current = color_head;
                     break;
 
@@ -146,16 +147,11 @@ void loop() {
         }
 
         // color animation
-        anim_time = anim_time + timer_step;
-        if (anim_time >= anim_speed_period_ms) {
-            // wrap animation time when exceeds period
-            anim_time = (anim_time - anim_speed_period_ms);
-        }
+        anim_breathing.Tick();
         // blend with breathing waveform
-        const byte wave_input = static_cast<byte>((anim_time * UINT8_MAX) / anim_speed_period_ms);
-        const byte blend_amount = quadwave8(wave_input);
+        const byte blend_amount = anim_breathing.Quad();
         // blend color
-        const CRGB color = blend(color_start, color_current, blend_amount);
+        const CRGB color = Blend(color_start, color_current, blend_amount);
         badge.SetColor(color.r, color.g, color.b);
     }
 }
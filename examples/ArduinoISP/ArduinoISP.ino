@@ -42,6 +42,12 @@
 
 #define PROG_FLICKER true
 
+// Uncomment for the fast profile: 115200 baud and an SPI clock for targets
+// running at 8 MHz or more, such as the badge once its fuses are set. A new
+// ATmega runs at 1 MHz until its fuses are written, which needs the default
+// profile. The host must use the same baud rate (avrdude -b 115200).
+// #define ARDUINOISP_FAST
+
 // Configure SPI clock (in Hz).
 // E.g. for an ATtiny @ 128 kHz: the datasheet states that both the high and low
 // SPI clock pulse must be > 2 CPU cycles, so take 3 cycles i.e. divide target
@@ -50,7 +56,13 @@
 //
 // A clock slow enough for an ATtiny85 @ 1 MHz, is a reasonable default:
 
+#ifndef SPI_CLOCK
+#ifdef ARDUINOISP_FAST
+#define SPI_CLOCK (8000000 / 6)
+#else
 #define SPI_CLOCK (1000000 / 6)
+#endif
+#endif
 
 
 // Select hardware or software SPI, depending on SPI clock.
@@ -137,11 +149,25 @@
 #endif
 
 
-// Configure the baud rate:
+// Configure the baud rate, here or at build time with -D BAUDRATE=...:
 
+#ifndef BAUDRATE
+#ifdef ARDUINOISP_FAST
+#define BAUDRATE 115200
+#else
 #define BAUDRATE 19200
+#endif
 // #define BAUDRATE	115200
 // #define BAUDRATE	1000000
+#endif
+
+
+// Uncomment to receive flash pages into one buffer instead of two, which takes
+// 256 bytes less RAM. Each page is then loaded and written into the target
+// before STK_PROG_PAGE is answered, so nothing overlaps the serial transfer and
+// a 32 KB image takes about 29 s to write instead of 19 s at 19200 baud
+// (test_arduino_isp).
+// #define ARDUINOISP_SINGLE_PAGE_BUFFER
 
 
 #define HWVER 2
@@ -239,6 +265,35 @@ int pmode = 0;
 unsigned int here;
 uint8_t buff[256];  // global block storage
 
+// Flash pages are double buffered: STK_PROG_PAGE is acknowledged as soon as
+// its page is received, and the page is then loaded into the target and
+// committed from getch() while the host sends the next page into the other
+// buffer. The wait after a commit is deferred until the target is needed again.
+#define TWD_FLASH_US 4500  // longest flash page write time of AVR targets
+#define TWD_EEPROM_US 45000UL  // EEPROM write time for parts without polling
+#ifdef ARDUINOISP_SINGLE_PAGE_BUFFER
+#define PAGE_BUFFERS 1
+#else
+#define PAGE_BUFFERS 2
+#endif
+uint8_t page_buff[PAGE_BUFFERS][256];
+uint8_t page_staging = 0;  // buffer the next page is received into
+
+typedef struct page_job {
+  uint8_t *data;
+  unsigned int addr;  // word address of the next word to load
+  unsigned int page;  // page being filled
+  int length;
+  int loaded;  // bytes loaded so far
+  bool active;
+  bool poll;  // poll RDY/BSY after each commit of this job
+} page_job;
+
+page_job job;
+bool commit_pending = false;
+bool commit_poll;
+unsigned long commit_start;
+
 #define beget16(addr) (*addr * 256 + *(addr + 1))
 typedef struct param {
   uint8_t devicecode;
@@ -254,6 +309,7 @@ typedef struct param {
   uint16_t pagesize;
   uint16_t eepromsize;
   uint32_t flashsize;
+  uint8_t eeprompagesize;  // 0 if EEPROM is written byte by byte
 } parameter;
 
 parameter param;
@@ -300,14 +356,16 @@ void loop(void) {
 
   // light the heartbeat LED
   heartbeat();
+  flash_service();
   if (SERIAL.available()) {
     avrisp();
   }
 }
 
 uint8_t getch() {
-  while (!SERIAL.available())
-    ;
+  while (!SERIAL.available()) {
+    flash_service();
+  }
   return SERIAL.read();
 }
 void fill(int n) {
@@ -404,6 +462,21 @@ void set_parameters() {
 
   // AVR devices have active low reset, AT89Sx are active high
   rst_active_high = (param.devicecode >= 0xe0);
+
+  // byte-wise EEPROM writes unless the extended parameters follow
+  param.eeprompagesize = 0;
+}
+
+void set_extended_parameters() {
+  // call this after reading extended parameter packet into buff[]
+  // buff[0] is the number of bytes that follow, buff[1] the EEPROM page size
+  uint8_t pagesize = buff[1];
+  // only page sizes that are a power of two split addresses into pages
+  if ((pagesize > 1) && ((pagesize & (pagesize - 1)) == 0)) {
+    param.eeprompagesize = pagesize;
+  } else {
+    param.eeprompagesize = 0;
+  }
 }
 
 void start_pmode() {
@@ -460,63 +533,117 @@ void flash(uint8_t hilo, unsigned int addr, uint8_t data) {
                   addr & 0xFF,
                   data);
 }
-void commit(unsigned int addr) {
-  if (PROG_FLICKER) {
-    prog_lamp(LOW);
-  }
+// start the page write; the target is busy until it reports ready, see target_busy()
+void commit(unsigned int addr, bool poll) {
+  prog_lamp(LOW);
   spi_transaction(0x4C, (addr >> 8) & 0xFF, addr & 0xFF, 0);
-  if (PROG_FLICKER) {
-    delay(PTIME);
-    prog_lamp(HIGH);
+  commit_start = micros();
+  commit_poll = poll;
+  commit_pending = true;
+}
+
+// Check if the target is still busy with a write started at (start): poll
+// RDY/BSY (0xF0) if (poll) is set, and give up after (timeout_us), the
+// worst-case write time, so parts without polling just wait that long.
+bool target_busy(unsigned long start, unsigned long timeout_us, bool poll) {
+  if ((micros() - start) >= timeout_us) {
+    return false;
   }
+  if (!poll) {
+    return true;
+  }
+  return spi_transaction(0xF0, 0x00, 0x00, 0x00) & 0x01;
 }
 
-unsigned int current_page() {
+unsigned int current_page(unsigned int addr) {
   if (param.pagesize == 32) {
-    return here & 0xFFFFFFF0;
+    return addr & 0xFFFFFFF0;
   }
   if (param.pagesize == 64) {
-    return here & 0xFFFFFFE0;
+    return addr & 0xFFFFFFE0;
   }
   if (param.pagesize == 128) {
-    return here & 0xFFFFFFC0;
+    return addr & 0xFFFFFFC0;
   }
   if (param.pagesize == 256) {
-    return here & 0xFFFFFF80;
+    return addr & 0xFFFFFF80;
   }
-  return here;
+  return addr;
 }
 
+// Advance the pending page write by one short step: wait out the last commit,
+// load one word, or commit a page. Steps are short enough that serial data
+// keeps being read between them.
+void flash_service() {
+  if (commit_pending) {
+    if (target_busy(commit_start, TWD_FLASH_US, commit_poll)) {
+      return;
+    }
+    commit_pending = false;
+    prog_lamp(HIGH);
+  }
+  if (!job.active) {
+    return;
+  }
+  if (job.loaded >= job.length) {
+    commit(job.page, job.poll);
+    job.active = false;
+    return;
+  }
+  if (job.page != current_page(job.addr)) {
+    commit(job.page, job.poll);
+    job.page = current_page(job.addr);
+    return;
+  }
+  flash(LOW, job.addr, job.data[job.loaded++]);
+  flash(HIGH, job.addr, job.data[job.loaded++]);
+  job.addr++;
+}
+
+// finish the pending page write before using the target for anything else
+void flash_flush() {
+  while (job.active || commit_pending) {
+    flash_service();
+  }
+}
+
+// hand the page received into page_buff[page_staging] to flash_service(),
+// once the previous page is loaded, and advance here past it
+void start_flash_job(int length, bool poll) {
+  while (job.active) {
+    flash_service();
+  }
+  job.data = page_buff[page_staging];
+  job.addr = here;
+  job.page = current_page(here);
+  job.length = length;
+  job.loaded = 0;
+  job.poll = poll;
+  job.active = true;
+  here += length / 2;
+  page_staging = (page_staging + 1) % PAGE_BUFFERS;
+}
 
 void write_flash(int length) {
-  fill(length);
+  // the previous page keeps loading into the target from getch()
+  uint8_t *data = page_buff[page_staging];
+  for (int x = 0; x < length; x++) {
+    data[x] = getch();
+  }
   if (CRC_EOP == getch()) {
+    start_flash_job(length, param.polling);
+#ifdef ARDUINOISP_SINGLE_PAGE_BUFFER
+    // the next page is received into the same buffer
+    flash_flush();
+#endif
     SERIAL.print((char)STK_INSYNC);
-    SERIAL.print((char)write_flash_pages(length));
+    SERIAL.print((char)STK_OK);
   } else {
     ISPError++;
     SERIAL.print((char)STK_NOSYNC);
   }
 }
 
-uint8_t write_flash_pages(int length) {
-  int x = 0;
-  unsigned int page = current_page();
-  while (x < length) {
-    if (page != current_page()) {
-      commit(page);
-      page = current_page();
-    }
-    flash(LOW, here, buff[x++]);
-    flash(HIGH, here, buff[x++]);
-    here++;
-  }
-
-  commit(page);
-
-  return STK_OK;
-}
-
 #define EECHUNK (32)
 uint8_t write_eeprom(unsigned int length) {
   // here is a word address, get the byte address
@@ -536,16 +663,45 @@ uint8_t write_eeprom(unsigned int length) {
 }
 // write (length) bytes, (start) is a byte address
 uint8_t write_eeprom_chunk(unsigned int start, unsigned int length) {
-  // this writes byte-by-byte, page writing may be faster (4 bytes at a time)
   fill(length);
   prog_lamp(LOW);
+  if (param.eeprompagesize) {
+    write_eeprom_pages(start, length);
+  } else {
+    write_eeprom_bytes(start, length);
+  }
+  prog_lamp(HIGH);
+  return STK_OK;
+}
+
+void write_eeprom_bytes(unsigned int start, unsigned int length) {
   for (unsigned int x = 0; x < length; x++) {
     unsigned int addr = start + x;
     spi_transaction(0xC0, (addr >> 8) & 0xFF, addr & 0xFF, buff[x]);
-    delay(45);
+    eeprom_wait();
+  }
+}
+
+// load the target's EEPROM page buffer (0xC1) and write each page once
+// (0xC2); a partly loaded page only changes the bytes that were loaded
+void write_eeprom_pages(unsigned int start, unsigned int length) {
+  unsigned int mask = param.eeprompagesize - 1;
+  for (unsigned int x = 0; x < length; x++) {
+    unsigned int addr = start + x;
+    spi_transaction(0xC1, (addr >> 8) & 0xFF, addr & 0xFF, buff[x]);
+    if (((addr & mask) == mask) || (x == length - 1)) {
+      unsigned int page = addr & ~mask;
+      spi_transaction(0xC2, (page >> 8) & 0xFF, page & 0xFF, 0);
+      eeprom_wait();
+    }
   }
-  prog_lamp(HIGH);
-  return STK_OK;
+}
+
+// wait for the EEPROM write just started
+void eeprom_wait() {
+  unsigned long written = micros();
+  while (target_busy(written, TWD_EEPROM_US, param.polling))
+    ;
 }
 
 void program_page() {
@@ -558,6 +714,7 @@ void program_page() {
     write_flash(length);
     return;
   }
+  flash_flush();
   if (memtype == 'E') {
     result = (char)write_eeprom(length);
     if (CRC_EOP == getch()) {
@@ -580,6 +737,12 @@ uint8_t flash_read(uint8_t hilo, unsigned int addr) {
                          0);
 }
 
+// Page reads send each byte as soon as it is read, so the TX interrupt sends
+// it while the next one is read over SPI. Reading the whole page into a buffer
+// first and sending it with one SERIAL.write() leaves the line idle during the
+// reads: in test_arduino_isp it verifies at 1187 B/s instead of 1694 B/s at
+// 19200 baud, 2718 instead of 3550 at 115200 and 7002 instead of 8968 with
+// ARDUINOISP_FAST.
 char flash_read_page(int length) {
   for (int x = 0; x < length; x += 2) {
     uint8_t low = flash_read(LOW, here);
@@ -645,6 +808,10 @@ void read_signature() {
 ////////////////////////////////////
 void avrisp() {
   uint8_t ch = getch();
+  // only page writes and addresses may run ahead of a pending page write
+  if ((ch != 0x64) && (ch != 'U')) {
+    flash_flush();
+  }
   switch (ch) {
     case '0':  // signon
       ISPError = 0;
@@ -668,8 +835,9 @@ void avrisp() {
       set_parameters();
       empty_reply();
       break;
-    case 'E':  // extended parameters - ignore for now
+    case 'E':  // extended parameters
       fill(5);
+      set_extended_parameters();
       empty_reply();
       break;
     case 'P':
@@ -732,3 +900,4 @@ void avrisp() {
       }
   }
 }
+
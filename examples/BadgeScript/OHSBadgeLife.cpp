@@ -0,0 +1,210 @@
+/*
+  Open Hardware Summit 2024
+  Designed by Cyber City Circuits
+  Twitter @MakeAugusta
+
+  This board uses Minicore with the Arduino IDE:
+  https://github.com/MCUdude/MiniCore?tab=readme-ov-file#how-to-install
+
+  Board: ATMEGA328
+  Clock: Internal 8MHz
+  Variant: 328PB
+  Port: Comm Port used for your programmer
+  Programmer: Arduino as ISP
+
+  Pin LEDs:
+  Anode 1: 23 - Head Ring Right
+  Anode 2: 04 - Head Ring Top
+  Anode 3: 03 - Head Ring Left
+  Anode 4: 19 - Eye Right
+  Anode 5: 18 - Body Right
+  Anode 6: 17 - Body Center
+  Anode 7: 16 - Body Left
+  Anode 8: 15 - Eye Left
+
+  Pin RGB for LED 1-4:
+  Blue:  00
+  Green: 01
+  Red:   02
+
+  Button: 26 (Active Low)
+
+  SAO GPIO:
+  SAO 1: 06
+  SAO 2: 05
+
+*/
+#include "Arduino.h"
+#include "BadgeEffect.h"
+#include "BadgeScript.h"
+#include "Debounce.h"
+#include "OHS2024Badge.h"
+
+// Pin Assignments
+int Mode_Btn = 26;
+int RandomSeedPin = 14;
+
+// badge LEDs, refreshed from Timer2
+#define REFRESH_HZ 200
+OHS2024Badge badge = {};
+uint8_t scan_length = 1;
+
+ISR(TIMER2_COMPA_vect) {
+    badge.Refresh();
+}
+
+// mode button, polled every loop
+Debounce mode_button = {};
+
+// Scripts, one tick per 20 ms frame
+
+// eyes breathe in green, 1 s period like AnimWithFastLEDTools
+constexpr uint8_t script_breathing[] PROGMEM = {
+    BADGE_SCRIPT_MASK(OHS2024BadgeLEDMask::Eyes),
+    BADGE_SCRIPT_LOOP(0),
+    BADGE_SCRIPT_FADE(0, 200, 100, 25),
+    BADGE_SCRIPT_FADE(0, 0, 0, 25),
+    BADGE_SCRIPT_END_LOOP,
+    BADGE_SCRIPT_END,
+};
+static_assert(BadgeScriptIsValid(script_breathing), "invalid script");
+
+// double beat on the body
+constexpr uint8_t script_heartbeat[] PROGMEM = {
+    BADGE_SCRIPT_MASK(OHS2024BadgeLEDMask::Body),
+    BADGE_SCRIPT_FADE(255, 0, 0, 4),
+    BADGE_SCRIPT_FADE(40, 0, 0, 6),
+    BADGE_SCRIPT_FADE(255, 0, 0, 4),
+    BADGE_SCRIPT_FADE(0, 0, 0, 12),
+    BADGE_SCRIPT_WAIT(25),
+    BADGE_SCRIPT_END,
+};
+static_assert(BadgeScriptIsValid(script_heartbeat), "invalid script");
+
+// one random LED at a time flashes and fades out
+constexpr uint8_t script_twinkle[] PROGMEM = {
+    BADGE_SCRIPT_RANDOM(OHS2024BadgeLEDMask::All),
+    BADGE_SCRIPT_COLOR(120, 50, 255),
+    BADGE_SCRIPT_FADE(0, 0, 0, 20),
+    BADGE_SCRIPT_END,
+};
+static_assert(BadgeScriptIsValid(script_twinkle), "invalid script");
+
+// head flashes red three times, then the body blue
+constexpr uint8_t script_police[] PROGMEM = {
+    BADGE_SCRIPT_MASK(OHS2024BadgeLEDMask::Head),
+    BADGE_SCRIPT_LOOP(3),
+    BADGE_SCRIPT_COLOR(255, 0, 0),
+    BADGE_SCRIPT_WAIT(3),
+    BADGE_SCRIPT_COLOR(0, 0, 0),
+    BADGE_SCRIPT_WAIT(3),
+    BADGE_SCRIPT_END_LOOP,
+    BADGE_SCRIPT_MASK(OHS2024BadgeLEDMask::Body),
+    BADGE_SCRIPT_LOOP(3),
+    BADGE_SCRIPT_COLOR(0, 0, 255),
+    BADGE_SCRIPT_WAIT(3),
+    BADGE_SCRIPT_COLOR(0, 0, 0),
+    BADGE_SCRIPT_WAIT(3),
+    BADGE_SCRIPT_END_LOOP,
+    BADGE_SCRIPT_END,
+};
+static_assert(BadgeScriptIsValid(script_police), "invalid script");
+
+// amber fills from the head down to the body, holds and fades out
+constexpr uint8_t script_fill[] PROGMEM = {
+    BADGE_SCRIPT_MASK(OHS2024BadgeLEDMask::Head),
+    BADGE_SCRIPT_FADE(255, 80, 0, 10),
+    BADGE_SCRIPT_MASK(OHS2024BadgeLEDMask::Eyes),
+    BADGE_SCRIPT_FADE(255, 80, 0, 10),
+    BADGE_SCRIPT_MASK(OHS2024BadgeLEDMask::Body),
+    BADGE_SCRIPT_FADE(255, 80, 0, 10),
+    BADGE_SCRIPT_WAIT(20),
+    BADGE_SCRIPT_MASK(OHS2024BadgeLEDMask::All),
+    BADGE_SCRIPT_FADE(0, 0, 0, 30),
+    BADGE_SCRIPT_END,
+};
+static_assert(BadgeScriptIsValid(script_fill), "invalid script");
+
+void SetupBreathing(BadgeScriptAnimation &script) { script.Setup(script_breathing); }
+void SetupHeartbeat(BadgeScriptAnimation &script) { script.Setup(script_heartbeat); }
+void SetupTwinkle(BadgeScriptAnimation &script) { script.Setup(script_twinkle); }
+void SetupPolice(BadgeScriptAnimation &script) { script.Setup(script_police); }
+void SetupFill(BadgeScriptAnimation &script) { script.Setup(script_fill); }
+
+// Effect registry: every mode is a script, the fill shows several colours at once. All scans are short
+// enough for transitions to crossfade in time, see BadgeEffectPlayer.
+constexpr BadgeEffect effects[] PROGMEM = {
+    MakeBadgeEffect<BadgeScriptAnimation, SetupBreathing>(1, BadgeTransitionType::Crossfade),
+    MakeBadgeEffect<BadgeScriptAnimation, SetupHeartbeat>(1, BadgeTransitionType::Crossfade),
+    MakeBadgeEffect<BadgeScriptAnimation, SetupTwinkle>(1, BadgeTransitionType::Crossfade),
+    MakeBadgeEffect<BadgeScriptAnimation, SetupPolice>(1, BadgeTransitionType::Crossfade),
+    MakeBadgeEffect<BadgeScriptAnimation, SetupFill>(static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs),
+                                                     BadgeTransitionType::Crossfade),
+};
+BadgeEffectPlayer<BadgeEffectMaxStateSize(effects)> player = {};
+
+unsigned long frame_time = 0;
+
+// Function decalarations
+void RenderFrame(unsigned long now);
+
+void setup() {
+    badge.Setup();
+    OHS2024BadgeColorCorrection correction = {};
+    correction.curve_red = ColorCurve::Cie1931;
+    correction.curve_green = ColorCurve::Cie1931;
+    correction.curve_blue = ColorCurve::Cie1931;
+    badge.SetColorCorrection(correction);
+    badge.StartHardwarePWM(10);
+
+    pinMode(Mode_Btn, INPUT_PULLUP);
+    DebounceConfiguration debounce_config = {};
+    debounce_config.pin = Mode_Btn;
+    debounce_config.polarity = HIGH;
+    debounce_config.max_count = 8;
+    mode_button.Setup(debounce_config);
+
+    randomSeed(analogRead(RandomSeedPin));
+
+    BadgeEffectPlayerConfiguration player_config = {};
+    player_config.effects = effects;
+    player_config.num_effects = sizeof(effects) / sizeof(effects[0]);
+    player_config.num_modes = player_config.num_effects;
+    player.Setup(player_config);
+
+    const unsigned long now = millis();
+    player.Start(badge_effect_resume, now, false);
+    scan_length = player.GetScanLength();
+    badge.StartRefresh(REFRESH_HZ, scan_length);
+
+    frame_time = now;
+    RenderFrame(now);
+}
+
+void loop() {
+    const unsigned long now = millis();
+
+    mode_button.Update();
+    if (mode_button.TakeActivated()) {
+        player.Next(now);
+    }
+
+    if ((now - frame_time) >= badge_animation_frame_ms) {
+        frame_time += badge_animation_frame_ms;
+        if ((now - frame_time) >= badge_animation_frame_ms) {
+            frame_time = now;
+        }
+        RenderFrame(now);
+    }
+}
+
+// Renders the running script into the framebuffer and queues it for display
+void RenderFrame(unsigned long now) {
+    OHS2024BadgeColor *pixels = badge.BeginFrame();
+    player.Render(now, pixels);
+    if (player.GetScanLength() != scan_length) {
+        scan_length = player.GetScanLength();
+        badge.StartRefresh(REFRESH_HZ, scan_length);
+    }
+    player.Present(badge);
+}
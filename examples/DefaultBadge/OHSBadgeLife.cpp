@@ -35,533 +35,171 @@
 
 */
 #include "Arduino.h"
+#include "BadgeAnimation.h"
+#include "BadgeEffect.h"
+#include "Debounce.h"
+#include "OHS2024Badge.h"
 
 // colors
-int white[]  = {255, 255, 255};
-int red[]    = {255,   0,   0};
-int cyan[]   = {255,  65,   0};
-int orange[] = {180,  20,  20};
-int yellow[] = {255,  65,   0};
-int purple[] = { 20,   0, 255};
-int green[]  = {  0, 255,   0};
-int blue[]   = {  0,   0, 255};
-int pink[]   = { 20,   0, 255};
+const OHS2024BadgeColor red = {255, 0, 0};
+const OHS2024BadgeColor green = {0, 255, 0};
+const OHS2024BadgeColor blue = {0, 0, 255};
+const OHS2024BadgeColor orange = {180, 20, 20};
 
 // Pin Assignments
-int LED_Count = 8;
-int Anodes[8] = {23, 4, 3, 19, 18, 17, 16, 15};
 int Mode_Btn = 26;
-int Blue = 0;   // PWM Only
-int Red = 2;    // PWM Only
-int Green = 1;  // PWM Only
 int RandomSeedPin = 14;
 
-int no_1[] = {Anodes[0], Anodes[1], Anodes[2]};  // Ring
-int no_2[] = {Anodes[3], Anodes[7], Anodes[7]};  // Eyes
-int no_3[] = {Anodes[4], Anodes[5], Anodes[6]};  // Body
+// badge LEDs, refreshed from Timer2 so every LED can show its own colour. The scan has as many slots as
+// the running effect needs: one for single colour effects so LEDs stay at full brightness, one per LED
+// for particles and transitions.
+#define REFRESH_HZ 200
+OHS2024Badge badge = {};
+uint8_t scan_length = 1;
 
-// Set Colors as Class Objects
-
-long my_timer;
-long mydelay = 100;
-
-int Mode = 4;
-int Program = 10;
-int digit = 0;
-
-int CurrentColor[3] = {0, 0, 0};
-int colorwheel = 0;
-int strand = 0;
-int fade = 0;
-
-// Function decalarations
-void POST();
-void BootUp();
-void reset();
-void setColor(int red, int green, int blue);
-void fastfirework();
-void firework();
-void twinkle();
-void strandtest();
-
-void setup() {
-    pinMode(Mode_Btn, INPUT_PULLUP);
-    pinMode(Blue, OUTPUT);
-    pinMode(Red, OUTPUT);
-    pinMode(Green, OUTPUT);
-    digitalWrite(Blue, HIGH);
-    digitalWrite(Red, HIGH);
-    digitalWrite(Green, HIGH);
-    for (int i = 0; i < LED_Count; i++) {
-        pinMode(Anodes[i], OUTPUT);
-        digitalWrite(Anodes[i], LOW);
-    }
-
-    randomSeed(analogRead(RandomSeedPin));
-
-    // POST
-    if (digitalRead(Mode_Btn) == LOW) {
-        delay(100);
-        POST();
-    }
-
-    BootUp();
-
-    for (int x = 0; x < 2; x++) {
-        CurrentColor[x] = green[x];
-    }
+ISR(TIMER2_COMPA_vect) {
+    badge.Refresh();
 }
 
-void loop() {
-    if (digitalRead(Mode_Btn) == LOW) {
-        delay(200);
-        reset();
-        Mode++;
-        if (Mode > 8) {
-            Mode = 0;
-        }
-
-        switch (Mode) {
-            case 0:  // Red Cycle
-                Program = 0;
-                CurrentColor[0] = 255;  // red
-                CurrentColor[1] = 0;    // green
-                CurrentColor[2] = 0;    // blue
-                break;
-            case 1:  // Green Cycle
-                Program = 0;
-                CurrentColor[0] = 0;
-                CurrentColor[1] = 255;
-                CurrentColor[2] = 0;
-                break;
-            case 2:
-                Program = 0;  // Blue Cycle
-                CurrentColor[0] = 0;
-                CurrentColor[1] = 0;
-                CurrentColor[2] = 255;
-                break;
-            case 3:
-                Program = 0;  // Orange Cycle
-                CurrentColor[0] = 180;
-                CurrentColor[1] = 20;
-                CurrentColor[2] = 20;
-                break;
-            case 4:
-                Program = 10;  // Set Random Colors
-                break;
-            case 5:
-                Program = 20;  // Fast Fireworks
-                // CurrentColor[0] = random(250);
-                // CurrentColor[1] = random(250);
-                // CurrentColor[2] = random(250);
-                break;
-            case 6:
-                Program = 30;  // Fireworks
-                break;
-            case 7:
-                Program = 40;  // Twinkle
-                break;
-            case 8:
-                Program = 50;  // Strand Test Color Fade
-                break;
-        }
-    }
-
-    switch (Program) {
-        case 0:  // Set up timer for case 1
-            mydelay = 100;
-            my_timer = millis() + mydelay;
-            Program = 1;
-            break;
-        case 1:  // Cycle through numbers on badge with random colors
-            // set first set
-            // setColor(random(255), random(255), random(255));
-            setColor(CurrentColor[0], CurrentColor[1], CurrentColor[2]);
-            if (digit == 0) {
-                digitalWrite(no_1[0], HIGH);
-                digitalWrite(no_1[1], HIGH);
-                digitalWrite(no_1[2], HIGH);
-                if (millis() > my_timer) {
-                    my_timer = millis() + mydelay;
-                    digitalWrite(no_1[0], LOW);
-                    digitalWrite(no_1[1], LOW);
-                    digitalWrite(no_1[2], LOW);
-                    digit++;
-                }
-            }
-            if (digit == 1) {
-                digitalWrite(no_2[0], HIGH);
-                digitalWrite(no_2[1], HIGH);
-                digitalWrite(no_2[2], HIGH);
-                if (millis() > my_timer) {
-                    my_timer = millis() + mydelay;
-                    digitalWrite(no_2[0], LOW);
-                    digitalWrite(no_2[1], LOW);
-                    digitalWrite(no_2[2], LOW);
-                    digit++;
-                }
-            }
-            if (digit == 2) {
-                digitalWrite(no_3[0], HIGH);
-                digitalWrite(no_3[1], HIGH);
-                digitalWrite(no_3[2], HIGH);
-                if (millis() > my_timer) {
-                    my_timer = millis() + mydelay;
-                    digitalWrite(no_3[0], LOW);
-                    digitalWrite(no_3[1], LOW);
-                    digitalWrite(no_3[2], LOW);
-                    digit = 0;
-                }
-            }
-            break;
-
-        case 20:  // Set up timer for case 1
-            fastfirework();
-            break;
-        case 30:
-            firework();
-            break;
-        case 40:
-            twinkle();
-            break;
-        case 50:
-            strandtest();
-            break;
-        case 10:
-            // set first set
-            setColor(random(5, 250), random(5, 175), random(100, 250));
-            digitalWrite(no_1[0], HIGH);
-            digitalWrite(no_1[1], HIGH);
-            digitalWrite(no_1[2], HIGH);
-            delay(150);
-            digitalWrite(no_1[0], LOW);
-            digitalWrite(no_1[1], LOW);
-            digitalWrite(no_1[2], LOW);
-
-            setColor(random(5, 250), random(5, 175), random(100, 250));
-            digitalWrite(no_2[0], HIGH);
-            digitalWrite(no_2[1], HIGH);
-            digitalWrite(no_2[2], HIGH);
-            delay(150);
-            digitalWrite(no_2[0], LOW);
-            digitalWrite(no_2[1], LOW);
-            digitalWrite(no_2[2], LOW);
-
-            setColor(random(5, 250), random(5, 175), random(100, 250));
-            digitalWrite(no_3[0], HIGH);
-            digitalWrite(no_3[1], HIGH);
-            digitalWrite(no_3[2], HIGH);
-            delay(150);
-            digitalWrite(no_3[0], LOW);
-            digitalWrite(no_3[1], LOW);
-            digitalWrite(no_3[2], LOW);
-
-            break;
-    }
+// mode button, polled every loop: 6 samples 2 ms apart register a press within 12 ms. The press is
+// rendered at once and shown at the next scan frame, so it is visible within 20 ms.
+#define MODE_BUTTON_MAX_COUNT 6
+Debounce mode_button = {};
+
+// Effect configurations, applied each time an effect starts
+void SetupRedCycle(GroupCycleAnimation &cycle) { cycle.Setup(100, red, false); }
+void SetupGreenCycle(GroupCycleAnimation &cycle) { cycle.Setup(100, green, false); }
+void SetupBlueCycle(GroupCycleAnimation &cycle) { cycle.Setup(100, blue, false); }
+void SetupOrangeCycle(GroupCycleAnimation &cycle) { cycle.Setup(100, orange, false); }
+void SetupRandomCycle(GroupCycleAnimation &cycle) { cycle.Setup(150, {}, true); }
+
+void SetupFastFireworks(FireworkAnimation &fireworks) {
+    FireworkConfiguration config = {};
+    config.chance = 4;
+    config.sparks = 3;
+    config.max_speed = 48;
+    config.decay = 40;
+    fireworks.Setup(config);
 }
 
-void BootUp() {
-    for (int i = 0; i < LED_Count; i++) {
-        digitalWrite(Anodes[i], HIGH);
-    }
-
-    for (int x = 0; x < 250; x++) {
-        setColor(x, x, x);
-        delay(20);
-    }
-
-    delay(1000);
-
-    setColor(0, 0, 0);
-    for (int i = 0; i < LED_Count; i++) {
-        digitalWrite(Anodes[i], LOW);
-    }
+void SetupFireworks(FireworkAnimation &fireworks) {
+    FireworkConfiguration config = {};
+    config.chance = 12;
+    config.sparks = 4;
+    config.max_speed = 24;
+    config.decay = 16;
+    fireworks.Setup(config);
 }
 
-void strandtest() {
-    for (int i = 0; i < LED_Count; i++) {
-        digitalWrite(Anodes[i], HIGH);
-    }
+void SetupTwinkle(TwinkleAnimation &twinkle) { twinkle.Setup(4); }
+void SetupStrand(StrandAnimation &strand) { strand.Setup(2); }
+
+// Effect registry in flash. Modes 0-8 follow the button and the last one is kept in EEPROM, boot and
+// self-test run once after power on. Adding an effect only takes a line here. Only the particle modes
+// dissolve into each other, other transitions crossfade so single-colour modes keep their brightness.
+#define MODE_COUNT 9
+#define EFFECT_BOOT 9
+#define EFFECT_SELF_TEST 10
+#define PARTICLE_SCAN static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs)
+constexpr BadgeEffect effects[] PROGMEM = {
+    MakeBadgeEffect<GroupCycleAnimation, SetupRedCycle>(1, BadgeTransitionType::Crossfade),
+    MakeBadgeEffect<GroupCycleAnimation, SetupGreenCycle>(1, BadgeTransitionType::Crossfade),
+    MakeBadgeEffect<GroupCycleAnimation, SetupBlueCycle>(1, BadgeTransitionType::Crossfade),
+    MakeBadgeEffect<GroupCycleAnimation, SetupOrangeCycle>(1, BadgeTransitionType::Crossfade),
+    MakeBadgeEffect<GroupCycleAnimation, SetupRandomCycle>(1, BadgeTransitionType::Crossfade),
+    MakeBadgeEffect<FireworkAnimation, SetupFastFireworks>(PARTICLE_SCAN, BadgeTransitionType::Dissolve),
+    MakeBadgeEffect<FireworkAnimation, SetupFireworks>(PARTICLE_SCAN, BadgeTransitionType::Dissolve),
+    MakeBadgeEffect<TwinkleAnimation, SetupTwinkle>(PARTICLE_SCAN, BadgeTransitionType::Dissolve),
+    MakeBadgeEffect<StrandAnimation, SetupStrand>(1, BadgeTransitionType::Crossfade),
+    MakeBadgeEffectOnce<BootAnimation>(1, BadgeTransitionType::Crossfade, badge_effect_resume),
+    MakeBadgeEffectOnce<SelfTestAnimation>(1, BadgeTransitionType::Crossfade, EFFECT_BOOT),
+};
+static_assert(sizeof(effects) / sizeof(effects[0]) == EFFECT_SELF_TEST + 1, "effect indices must match registry");
+
+// Runs the registry, with storage for the largest effect twice: running and fading out
+BadgeEffectPlayer<BadgeEffectMaxStateSize(effects)> player = {};
+
+// mode shown after boot
+uint8_t saved_mode EEMEM;
+
+unsigned long frame_time = 0;
 
-    switch (strand) {
-        case 0:
-            setColor(colorwheel, 0, 0);  // fade red
-            break;
-        case 1:
-            setColor(0, colorwheel, 0);  // fade green
-            break;
-        case 2:
-            setColor(0, 0, colorwheel);  // fade blue
-            break;
-    }
+// Function decalarations
+void RenderFrame(unsigned long now);
 
-    if (fade == 0) {
-        colorwheel++;
-    } else {
-        colorwheel--;
-    }
+void setup() {
+    badge.Setup();
 
-    if (colorwheel > 252) {
-        fade = 1;
-    }
+    // perceptual brightness curve so fades look even, dithered 4 bits below the PWM step so they stay
+    // smooth near black
+    OHS2024BadgeColorCorrection correction = {};
+    correction.curve_red = ColorCurve::Cie1931;
+    correction.curve_green = ColorCurve::Cie1931;
+    correction.curve_blue = ColorCurve::Cie1931;
+    correction.dither_bits = 4;
+    badge.SetColorCorrection(correction);
 
-    if (colorwheel < 1) {
-        fade = 0;
-        strand++;
-    }
+    // 10-bit PWM at 7.8 kHz on Timer3/Timer4: no flicker on camera or against the refresh scan
+    badge.StartHardwarePWM(10);
 
-    if (strand > 2) {
-        strand = 0;
-    }
+    pinMode(Mode_Btn, INPUT_PULLUP);
+    DebounceConfiguration debounce_config = {};
+    debounce_config.pin = Mode_Btn;
+    debounce_config.polarity = HIGH;
+    debounce_config.max_count = MODE_BUTTON_MAX_COUNT;
+    mode_button.Setup(debounce_config);
 
-    delay(2);
-}
+    randomSeed(analogRead(RandomSeedPin));
 
-// Sets Colors with Analog Outputs
-void setColor(int red, int green, int blue) {
-    red = 255 - red;
-    green = 255 - green;
-    blue = 255 - blue;
-    analogWrite(Red, red);
-    analogWrite(Green, green);
-    analogWrite(Blue, blue);
-}
+    BadgeEffectPlayerConfiguration player_config = {};
+    player_config.effects = effects;
+    player_config.num_effects = sizeof(effects) / sizeof(effects[0]);
+    player_config.num_modes = MODE_COUNT;
+    player_config.default_mode = 4;
+    player_config.saved_mode = &saved_mode;
+    player_config.transition_ms = 600;
+    player.Setup(player_config);
 
-// Power On Self-Test
-void POST() {
-    for (int i = 0; i < LED_Count / 2; i++) {
-        digitalWrite(Anodes[i], HIGH);
-        digitalWrite(Anodes[i + 4], HIGH);
-        digitalWrite(Red, LOW);
-        delay(100);
-        digitalWrite(Red, HIGH);
-        digitalWrite(Green, LOW);
-        delay(100);
-        digitalWrite(Green, HIGH);
-        digitalWrite(Blue, LOW);
-        delay(100);
-        digitalWrite(Blue, HIGH);
-        delay(100);
-        digitalWrite(Anodes[i], LOW);
-        digitalWrite(Anodes[i + 4], LOW);
-    }
-}
+    const unsigned long now = millis();
 
-// Resets all anodes low/off
-void reset() {
-    for (int i = 0; i < LED_Count; i++) {
-        digitalWrite(Anodes[i], LOW);
-    }
-    analogWrite(Red, 0);
-    analogWrite(Green, 0);
-    analogWrite(Blue, 0);
-}
+    // POST when the button is held at power on
+    player.Start((digitalRead(Mode_Btn) == LOW) ? EFFECT_SELF_TEST : EFFECT_BOOT, now, false);
+    scan_length = player.GetScanLength();
+    badge.StartRefresh(REFRESH_HZ, scan_length);
 
-void firework() {
-    int mydelay = random(5);
-    setColor(0, 0, 0);
-    int a = random(500);
-
-    if (a == 1) {  // Firework an LED!
-        int b = random(LED_Count);
-        int led = random(6);
-        int myColor = random(200, 255);
-
-        digitalWrite(Anodes[b], HIGH);
-
-        switch (led) {
-            case 0:  // Turn Red On
-                for (int x = 0; x < myColor; x++) {
-                    setColor(x, 0, 0);
-                    delay(mydelay);
-                }
-                delay(100);
-                for (int x = myColor; x > 0; x--) {
-                    setColor(x, 0, 0);
-                    delay(mydelay);
-                }
-                break;
-            case 1:  // Turn Green On
-                for (int x = 0; x < myColor; x++) {
-                    setColor(0, x, 0);
-                    delay(mydelay);
-                }
-                delay(100);
-                for (int x = myColor; x > 0; x--) {
-                    setColor(0, x, 0);
-                    delay(mydelay);
-                }
-                break;
-            case 2:  // Turn Blue On
-                for (int x = 0; x < myColor; x++) {
-                    setColor(0, 0, x);
-                    delay(mydelay);
-                }
-                delay(100);
-                for (int x = myColor; x > 0; x--) {
-                    setColor(0, 0, x);
-                    delay(mydelay);
-                }
-                break;
-            case 3:  // Turn Red and Green On
-                for (int x = 0; x < myColor; x++) {
-                    setColor(x, x, 0);
-                    delay(mydelay);
-                }
-                delay(100);
-                for (int x = myColor; x > 0; x--) {
-                    setColor(x, x, 0);
-                    delay(mydelay);
-                }
-                break;
-            case 4:  // Turn Green and Blue On
-                for (int x = 0; x < myColor; x++) {
-                    setColor(0, x, x);
-                    delay(mydelay);
-                }
-                delay(100);
-                for (int x = myColor; x > 0; x--) {
-                    setColor(0, x, x);
-                    delay(mydelay);
-                }
-                break;
-            case 5:  // Turn Red and Blue On
-                for (int x = 0; x < myColor; x++) {
-                    setColor(x, 0, x);
-                    delay(mydelay);
-                }
-                delay(100);
-                for (int x = myColor; x > 0; x--) {
-                    setColor(x, 0, x);
-                    delay(mydelay);
-                }
-                break;
-        }
-        delay(50);
-        digitalWrite(Anodes[b], LOW);
-    }
+    frame_time = now;
+    RenderFrame(now);
 }
 
-void fastfirework() {
-    int mydelay = 1;  // random(5);
-    setColor(0, 0, 0);
-    int a = random(100);
-
-    if (a == 1) {  // Firework an LED!
-        int b = random(LED_Count);
-        int c = random(LED_Count);
-        int led = random(6);
-        int myColor = random(200, 255);
-
-        digitalWrite(Anodes[b], HIGH);
-        digitalWrite(Anodes[c], HIGH);
-
-        switch (led) {
-            case 0:  // Turn Red On
-                for (int x = 0; x < myColor; x++) {
-                    setColor(x, 0, 0);
-                    delay(mydelay);
-                }
-                delay(100);
-                for (int x = myColor; x > 0; x--) {
-                    setColor(x, 0, 0);
-                    delay(mydelay);
-                }
-                break;
-            case 1:  // Turn Green On
-                for (int x = 0; x < myColor; x++) {
-                    setColor(0, x, 0);
-                    delay(mydelay);
-                }
-                delay(100);
-                for (int x = myColor; x > 0; x--) {
-                    setColor(0, x, 0);
-                    delay(mydelay);
-                }
-                break;
-            case 2:  // Turn Blue On
-                for (int x = 0; x < myColor; x++) {
-                    setColor(0, 0, x);
-                    delay(mydelay);
-                }
-                delay(100);
-                for (int x = myColor; x > 0; x--) {
-                    setColor(0, 0, x);
-                    delay(mydelay);
-                }
-                break;
-            case 3:  // Turn Red and Green On
-                for (int x = 0; x < myColor; x++) {
-                    setColor(x, x, 0);
-                    delay(mydelay);
-                }
-                delay(100);
-                for (int x = myColor; x > 0; x--) {
-                    setColor(x, x, 0);
-                    delay(mydelay);
-                }
-                break;
-            case 4:  // Turn Green and Blue On
-                for (int x = 0; x < myColor; x++) {
-                    setColor(0, x, x);
-                    delay(mydelay);
-                }
-                delay(100);
-                for (int x = myColor; x > 0; x--) {
-                    setColor(0, x, x);
-                    delay(mydelay);
-                }
-                break;
-            case 5:  // Turn Red and Blue On
-                for (int x = 0; x < myColor; x++) {
-                    setColor(x, 0, x);
-                    delay(mydelay);
-                }
-                delay(100);
-                for (int x = myColor; x > 0; x--) {
-                    setColor(x, 0, x);
-                    delay(mydelay);
-                }
-                break;
+void loop() {
+    const unsigned long now = millis();
+
+    mode_button.Update();
+    if (mode_button.TakeActivated()) {
+        // boot and self-test end early on a press
+        player.Next(now);
+        // render the press now instead of at the next frame tick
+        frame_time = now;
+        RenderFrame(now);
+    }
+
+    if ((now - frame_time) >= badge_animation_frame_ms) {
+        frame_time += badge_animation_frame_ms;
+        if ((now - frame_time) >= badge_animation_frame_ms) {
+            // fell behind by more than a frame: resync instead of rendering a burst
+            frame_time = now;
         }
-        delay(1);
-        digitalWrite(Anodes[b], LOW);
-        digitalWrite(Anodes[c], LOW);
+        RenderFrame(now);
     }
 }
 
-void twinkle() {
-    setColor(0, 0, 0);
-    int a = random(500);
-
-    if (a == 1) {  // Firework an LED!
-        int b = random(LED_Count);
-
-        digitalWrite(Anodes[b], HIGH);
-
-        int myred = 120;
-        int mygreen = 50;
-        int myblue = 255;
-
-        setColor(myred, mygreen, myblue);
-        for (int x = 0; x < 255; x++) {
-            myred--;
-            mygreen--;
-            myblue--;
-
-            if (myred < 1) {
-                myred = 0;
-            }
-            if (mygreen < 1) {
-                mygreen = 0;
-            }
-            if (myblue < 1) {
-                myblue = 0;
-            }
-            setColor(myred, mygreen, myblue);
-            delay(1);
-        }
-
-        digitalWrite(Anodes[b], LOW);
+// Renders the running effect into the framebuffer and queues it for display
+void RenderFrame(unsigned long now) {
+    OHS2024BadgeColor *pixels = badge.BeginFrame();
+    player.Render(now, pixels);
+    if (player.GetScanLength() != scan_length) {
+        scan_length = player.GetScanLength();
+        badge.StartRefresh(REFRESH_HZ, scan_length);
     }
+    player.Present(badge);
 }
@@ -0,0 +1,489 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "OHS2024Badge.h"
+#include "ParticleSystem.h"
+
+/**
+ * @brief Frame period shared by all animations, in milliseconds.
+ *
+ * The sketch renders one frame of the current animation every period. Animations take their timing from
+ * the time passed to Update(), so the period only sets how smoothly they are sampled.
+ */
+constexpr uint8_t badge_animation_frame_ms = 20;
+
+/**
+ * @brief Fill the LEDs of a mask with a colour, leaving other LEDs unchanged.
+ *
+ * @param pixels Framebuffer with one colour per OHS2024BadgeLED.
+ * @param mask LEDs to fill.
+ * @param color Colour to fill with.
+ */
+inline void BadgeAnimationFill(OHS2024BadgeColor *pixels, byte mask, const OHS2024BadgeColor &color) {
+    for (uint8_t i = 0; i < static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs); i++) {
+        if (mask & (1 << i)) {
+            pixels[i] = color;
+        }
+    }
+}
+
+/**
+ * @brief Count whole frames elapsed since a frame time and advance it past them.
+ *
+ * For animations that step per frame rather than compute from elapsed time. At most 4 frames are
+ * counted, so a long stall does not turn into a burst of work.
+ *
+ * @param now Current time in milliseconds.
+ * @param frame_time Time of the last frame counted, advanced by the frames returned.
+ * @return Frames to step.
+ */
+inline uint8_t BadgeAnimationFrames(uint32_t now, uint32_t &frame_time) {
+    static constexpr uint8_t max_frames = 4;
+    uint8_t frames = 0;
+    while (((now - frame_time) >= badge_animation_frame_ms) && (frames < max_frames)) {
+        frame_time += badge_animation_frame_ms;
+        frames++;
+    }
+    if ((now - frame_time) >= badge_animation_frame_ms) {
+        frame_time = now;
+    }
+    return frames;
+}
+
+/**
+ * @brief Light the head, eyes and body in turn.
+ *
+ * Each Update() renders a full frame and returns without waiting, like every animation in this file.
+ */
+class GroupCycleAnimation {
+   public:
+    GroupCycleAnimation() = default;
+
+    /**
+     * @brief Configure the cycle.
+     *
+     * @param step_ms Time each group stays lit, in milliseconds.
+     * @param color Colour of every group, unless randomized.
+     * @param randomize Pick a new random colour for each group.
+     */
+    void Setup(uint16_t step_ms, const OHS2024BadgeColor &color, bool randomize);
+
+    /**
+     * @brief Restart from the head.
+     *
+     * @param now Current time in milliseconds.
+     */
+    void Start(uint32_t now);
+
+    /**
+     * @brief Render the frame at a time.
+     *
+     * @param now Current time in milliseconds.
+     * @param pixels Framebuffer with one colour per OHS2024BadgeLED.
+     */
+    void Update(uint32_t now, OHS2024BadgeColor *pixels);
+
+   private:
+    static constexpr uint8_t num_groups = 3;
+
+    void PickColor();
+
+    uint16_t m_step_ms = 100;
+    OHS2024BadgeColor m_base_color = {};
+    bool m_randomize = false;
+
+    OHS2024BadgeColor m_color = {};
+    uint8_t m_group = 0;
+    uint32_t m_step_time = 0;
+};
+
+/**
+ * @brief Configuration for fireworks
+ */
+struct FireworkConfiguration {
+    /**
+     * @brief A burst is launched on a frame with a chance of 1 in this value. Bursts overlap freely.
+     */
+    uint16_t chance = 8;
+    /**
+     * @brief Number of sparks in each burst.
+     */
+    uint8_t sparks = 4;
+    /**
+     * @brief Largest spark speed in 1/256 LED per frame. Each spark picks a speed and direction up to this.
+     */
+    uint8_t max_speed = 24;
+    /**
+     * @brief Brightness lost by sparks per frame, as a fraction of 256.
+     */
+    uint8_t decay = 24;
+};
+
+/**
+ * @brief Bursts of sparks in one or two colour channels that spread from a random LED and fade.
+ */
+class FireworkAnimation {
+   public:
+    /**
+     * @brief Most sparks alive at once.
+     */
+    static constexpr uint8_t max_sparks = 16;
+
+    FireworkAnimation() = default;
+
+    /**
+     * @brief Configure bursts.
+     *
+     * @param config Firework configuration parameters.
+     */
+    void Setup(const FireworkConfiguration &config);
+
+    /**
+     * @brief Restart with no sparks.
+     *
+     * @param now Current time in milliseconds.
+     */
+    void Start(uint32_t now);
+
+    /**
+     * @brief Render the frame at a time.
+     *
+     * @param now Current time in milliseconds.
+     * @param pixels Framebuffer with one colour per OHS2024BadgeLED.
+     */
+    void Update(uint32_t now, OHS2024BadgeColor *pixels);
+
+   private:
+    void Launch();
+
+    FireworkConfiguration m_config = {};
+
+    ParticleSystem<max_sparks> m_sparks = {};
+    uint32_t m_frame_time = 0;
+};
+
+/**
+ * @brief Random LEDs light up in a cool white and fade out.
+ */
+class TwinkleAnimation {
+   public:
+    /**
+     * @brief Most twinkles alive at once.
+     */
+    static constexpr uint8_t max_twinkles = 8;
+
+    TwinkleAnimation() = default;
+
+    /**
+     * @brief Configure twinkles.
+     *
+     * @param chance A twinkle starts on a frame with a chance of 1 in this value.
+     */
+    void Setup(uint16_t chance);
+
+    /**
+     * @brief Restart with no twinkles.
+     *
+     * @param now Current time in milliseconds.
+     */
+    void Start(uint32_t now);
+
+    /**
+     * @brief Render the frame at a time.
+     *
+     * @param now Current time in milliseconds.
+     * @param pixels Framebuffer with one colour per OHS2024BadgeLED.
+     */
+    void Update(uint32_t now, OHS2024BadgeColor *pixels);
+
+   private:
+    static constexpr OHS2024BadgeColor start_color = {120, 50, 255};
+    static constexpr uint8_t decay = 56;
+
+    uint16_t m_chance = 4;
+
+    ParticleSystem<max_twinkles> m_twinkles = {};
+    uint32_t m_frame_time = 0;
+};
+
+/**
+ * @brief All LEDs fade up and down in red, then green, then blue.
+ */
+class StrandAnimation {
+   public:
+    StrandAnimation() = default;
+
+    /**
+     * @brief Configure the fade.
+     *
+     * @param step_ms Time per brightness step, in milliseconds.
+     */
+    void Setup(uint8_t step_ms);
+
+    /**
+     * @brief Restart from red.
+     *
+     * @param now Current time in milliseconds.
+     */
+    void Start(uint32_t now);
+
+    /**
+     * @brief Render the frame at a time.
+     *
+     * @param now Current time in milliseconds.
+     * @param pixels Framebuffer with one colour per OHS2024BadgeLED.
+     */
+    void Update(uint32_t now, OHS2024BadgeColor *pixels);
+
+   private:
+    static constexpr uint8_t peak = 253;
+
+    uint8_t m_step_ms = 2;
+
+    uint32_t m_start_time = 0;
+    uint8_t m_channel = 0;
+};
+
+/**
+ * @brief Boot sequence: all LEDs fade up to white, hold, then turn off.
+ */
+class BootAnimation {
+   public:
+    BootAnimation() = default;
+
+    /**
+     * @brief Restart the sequence.
+     *
+     * @param now Current time in milliseconds.
+     */
+    void Start(uint32_t now);
+
+    /**
+     * @brief Render the frame at a time.
+     *
+     * @param now Current time in milliseconds.
+     * @param pixels Framebuffer with one colour per OHS2024BadgeLED.
+     */
+    void Update(uint32_t now, OHS2024BadgeColor *pixels);
+
+    /**
+     * @brief Check if the sequence has finished.
+     */
+    bool IsDone() const;
+
+   private:
+    static constexpr uint8_t peak = 250;
+    static constexpr uint8_t step_ms = 20;
+    static constexpr uint16_t hold_ms = 1000;
+
+    uint32_t m_start_time = 0;
+    bool m_done = false;
+};
+
+/**
+ * @brief Power on self-test: light each pair of LEDs in red, green and blue in turn.
+ */
+class SelfTestAnimation {
+   public:
+    SelfTestAnimation() = default;
+
+    /**
+     * @brief Restart the test.
+     *
+     * @param now Current time in milliseconds.
+     */
+    void Start(uint32_t now);
+
+    /**
+     * @brief Render the frame at a time.
+     *
+     * @param now Current time in milliseconds.
+     * @param pixels Framebuffer with one colour per OHS2024BadgeLED.
+     */
+    void Update(uint32_t now, OHS2024BadgeColor *pixels);
+
+    /**
+     * @brief Check if the test has finished.
+     */
+    bool IsDone() const;
+
+   private:
+    static constexpr uint8_t step_ms = 100;
+    static constexpr uint8_t num_pairs = 4;
+
+    uint32_t m_start_time = 0;
+    bool m_done = false;
+};
+
+// Inline functions
+// ----------------
+
+inline void GroupCycleAnimation::Setup(uint16_t step_ms, const OHS2024BadgeColor &color, bool randomize) {
+    m_step_ms = step_ms;
+    m_base_color = color;
+    m_randomize = randomize;
+}
+
+inline void GroupCycleAnimation::Start(uint32_t now) {
+    m_group = 0;
+    m_step_time = now;
+    PickColor();
+}
+
+inline void GroupCycleAnimation::Update(uint32_t now, OHS2024BadgeColor *pixels) {
+    static const byte group_masks[num_groups] = {
+        OHS2024BadgeLEDMask::Head,
+        OHS2024BadgeLEDMask::Eyes,
+        OHS2024BadgeLEDMask::Body,
+    };
+    if ((now - m_step_time) >= m_step_ms) {
+        m_group = (m_group + 1) % num_groups;
+        m_step_time += m_step_ms;
+        if ((now - m_step_time) >= m_step_ms) {
+            // fell behind by more than a step: resync instead of skipping groups
+            m_step_time = now;
+        }
+        PickColor();
+    }
+    BadgeAnimationFill(pixels, OHS2024BadgeLEDMask::All, OHS2024BadgeColor{});
+    BadgeAnimationFill(pixels, group_masks[m_group], m_color);
+}
+
+inline void GroupCycleAnimation::PickColor() {
+    if (m_randomize) {
+        m_color = {static_cast<byte>(random(5, 250)), static_cast<byte>(random(5, 175)),
+                   static_cast<byte>(random(100, 250))};
+    } else {
+        m_color = m_base_color;
+    }
+}
+
+inline void FireworkAnimation::Setup(const FireworkConfiguration &config) { m_config = config; }
+
+inline void FireworkAnimation::Start(uint32_t now) {
+    m_sparks.Clear();
+    m_frame_time = now;
+}
+
+inline void FireworkAnimation::Update(uint32_t now, OHS2024BadgeColor *pixels) {
+    for (uint8_t frames = BadgeAnimationFrames(now, m_frame_time); frames > 0; frames--) {
+        m_sparks.Update();
+        if (random(m_config.chance) == 0) {
+            Launch();
+        }
+    }
+    BadgeAnimationFill(pixels, OHS2024BadgeLEDMask::All, OHS2024BadgeColor{});
+    m_sparks.Render(pixels);
+}
+
+inline void FireworkAnimation::Launch() {
+    // colour channels lit by each kind of burst: red, green, blue, red and green, green and blue, red and blue
+    static const uint8_t channel_sets[] = {0x1, 0x2, 0x4, 0x3, 0x6, 0x5};
+
+    const uint8_t channels = channel_sets[random(sizeof(channel_sets))];
+    const uint8_t peak = random(200, 255);
+    const OHS2024BadgeColor color = {static_cast<byte>((channels & 0x1) ? peak : 0),
+                                     static_cast<byte>((channels & 0x2) ? peak : 0),
+                                     static_cast<byte>((channels & 0x4) ? peak : 0)};
+    const int16_t position = random(static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs)) << 8;
+    for (uint8_t i = 0; i < m_config.sparks; i++) {
+        const int8_t velocity = random(-m_config.max_speed, m_config.max_speed + 1);
+        if (!m_sparks.Spawn(position, velocity, color, m_config.decay)) {
+            break;
+        }
+    }
+}
+
+inline void TwinkleAnimation::Setup(uint16_t chance) { m_chance = chance; }
+
+inline void TwinkleAnimation::Start(uint32_t now) {
+    m_twinkles.Clear();
+    m_frame_time = now;
+}
+
+inline void TwinkleAnimation::Update(uint32_t now, OHS2024BadgeColor *pixels) {
+    for (uint8_t frames = BadgeAnimationFrames(now, m_frame_time); frames > 0; frames--) {
+        m_twinkles.Update();
+        if (random(m_chance) == 0) {
+            m_twinkles.Spawn(random(static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs)) << 8, 0, start_color, decay);
+        }
+    }
+    BadgeAnimationFill(pixels, OHS2024BadgeLEDMask::All, OHS2024BadgeColor{});
+    m_twinkles.Render(pixels);
+}
+
+inline void StrandAnimation::Setup(uint8_t step_ms) { m_step_ms = (step_ms > 0) ? step_ms : 1; }
+
+inline void StrandAnimation::Start(uint32_t now) {
+    m_start_time = now;
+    m_channel = 0;
+}
+
+inline void StrandAnimation::Update(uint32_t now, OHS2024BadgeColor *pixels) {
+    // one channel fades up to the peak and back down, then the next channel starts
+    const uint32_t period_ms = 2UL * peak * m_step_ms;
+    uint32_t elapsed = now - m_start_time;
+    if (elapsed >= period_ms) {
+        m_channel = (m_channel + 1) % 3;
+        m_start_time += period_ms;
+        elapsed -= period_ms;
+        if (elapsed >= period_ms) {
+            m_start_time = now;
+            elapsed = 0;
+        }
+    }
+    const uint16_t step = elapsed / m_step_ms;
+    const uint8_t level = (step < peak) ? step : 2 * peak - step;
+    const OHS2024BadgeColor color = {static_cast<byte>((m_channel == 0) ? level : 0),
+                                     static_cast<byte>((m_channel == 1) ? level : 0),
+                                     static_cast<byte>((m_channel == 2) ? level : 0)};
+    BadgeAnimationFill(pixels, OHS2024BadgeLEDMask::All, color);
+}
+
+inline void BootAnimation::Start(uint32_t now) {
+    m_start_time = now;
+    m_done = false;
+}
+
+inline void BootAnimation::Update(uint32_t now, OHS2024BadgeColor *pixels) {
+    const uint32_t elapsed = now - m_start_time;
+    const uint32_t ramp_ms = static_cast<uint32_t>(peak) * step_ms;
+    uint8_t level = 0;
+    if (elapsed < ramp_ms) {
+        level = elapsed / step_ms;
+    } else if (elapsed < ramp_ms + hold_ms) {
+        level = peak - 1;
+    } else {
+        m_done = true;
+    }
+    BadgeAnimationFill(pixels, OHS2024BadgeLEDMask::All, OHS2024BadgeColor{level, level, level});
+}
+
+inline bool BootAnimation::IsDone() const { return m_done; }
+
+inline void SelfTestAnimation::Start(uint32_t now) {
+    m_start_time = now;
+    m_done = false;
+}
+
+inline void SelfTestAnimation::Update(uint32_t now, OHS2024BadgeColor *pixels) {
+    // each pair shows red, green, blue and dark for one step each
+    static const byte pair_masks[num_pairs] = {
+        OHS2024BadgeLEDMask::HeadRight | OHS2024BadgeLEDMask::BodyRight,
+        OHS2024BadgeLEDMask::HeadTop | OHS2024BadgeLEDMask::BodyCenter,
+        OHS2024BadgeLEDMask::HeadLeft | OHS2024BadgeLEDMask::BodyLeft,
+        OHS2024BadgeLEDMask::EyeRight | OHS2024BadgeLEDMask::EyeLeft,
+    };
+    static const OHS2024BadgeColor colors[4] = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {0, 0, 0}};
+
+    BadgeAnimationFill(pixels, OHS2024BadgeLEDMask::All, OHS2024BadgeColor{});
+    const uint32_t step = (now - m_start_time) / step_ms;
+    if (step >= 4UL * num_pairs) {
+        m_done = true;
+        return;
+    }
+    BadgeAnimationFill(pixels, pair_masks[step / 4], colors[step % 4]);
+}
+
+inline bool SelfTestAnimation::IsDone() const { return m_done; }
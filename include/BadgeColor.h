@@ -0,0 +1,158 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief 8-bit RGB colour.
+ */
+struct CRGB {
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+
+    constexpr CRGB() = default;
+    constexpr CRGB(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue) {}
+};
+
+inline constexpr bool operator==(const CRGB &a, const CRGB &b) { return (a.r == b.r) && (a.g == b.g) && (a.b == b.b); }
+
+inline constexpr bool operator!=(const CRGB &a, const CRGB &b) { return !(a == b); }
+
+/**
+ * @brief 8-bit HSV colour. Hue runs from 0 (red) through 85 (green) and 170 (blue) back to red at 256.
+ */
+struct CHSV {
+    uint8_t h = 0;
+    uint8_t s = 0;
+    uint8_t v = 0;
+
+    constexpr CHSV() = default;
+    constexpr CHSV(uint8_t hue, uint8_t saturation, uint8_t value) : h(hue), s(saturation), v(value) {}
+};
+
+/**
+ * @brief 16 colours stored in flash, interpolated by ColorFromPalette() into 256 steps.
+ */
+struct ColorPalette16 {
+    CRGB entries[16];
+};
+
+/**
+ * @brief Scale a value by a fraction of 256: 255 keeps it, 0 gives 0.
+ */
+inline constexpr uint8_t Scale8(uint8_t value, uint8_t scale) {
+    return (static_cast<uint16_t>(value) * (scale + 1)) >> 8;
+}
+
+/**
+ * @brief Scale all channels of a colour by a fraction of 256.
+ */
+inline constexpr CRGB Scale8(const CRGB &color, uint8_t scale) {
+    return {Scale8(color.r, scale), Scale8(color.g, scale), Scale8(color.b, scale)};
+}
+
+/**
+ * @brief Add two colours, saturating each channel at 255.
+ */
+inline constexpr CRGB AddSaturate(const CRGB &a, const CRGB &b) {
+    return {static_cast<uint8_t>((a.r + b.r > UINT8_MAX) ? UINT8_MAX : a.r + b.r),
+            static_cast<uint8_t>((a.g + b.g > UINT8_MAX) ? UINT8_MAX : a.g + b.g),
+            static_cast<uint8_t>((a.b + b.b > UINT8_MAX) ? UINT8_MAX : a.b + b.b)};
+}
+
+/**
+ * @brief Blend two values: 0 gives a, 255 gives b.
+ */
+inline constexpr uint8_t Blend8(uint8_t a, uint8_t b, uint8_t amount_of_b) {
+    // a * (256 - amount) + b * (amount + 1) in 16 bits: the sum fits even though the steps wrap
+    uint16_t partial = (static_cast<uint16_t>(a) << 8) | b;
+    partial += static_cast<uint16_t>(b) * amount_of_b;
+    partial -= static_cast<uint16_t>(a) * amount_of_b;
+    return partial >> 8;
+}
+
+/**
+ * @brief Blend two colours: 0 gives a, 255 gives b.
+ */
+inline constexpr CRGB Blend(const CRGB &a, const CRGB &b, uint8_t amount_of_b) {
+    return {Blend8(a.r, b.r, amount_of_b), Blend8(a.g, b.g, amount_of_b), Blend8(a.b, b.b, amount_of_b)};
+}
+
+/**
+ * @brief Convert HSV to RGB with integer arithmetic only.
+ *
+ * The hue circle is split into six sectors with a linear ramp across each, so a full saturation, full
+ * value hue sweep always has one channel at 255 and one at 0.
+ */
+inline constexpr CRGB HsvToRgb(const CHSV &hsv) {
+    if (hsv.s == 0) {
+        return {hsv.v, hsv.v, hsv.v};
+    }
+    // sector 0-5 and position across it, without a division
+    const uint16_t h6 = static_cast<uint16_t>(hsv.h) * 6;
+    const uint8_t sector = h6 >> 8;
+    const uint8_t rise = h6 & 0xFF;
+    const uint8_t p = Scale8(hsv.v, UINT8_MAX - hsv.s);
+    const uint8_t q = Scale8(hsv.v, UINT8_MAX - Scale8(hsv.s, rise));
+    const uint8_t t = Scale8(hsv.v, UINT8_MAX - Scale8(hsv.s, UINT8_MAX - rise));
+    switch (sector) {
+        case 0:
+            return {hsv.v, t, p};
+        case 1:
+            return {q, hsv.v, p};
+        case 2:
+            return {p, hsv.v, t};
+        case 3:
+            return {p, q, hsv.v};
+        case 4:
+            return {t, p, hsv.v};
+        default:
+            return {hsv.v, p, q};
+    }
+}
+
+/**
+ * @brief Look up a colour in a palette stored in flash, interpolating between neighbouring entries.
+ *
+ * @param palette Palette in PROGMEM.
+ * @param index Position in the palette: each entry spans 16 steps and the last wraps to the first.
+ * @param brightness Scale applied to the result.
+ */
+inline CRGB ColorFromPalette(const ColorPalette16 *palette, uint8_t index, uint8_t brightness = UINT8_MAX) {
+    const uint8_t entry = index >> 4;
+    CRGB from;
+    CRGB to;
+    memcpy_P(&from, &palette->entries[entry], sizeof(CRGB));
+    memcpy_P(&to, &palette->entries[(entry + 1) & 0x0F], sizeof(CRGB));
+    return Scale8(Blend(from, to, (index & 0x0F) << 4), brightness);
+}
+
+/**
+ * @brief Hue sweep around the colour wheel.
+ */
+inline constexpr ColorPalette16 palette_rainbow PROGMEM = {{
+    {255, 0, 0}, {213, 42, 0}, {171, 85, 0}, {171, 127, 0},
+    {171, 171, 0}, {86, 213, 0}, {0, 255, 0}, {0, 213, 42},
+    {0, 171, 85}, {0, 86, 170}, {0, 0, 255}, {42, 0, 213},
+    {85, 0, 171}, {127, 0, 129}, {171, 0, 85}, {213, 0, 43},
+}};
+
+/**
+ * @brief Black through red and orange to white.
+ */
+inline constexpr ColorPalette16 palette_heat PROGMEM = {{
+    {0, 0, 0}, {51, 0, 0}, {102, 0, 0}, {153, 0, 0},
+    {204, 0, 0}, {255, 0, 0}, {255, 51, 0}, {255, 102, 0},
+    {255, 153, 0}, {255, 204, 0}, {255, 255, 0}, {255, 255, 51},
+    {255, 255, 102}, {255, 255, 153}, {255, 255, 204}, {255, 255, 255},
+}};
+
+/**
+ * @brief Deep blues, teals and aqua.
+ */
+inline constexpr ColorPalette16 palette_ocean PROGMEM = {{
+    {0, 0, 64}, {0, 0, 128}, {0, 0, 255}, {0, 32, 128},
+    {0, 64, 160}, {0, 96, 192}, {0, 128, 255}, {0, 160, 192},
+    {0, 192, 160}, {0, 128, 128}, {0, 96, 160}, {0, 64, 192},
+    {32, 160, 255}, {64, 192, 255}, {0, 96, 224}, {0, 16, 96},
+}};
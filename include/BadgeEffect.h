@@ -0,0 +1,383 @@
+#pragma once
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include <new>
+
+#include "BadgeTransition.h"
+#include "OHS2024Badge.h"
+
+/**
+ * @brief Construct and start an effect in its state storage.
+ *
+ * @param state Storage of at least the effect's state_size bytes.
+ * @param now Current time in milliseconds.
+ */
+using BadgeEffectStartFunction = void (*)(void *state, uint32_t now);
+
+/**
+ * @brief Render one frame of an effect.
+ *
+ * @param state Storage passed to the start function.
+ * @param now Current time in milliseconds.
+ * @param pixels Framebuffer with one colour per OHS2024BadgeLED.
+ * @return False once the effect has finished and its next effect should start.
+ */
+using BadgeEffectUpdateFunction = bool (*)(void *state, uint32_t now, OHS2024BadgeColor *pixels);
+
+/**
+ * @brief Effect index meaning the last mode the player started, or the one saved in EEPROM.
+ */
+constexpr uint8_t badge_effect_resume = 0xFF;
+
+/**
+ * @brief Descriptor of one effect in a registry, stored in flash.
+ *
+ * Build descriptors with MakeBadgeEffect() or MakeBadgeEffectOnce().
+ */
+struct BadgeEffect {
+    BadgeEffectStartFunction start;
+    BadgeEffectUpdateFunction update;
+    /**
+     * @brief Bytes of state the effect needs while it runs.
+     */
+    uint8_t state_size;
+    /**
+     * @brief Refresh scan slots the effect needs: the most distinct colours it shows at once.
+     */
+    uint8_t scan_length;
+    /**
+     * @brief Transition used when the effect starts.
+     */
+    BadgeTransitionType transition;
+    /**
+     * @brief Effect started when this one finishes or the button is pressed, for effects outside the modes.
+     */
+    uint8_t next;
+};
+
+/**
+ * @brief Setup function for animations that need none.
+ */
+template <typename Animation>
+void BadgeEffectNoSetup(Animation &) {}
+
+template <typename Animation, void (*Setup)(Animation &)>
+void BadgeEffectStart(void *state, uint32_t now) {
+    Animation *animation = new (state) Animation();
+    Setup(*animation);
+    animation->Start(now);
+}
+
+template <typename Animation>
+bool BadgeEffectUpdate(void *state, uint32_t now, OHS2024BadgeColor *pixels) {
+    static_cast<Animation *>(state)->Update(now, pixels);
+    return true;
+}
+
+template <typename Animation>
+bool BadgeEffectUpdateOnce(void *state, uint32_t now, OHS2024BadgeColor *pixels) {
+    Animation *animation = static_cast<Animation *>(state);
+    animation->Update(now, pixels);
+    return !animation->IsDone();
+}
+
+/**
+ * @brief Descriptor of an animation class that runs until another effect is started.
+ *
+ * The animation must have Start(now) and Update(now, pixels), see BadgeAnimation.h.
+ *
+ * @tparam Animation Animation class, constructed in the player's state storage.
+ * @tparam Setup Function configuring a new animation before Start().
+ * @param scan_length Refresh scan slots the animation needs.
+ * @param transition Transition used when the animation starts.
+ */
+template <typename Animation, void (*Setup)(Animation &) = BadgeEffectNoSetup<Animation>>
+constexpr BadgeEffect MakeBadgeEffect(uint8_t scan_length, BadgeTransitionType transition) {
+    static_assert(sizeof(Animation) <= UINT8_MAX, "effect state must fit state_size");
+    return {BadgeEffectStart<Animation, Setup>, BadgeEffectUpdate<Animation>, sizeof(Animation), scan_length,
+            transition, badge_effect_resume};
+}
+
+/**
+ * @brief Descriptor of an animation class that runs once and then starts another effect.
+ *
+ * Like MakeBadgeEffect(), and the animation must also have IsDone().
+ *
+ * @param next Effect started when the animation is done, or badge_effect_resume.
+ */
+template <typename Animation, void (*Setup)(Animation &) = BadgeEffectNoSetup<Animation>>
+constexpr BadgeEffect MakeBadgeEffectOnce(uint8_t scan_length, BadgeTransitionType transition, uint8_t next) {
+    static_assert(sizeof(Animation) <= UINT8_MAX, "effect state must fit state_size");
+    return {BadgeEffectStart<Animation, Setup>, BadgeEffectUpdateOnce<Animation>, sizeof(Animation), scan_length,
+            transition, next};
+}
+
+/**
+ * @brief Largest state of the effects in a registry, to size a BadgeEffectPlayer at compile time.
+ */
+template <uint8_t N>
+constexpr uint8_t BadgeEffectMaxStateSize(const BadgeEffect (&effects)[N]) {
+    uint8_t size = 0;
+    for (uint8_t i = 0; i < N; i++) {
+        if (effects[i].state_size > size) {
+            size = effects[i].state_size;
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Configuration for BadgeEffectPlayer
+ */
+struct BadgeEffectPlayerConfiguration {
+    /**
+     * @brief Effect descriptors in PROGMEM.
+     */
+    const BadgeEffect *effects = nullptr;
+    /**
+     * @brief Number of descriptors.
+     */
+    uint8_t num_effects = 0;
+    /**
+     * @brief Number of effects, from the first, cycled by Next() and Previous().
+     */
+    uint8_t num_modes = 0;
+    /**
+     * @brief Mode resumed when none is saved.
+     */
+    uint8_t default_mode = 0;
+    /**
+     * @brief EEMEM byte keeping the last mode across power cycles, or nullptr.
+     */
+    uint8_t *saved_mode = nullptr;
+    /**
+     * @brief Transition duration in milliseconds, 0 to switch effects at once.
+     */
+    uint16_t transition_ms = 600;
+};
+
+/**
+ * @brief Run effects from a registry in flash, with mode cycling, transitions and the mode saved in EEPROM.
+ *
+ * The first num_modes effects are the modes cycled by Next() and Previous(); effects after them, such as a
+ * boot sequence, are only started by index and hand over to their next effect. There is storage for two
+ * effect states, the running effect and the one a transition fades out, so RAM does not grow with the
+ * number of effects. Starting an effect reads its descriptor from flash once, and Render() then makes one
+ * indirect call per frame, two during a transition.
+ *
+ * Brightness depends on the refresh scan length, so a transition must not change it. Between effects whose
+ * scans fit in one table together, such as two single-colour modes, the transition is a crossfade in time
+ * by OHS2024Badge::PresentCrossfade() and each keeps its own brightness. Wipes and dissolves blend per LED
+ * with a slot per LED, and only run between effects that need more slots.
+ *
+ * @tparam StateSize Largest effect state, see BadgeEffectMaxStateSize().
+ */
+template <uint8_t StateSize>
+class BadgeEffectPlayer {
+   public:
+    BadgeEffectPlayer() = default;
+
+    /**
+     * @brief Set the registry and load the saved mode.
+     *
+     * @param config Player configuration parameters.
+     */
+    void Setup(const BadgeEffectPlayerConfiguration &config);
+
+    /**
+     * @brief Start an effect.
+     *
+     * Starting a mode saves it to EEPROM if it changed.
+     *
+     * @param index Effect index, or badge_effect_resume.
+     * @param now Current time in milliseconds.
+     * @param fade Fade from the running effect with the new effect's transition.
+     */
+    void Start(uint8_t index, uint32_t now, bool fade);
+
+    /**
+     * @brief Start the next mode, or the next effect of an effect outside the modes.
+     */
+    void Next(uint32_t now);
+
+    /**
+     * @brief Start the previous mode, or the next effect of an effect outside the modes.
+     */
+    void Previous(uint32_t now);
+
+    /**
+     * @brief Render one frame of the running effect, blended during a transition.
+     *
+     * Starts the next effect when the running one finishes.
+     *
+     * @param now Current time in milliseconds.
+     * @param pixels Framebuffer with one colour per OHS2024BadgeLED.
+     */
+    void Render(uint32_t now, OHS2024BadgeColor *pixels);
+
+    /**
+     * @brief Queue the rendered frame for display, as a crossfade shared in time during such a transition.
+     *
+     * @param badge Badge whose framebuffer Render() drew into.
+     * @return False if the frame has more distinct colours than the scan has slots.
+     */
+    bool Present(OHS2024Badge &badge) const;
+
+    /**
+     * @brief Index of the running effect.
+     */
+    uint8_t GetIndex() const;
+
+    /**
+     * @brief Refresh scan slots needed by the current frame.
+     *
+     * During a crossfade in time this is 1, the scan frame Present() shares between the two effects, and
+     * during a wipe or dissolve one slot per LED.
+     */
+    uint8_t GetScanLength() const;
+
+   private:
+    BadgeEffectPlayerConfiguration m_config = {};
+
+    // state and update function of each slot: the running effect and the effect fading out
+    alignas(4) uint8_t m_states[2][StateSize] = {};
+    BadgeEffectUpdateFunction m_update[2] = {};
+    uint8_t m_slot = 0;
+
+    uint8_t m_index = 0;
+    uint8_t m_mode = 0;
+    uint8_t m_next = badge_effect_resume;
+    uint8_t m_scan_length = 1;
+    BadgeTransition m_transition = {};
+    bool m_time_shared = false;
+    uint8_t m_outgoing_scan_length = 1;
+
+    // crossfade of the last rendered frame for Present()
+    bool m_crossfade = false;
+    uint8_t m_crossfade_weight = 0;
+    uint8_t m_crossfade_scan_lengths[2] = {};
+    OHS2024BadgeColor m_outgoing[static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs)] = {};
+};
+
+// Inline functions
+// ----------------
+
+template <uint8_t StateSize>
+inline void BadgeEffectPlayer<StateSize>::Setup(const BadgeEffectPlayerConfiguration &config) {
+    m_config = config;
+    if (m_config.num_modes > m_config.num_effects) {
+        m_config.num_modes = m_config.num_effects;
+    }
+    m_mode = m_config.default_mode;
+    if (m_config.saved_mode != nullptr) {
+        // erased EEPROM reads 0xFF
+        const uint8_t mode = eeprom_read_byte(m_config.saved_mode);
+        if (mode < m_config.num_modes) {
+            m_mode = mode;
+        }
+    }
+}
+
+template <uint8_t StateSize>
+inline void BadgeEffectPlayer<StateSize>::Start(uint8_t index, uint32_t now, bool fade) {
+    if (index == badge_effect_resume) {
+        index = m_mode;
+    }
+    if (index >= m_config.num_effects) {
+        return;
+    }
+    BadgeEffect effect;
+    memcpy_P(&effect, &m_config.effects[index], sizeof(effect));
+
+    if (fade && (m_config.transition_ms > 0) && (m_update[m_slot] != nullptr)) {
+        // the running effect keeps its slot and renders underneath until the transition ends
+        m_time_shared = (m_scan_length + effect.scan_length) < OHS2024Badge::max_scan_slots;
+        m_outgoing_scan_length = m_scan_length;
+        m_transition.Start(m_time_shared ? BadgeTransitionType::Crossfade : effect.transition,
+                           m_config.transition_ms, now);
+        m_slot ^= 1;
+    } else {
+        m_transition.Stop();
+    }
+
+    m_index = index;
+    m_next = effect.next;
+    m_scan_length = effect.scan_length;
+    m_update[m_slot] = effect.update;
+    effect.start(m_states[m_slot], now);
+
+    if (index < m_config.num_modes) {
+        m_mode = index;
+        if (m_config.saved_mode != nullptr) {
+            eeprom_update_byte(m_config.saved_mode, index);
+        }
+    }
+}
+
+template <uint8_t StateSize>
+inline void BadgeEffectPlayer<StateSize>::Next(uint32_t now) {
+    const uint8_t num_modes = m_config.num_modes;
+    Start((m_index < num_modes) ? (m_index + 1) % num_modes : m_next, now, true);
+}
+
+template <uint8_t StateSize>
+inline void BadgeEffectPlayer<StateSize>::Previous(uint32_t now) {
+    const uint8_t num_modes = m_config.num_modes;
+    Start((m_index < num_modes) ? (m_index + num_modes - 1) % num_modes : m_next, now, true);
+}
+
+template <uint8_t StateSize>
+inline void BadgeEffectPlayer<StateSize>::Render(uint32_t now, OHS2024BadgeColor *pixels) {
+    if (m_update[m_slot] == nullptr) {
+        return;
+    }
+    const bool running = m_update[m_slot](m_states[m_slot], now, pixels);
+    m_crossfade = false;
+    if (m_transition.Update(now)) {
+        m_update[m_slot ^ 1](m_states[m_slot ^ 1], now, m_outgoing);
+        if (m_time_shared) {
+            // kept apart for Present(), which may follow a Start() of the next effect below
+            m_crossfade = true;
+            m_crossfade_weight = m_transition.GetWeight(OHS2024BadgeLED::HeadRight);
+            m_crossfade_scan_lengths[0] = m_outgoing_scan_length;
+            m_crossfade_scan_lengths[1] = m_scan_length;
+        } else {
+            m_transition.Blend(m_outgoing, pixels);
+        }
+    }
+    if (!running) {
+        const uint8_t scan_length = GetScanLength();
+        Start(m_next, now, true);
+        if (m_transition.IsActive() && m_time_shared && !m_crossfade) {
+            // the frame just rendered starts the crossfade, shown on the 1-slot scan it now runs on
+            memcpy(m_outgoing, pixels, sizeof(m_outgoing));
+            m_crossfade = true;
+            m_crossfade_weight = 0;
+            m_crossfade_scan_lengths[0] = scan_length;
+            m_crossfade_scan_lengths[1] = m_scan_length;
+        }
+    }
+}
+
+template <uint8_t StateSize>
+inline bool BadgeEffectPlayer<StateSize>::Present(OHS2024Badge &badge) const {
+    if (m_crossfade) {
+        return badge.PresentCrossfade(m_outgoing, m_crossfade_scan_lengths[0], m_crossfade_scan_lengths[1],
+                                      m_crossfade_weight);
+    }
+    return badge.Present();
+}
+
+template <uint8_t StateSize>
+inline uint8_t BadgeEffectPlayer<StateSize>::GetIndex() const {
+    return m_index;
+}
+
+template <uint8_t StateSize>
+inline uint8_t BadgeEffectPlayer<StateSize>::GetScanLength() const {
+    if (!m_transition.IsActive()) {
+        return m_scan_length;
+    }
+    return m_time_shared ? 1 : static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs);
+}
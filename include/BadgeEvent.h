@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief Kinds of events posted to the badge main loop.
+ */
+enum class BadgeEventType : uint8_t {
+    None = 0,
+    ButtonDown,
+    ButtonUp,
+    ButtonClick,
+    ButtonDoubleClick,
+    ButtonLongPress,
+    ButtonHoldRepeat,
+    FrameTick,
+    SerialCommand,
+};
+
+/**
+ * @brief Event posted to the badge main loop, small enough to copy in an interrupt.
+ */
+struct BadgeEvent {
+    /**
+     * @brief Kind of event.
+     */
+    BadgeEventType type = BadgeEventType::None;
+    /**
+     * @brief Event data: button index, tick count or command byte depending on type.
+     */
+    uint8_t data = 0;
+};
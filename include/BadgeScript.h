@@ -0,0 +1,346 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "BadgeAnimation.h"
+#include "OHS2024Badge.h"
+
+/**
+ * @brief Operations of a badge script. Each is one opcode byte followed by its operand bytes.
+ */
+enum class BadgeScriptOp : uint8_t {
+    /**
+     * @brief Restart the script from the beginning. No operands.
+     */
+    End = 0,
+    /**
+     * @brief Select the LEDs later operations apply to. Operand: LED mask.
+     */
+    Mask,
+    /**
+     * @brief Set the selected LEDs to a colour. Operands: red, green, blue.
+     */
+    Color,
+    /**
+     * @brief Fade the selected LEDs from their colours to a colour, then continue. Operands: red, green,
+     * blue, ticks.
+     */
+    Fade,
+    /**
+     * @brief Hold for a number of ticks. Operand: ticks.
+     */
+    Wait,
+    /**
+     * @brief Start a loop body run a number of times, 0 for ever. Operand: count.
+     */
+    Loop,
+    /**
+     * @brief End the innermost loop body. No operands.
+     */
+    EndLoop,
+    /**
+     * @brief Select one LED picked at random from a mask. Operand: LED mask.
+     */
+    Random,
+    /**
+     * @brief Number of operations.
+     */
+    NumOps
+};
+
+// Script assembler: each macro expands to the bytes of one operation, so a script is an array initializer
+#define BADGE_SCRIPT_END static_cast<uint8_t>(BadgeScriptOp::End)
+#define BADGE_SCRIPT_MASK(mask) static_cast<uint8_t>(BadgeScriptOp::Mask), static_cast<uint8_t>(mask)
+#define BADGE_SCRIPT_COLOR(r, g, b) static_cast<uint8_t>(BadgeScriptOp::Color), (r), (g), (b)
+#define BADGE_SCRIPT_FADE(r, g, b, ticks) static_cast<uint8_t>(BadgeScriptOp::Fade), (r), (g), (b), (ticks)
+#define BADGE_SCRIPT_WAIT(ticks) static_cast<uint8_t>(BadgeScriptOp::Wait), (ticks)
+#define BADGE_SCRIPT_LOOP(count) static_cast<uint8_t>(BadgeScriptOp::Loop), (count)
+#define BADGE_SCRIPT_END_LOOP static_cast<uint8_t>(BadgeScriptOp::EndLoop)
+#define BADGE_SCRIPT_RANDOM(mask) static_cast<uint8_t>(BadgeScriptOp::Random), static_cast<uint8_t>(mask)
+
+namespace badge_script_detail {
+
+constexpr uint8_t max_loop_depth = 2;
+
+constexpr uint8_t OperandCount(uint8_t op) {
+    switch (static_cast<BadgeScriptOp>(op)) {
+        case BadgeScriptOp::Mask:
+        case BadgeScriptOp::Wait:
+        case BadgeScriptOp::Loop:
+        case BadgeScriptOp::Random:
+            return 1;
+        case BadgeScriptOp::Color:
+            return 3;
+        case BadgeScriptOp::Fade:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+}  // namespace badge_script_detail
+
+/**
+ * @brief Check a script at compile time: use in a static_assert next to the script.
+ *
+ * A valid script has only known operations with all their operands, loops nested at most two deep and
+ * all closed, at least one operation that takes time, and ends with BADGE_SCRIPT_END.
+ */
+template <uint16_t N>
+constexpr bool BadgeScriptIsValid(const uint8_t (&script)[N]) {
+    uint8_t depth = 0;
+    bool timed = false;
+    uint16_t pc = 0;
+    while (pc < N) {
+        const uint8_t op = script[pc];
+        if (op >= static_cast<uint8_t>(BadgeScriptOp::NumOps)) {
+            return false;
+        }
+        const uint16_t next = pc + 1 + badge_script_detail::OperandCount(op);
+        if (next > N) {
+            return false;
+        }
+        switch (static_cast<BadgeScriptOp>(op)) {
+            case BadgeScriptOp::End:
+                return (next == N) && (depth == 0) && timed;
+            case BadgeScriptOp::Mask:
+                if (script[pc + 1] > OHS2024BadgeLEDMask::All) {
+                    return false;
+                }
+                break;
+            case BadgeScriptOp::Random:
+                if ((script[pc + 1] == 0) || (script[pc + 1] > OHS2024BadgeLEDMask::All)) {
+                    return false;
+                }
+                break;
+            case BadgeScriptOp::Fade:
+                timed = timed || (script[pc + 4] > 0);
+                break;
+            case BadgeScriptOp::Wait:
+                timed = timed || (script[pc + 1] > 0);
+                break;
+            case BadgeScriptOp::Loop:
+                if (++depth > badge_script_detail::max_loop_depth) {
+                    return false;
+                }
+                break;
+            case BadgeScriptOp::EndLoop:
+                if (depth-- == 0) {
+                    return false;
+                }
+                break;
+            default:
+                break;
+        }
+        pc = next;
+    }
+    return false;
+}
+
+/**
+ * @brief Run a badge script stored in flash as an animation.
+ *
+ * Scripts are a few bytes per step, built with the BADGE_SCRIPT_* macros and checked with
+ * BadgeScriptIsValid(), so many patterns fit in flash where each would otherwise be compiled code. The
+ * script advances one tick per animation frame. A tick runs operations until one that takes time, at most
+ * max_ops_per_tick of them, and a fade costs one blend per LED, so every tick has a fixed worst-case cost.
+ */
+class BadgeScriptAnimation {
+   public:
+    /**
+     * @brief Most operations run in one tick. A script without waits continues on the next tick.
+     */
+    static constexpr uint8_t max_ops_per_tick = 16;
+
+    BadgeScriptAnimation() = default;
+
+    /**
+     * @brief Set the script.
+     *
+     * @param script Script in PROGMEM.
+     */
+    void Setup(const uint8_t *script);
+
+    /**
+     * @brief Restart the script with all LEDs off.
+     *
+     * @param now Current time in milliseconds.
+     */
+    void Start(uint32_t now);
+
+    /**
+     * @brief Render the frame at a time.
+     *
+     * @param now Current time in milliseconds.
+     * @param pixels Framebuffer with one colour per OHS2024BadgeLED.
+     */
+    void Update(uint32_t now, OHS2024BadgeColor *pixels);
+
+    /**
+     * @brief Advance the script by one tick.
+     */
+    void Tick();
+
+   private:
+    static constexpr uint8_t num_leds = static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs);
+
+    void Execute();
+    uint8_t Fetch();
+
+    const uint8_t *m_script = nullptr;
+
+    OHS2024BadgeColor m_pixels[num_leds] = {};
+    uint16_t m_pc = 0;
+    byte m_mask = OHS2024BadgeLEDMask::All;
+
+    // ticks left of the running wait or fade, and the fade from m_from to m_target
+    uint8_t m_ticks = 0;
+    uint8_t m_fade_ticks = 0;
+    uint16_t m_fade_rate = 0;
+    byte m_fade_mask = OHS2024BadgeLEDMask::None;
+    OHS2024BadgeColor m_from[num_leds] = {};
+    OHS2024BadgeColor m_target = {};
+
+    uint16_t m_loop_pc[badge_script_detail::max_loop_depth] = {};
+    uint8_t m_loop_count[badge_script_detail::max_loop_depth] = {};
+    uint8_t m_loop_depth = 0;
+
+    uint32_t m_frame_time = 0;
+};
+
+// Inline functions
+// ----------------
+
+inline void BadgeScriptAnimation::Setup(const uint8_t *script) { m_script = script; }
+
+inline void BadgeScriptAnimation::Start(uint32_t now) {
+    BadgeAnimationFill(m_pixels, OHS2024BadgeLEDMask::All, OHS2024BadgeColor{});
+    m_pc = 0;
+    m_mask = OHS2024BadgeLEDMask::All;
+    m_ticks = 0;
+    m_fade_mask = OHS2024BadgeLEDMask::None;
+    m_loop_depth = 0;
+    m_frame_time = now;
+    Tick();
+}
+
+inline void BadgeScriptAnimation::Update(uint32_t now, OHS2024BadgeColor *pixels) {
+    for (uint8_t frames = BadgeAnimationFrames(now, m_frame_time); frames > 0; frames--) {
+        Tick();
+    }
+    memcpy(pixels, m_pixels, sizeof(m_pixels));
+}
+
+inline void BadgeScriptAnimation::Tick() {
+    if (m_script == nullptr) {
+        return;
+    }
+    if (m_ticks == 0) {
+        Execute();
+    }
+    if (m_ticks == 0) {
+        return;
+    }
+    m_ticks--;
+    if (m_fade_mask != OHS2024BadgeLEDMask::None) {
+        // the last tick lands exactly on the target
+        const uint8_t weight =
+            (m_ticks == 0) ? UINT8_MAX : (static_cast<uint32_t>(m_fade_ticks - m_ticks) * m_fade_rate) >> 8;
+        for (uint8_t i = 0; i < num_leds; i++) {
+            if (m_fade_mask & (1 << i)) {
+                m_pixels[i] = Blend(m_from[i], m_target, weight);
+            }
+        }
+        if (m_ticks == 0) {
+            m_fade_mask = OHS2024BadgeLEDMask::None;
+        }
+    }
+}
+
+inline void BadgeScriptAnimation::Execute() {
+    for (uint8_t ops = 0; ops < max_ops_per_tick; ops++) {
+        switch (static_cast<BadgeScriptOp>(Fetch())) {
+            case BadgeScriptOp::Mask:
+                m_mask = Fetch();
+                break;
+            case BadgeScriptOp::Color: {
+                const byte r = Fetch();
+                const byte g = Fetch();
+                const byte b = Fetch();
+                BadgeAnimationFill(m_pixels, m_mask, OHS2024BadgeColor{r, g, b});
+                break;
+            }
+            case BadgeScriptOp::Fade: {
+                const byte r = Fetch();
+                const byte g = Fetch();
+                const byte b = Fetch();
+                m_target = {r, g, b};
+                m_ticks = Fetch();
+                if (m_ticks == 0) {
+                    BadgeAnimationFill(m_pixels, m_mask, m_target);
+                    break;
+                }
+                memcpy(m_from, m_pixels, sizeof(m_pixels));
+                m_fade_mask = m_mask;
+                m_fade_ticks = m_ticks;
+                // the only division of a fade, once at its start
+                m_fade_rate = (static_cast<uint16_t>(UINT8_MAX) << 8) / m_ticks;
+                return;
+            }
+            case BadgeScriptOp::Wait:
+                m_ticks = Fetch();
+                if (m_ticks > 0) {
+                    return;
+                }
+                break;
+            case BadgeScriptOp::Loop: {
+                const uint8_t count = Fetch();
+                if (m_loop_depth < badge_script_detail::max_loop_depth) {
+                    m_loop_count[m_loop_depth] = count;
+                    m_loop_pc[m_loop_depth] = m_pc;
+                    m_loop_depth++;
+                }
+                break;
+            }
+            case BadgeScriptOp::EndLoop:
+                if (m_loop_depth > 0) {
+                    uint8_t &count = m_loop_count[m_loop_depth - 1];
+                    // a count of 0 loops for ever
+                    if ((count == 0) || (--count > 0)) {
+                        m_pc = m_loop_pc[m_loop_depth - 1];
+                    } else {
+                        m_loop_depth--;
+                    }
+                }
+                break;
+            case BadgeScriptOp::Random: {
+                const byte mask = Fetch();
+                // pick the n-th set bit of the mask, n at random
+                uint8_t n = 0;
+                for (uint8_t i = 0; i < num_leds; i++) {
+                    n += (mask >> i) & 1;
+                }
+                uint8_t pick = (n > 0) ? random(n) : 0;
+                m_mask = OHS2024BadgeLEDMask::None;
+                for (uint8_t i = 0; i < num_leds; i++) {
+                    if ((mask & (1 << i)) && (pick-- == 0)) {
+                        m_mask = 1 << i;
+                        break;
+                    }
+                }
+                break;
+            }
+            default:
+                // End, or an invalid opcode from a script that was not checked
+                m_pc = 0;
+                m_loop_depth = 0;
+                break;
+        }
+    }
+}
+
+inline uint8_t BadgeScriptAnimation::Fetch() {
+    const uint8_t value = pgm_read_byte(&m_script[m_pc]);
+    m_pc++;
+    return value;
+}
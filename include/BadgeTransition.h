@@ -0,0 +1,163 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "BadgeColor.h"
+#include "OHS2024Badge.h"
+
+/**
+ * @brief Ways a BadgeTransition hands the LEDs over from the outgoing to the incoming frame.
+ */
+enum class BadgeTransitionType : uint8_t {
+    /**
+     * @brief All LEDs fade together.
+     */
+    Crossfade = 0,
+    /**
+     * @brief LEDs fade in turn from the top of the head down to the body.
+     */
+    Wipe,
+    /**
+     * @brief LEDs fade in a random order.
+     */
+    Dissolve,
+};
+
+/**
+ * @brief Blend from an outgoing to an incoming frame over a fixed duration.
+ *
+ * The sketch renders the outgoing and incoming animations into two framebuffers on every frame, so both
+ * keep running during the transition, then calls Update() and Blend(). A crossfade fades all LEDs over
+ * the whole duration. For a wipe or dissolve each LED fades over half of it, starting at an offset fixed
+ * by Start() from its position or at random. Update() turns the elapsed time into one 8-bit blend weight
+ * per LED with a multiply, so Blend() is a Blend8() per channel and there is no division per frame.
+ */
+class BadgeTransition {
+   public:
+    BadgeTransition() = default;
+
+    /**
+     * @brief Start a transition.
+     *
+     * @param type How LEDs are handed over.
+     * @param duration_ms Duration in milliseconds. 0 ends the transition on the next Update().
+     * @param now Current time in milliseconds.
+     */
+    void Start(BadgeTransitionType type, uint16_t duration_ms, uint32_t now);
+
+    /**
+     * @brief Stop the transition, showing only the incoming frame.
+     */
+    void Stop();
+
+    /**
+     * @brief Check if a transition is running.
+     */
+    bool IsActive() const;
+
+    /**
+     * @brief Compute the blend weights at a time, ending the transition once every LED is fully incoming.
+     *
+     * @param now Current time in milliseconds.
+     * @return False if the transition has ended and the outgoing frame is no longer needed.
+     */
+    bool Update(uint32_t now);
+
+    /**
+     * @brief Blend the outgoing frame into the incoming frame with the weights of the last Update().
+     *
+     * @param outgoing Framebuffer rendered by the outgoing animation.
+     * @param pixels Framebuffer rendered by the incoming animation, overwritten with the blend.
+     */
+    void Blend(const OHS2024BadgeColor *outgoing, OHS2024BadgeColor *pixels) const;
+
+    /**
+     * @brief Weight of the incoming frame on one LED, 0 to 255.
+     */
+    uint8_t GetWeight(OHS2024BadgeLED led) const;
+
+   private:
+    static constexpr uint8_t num_leds = static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs);
+
+    uint8_t m_offsets[num_leds] = {};
+    uint8_t m_weights[num_leds] = {};
+    BadgeTransitionType m_type = BadgeTransitionType::Crossfade;
+    uint32_t m_start_time = 0;
+    uint16_t m_duration_ms = 0;
+    uint32_t m_rate = 0;
+    bool m_active = false;
+};
+
+// Inline functions
+// ----------------
+
+inline void BadgeTransition::Start(BadgeTransitionType type, uint16_t duration_ms, uint32_t now) {
+    // start of each LED's fade along the wipe, from the top of the head down to the body
+    static const uint8_t wipe_offsets[num_leds] PROGMEM = {
+        64,   // HeadRight
+        0,    // HeadTop
+        64,   // HeadLeft
+        128,  // EyeRight
+        128,  // EyeLeft
+        192,  // BodyRight
+        255,  // BodyCenter
+        192,  // BodyLeft
+    };
+
+    m_type = type;
+    for (uint8_t i = 0; i < num_leds; i++) {
+        switch (type) {
+            case BadgeTransitionType::Wipe:
+                m_offsets[i] = pgm_read_byte(&wipe_offsets[i]);
+                break;
+            case BadgeTransitionType::Dissolve:
+                m_offsets[i] = random(256);
+                break;
+            default:
+                m_offsets[i] = 0;
+                break;
+        }
+        m_weights[i] = 0;
+    }
+    m_start_time = now;
+    m_duration_ms = duration_ms;
+    // progress in 1/256 of the duration per millisecond, in 16.16 fixed point
+    m_rate = (duration_ms > 0) ? (1UL << 24) / duration_ms : 0;
+    m_active = true;
+}
+
+inline void BadgeTransition::Stop() { m_active = false; }
+
+inline bool BadgeTransition::IsActive() const { return m_active; }
+
+inline bool BadgeTransition::Update(uint32_t now) {
+    if (!m_active) {
+        return false;
+    }
+    const uint32_t elapsed = now - m_start_time;
+    if (elapsed >= m_duration_ms) {
+        m_active = false;
+        return false;
+    }
+    // progress 0 to 255 over the duration, doubled so each LED fades over half of it
+    const uint16_t progress = (elapsed * m_rate) >> 16;
+    for (uint8_t i = 0; i < num_leds; i++) {
+        if (m_type == BadgeTransitionType::Crossfade) {
+            m_weights[i] = progress;
+            continue;
+        }
+        const int16_t weight = static_cast<int16_t>(progress * 2) - m_offsets[i];
+        m_weights[i] = (weight <= 0) ? 0 : ((weight >= UINT8_MAX) ? UINT8_MAX : weight);
+    }
+    return true;
+}
+
+inline void BadgeTransition::Blend(const OHS2024BadgeColor *outgoing, OHS2024BadgeColor *pixels) const {
+    for (uint8_t i = 0; i < num_leds; i++) {
+        pixels[i] = ::Blend(outgoing[i], pixels[i], m_weights[i]);
+    }
+}
+
+inline uint8_t BadgeTransition::GetWeight(OHS2024BadgeLED led) const {
+    return m_weights[static_cast<uint8_t>(led)];
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief Gestures recognized from a debounced button.
+ */
+enum class ButtonGestureEvent : uint8_t {
+    None = 0,
+    Click,
+    DoubleClick,
+    LongPress,
+    HoldRepeat,
+};
+
+/**
+ * @brief Configuration for button gestures
+ */
+struct ButtonGestureConfiguration {
+    /**
+     * @brief Maximum time from release to the second press of a double click, in milliseconds. Set to 0
+     * to disable double clicks, so clicks are reported on release without waiting.
+     */
+    uint16_t double_click_ms = 300;
+    /**
+     * @brief Time the button must be held to report a long press, in milliseconds.
+     */
+    uint16_t long_press_ms = 600;
+    /**
+     * @brief Interval between hold repeats after a long press, in milliseconds. Set to 0 to disable.
+     */
+    uint16_t repeat_interval_ms = 150;
+};
+
+/**
+ * @brief Recognize click, double click, long press and hold repeat from a debounced button state.
+ *
+ * Update() is a small state machine with constant cost per call, so it can run on every timer tick or
+ * frame without blocking.
+ */
+class ButtonGesture {
+   public:
+    ButtonGesture() = default;
+
+    /**
+     * @brief Configure gesture thresholds.
+     *
+     * @param config Gesture configuration parameters.
+     */
+    void Setup(const ButtonGestureConfiguration &config);
+
+    /**
+     * @brief Forget any gesture in progress.
+     */
+    void Reset();
+
+    /**
+     * @brief Update with the current debounced state of the button.
+     *
+     * @param pressed Debounced button state.
+     * @param now_ms Current time in milliseconds.
+     * @return Gesture recognized by this update, or None.
+     */
+    ButtonGestureEvent Update(bool pressed, uint32_t now_ms);
+
+   private:
+    enum class State : uint8_t {
+        Idle,
+        Pressed,
+        WaitSecondPress,
+        SecondPress,
+        Held,
+    };
+
+    ButtonGestureConfiguration m_config = {};
+
+    State m_state = State::Idle;
+    uint32_t m_state_time = 0;
+};
+
+// Inline functions
+// ----------------
+
+inline void ButtonGesture::Setup(const ButtonGestureConfiguration &config) {
+    m_config = config;
+    Reset();
+}
+
+inline void ButtonGesture::Reset() {
+    m_state = State::Idle;
+    m_state_time = 0;
+}
+
+inline ButtonGestureEvent ButtonGesture::Update(bool pressed, uint32_t now_ms) {
+    const uint32_t elapsed = now_ms - m_state_time;
+    switch (m_state) {
+        case State::Idle:
+            if (pressed) {
+                m_state = State::Pressed;
+                m_state_time = now_ms;
+            }
+            break;
+
+        case State::Pressed:
+            if (!pressed) {
+                if (m_config.double_click_ms == 0) {
+                    m_state = State::Idle;
+                    return ButtonGestureEvent::Click;
+                }
+                m_state = State::WaitSecondPress;
+                m_state_time = now_ms;
+            } else if (elapsed >= m_config.long_press_ms) {
+                m_state = State::Held;
+                m_state_time = now_ms;
+                return ButtonGestureEvent::LongPress;
+            }
+            break;
+
+        case State::WaitSecondPress:
+            if (pressed) {
+                m_state = State::SecondPress;
+                return ButtonGestureEvent::DoubleClick;
+            }
+            if (elapsed >= m_config.double_click_ms) {
+                m_state = State::Idle;
+                return ButtonGestureEvent::Click;
+            }
+            break;
+
+        case State::SecondPress:
+            if (!pressed) {
+                m_state = State::Idle;
+            }
+            break;
+
+        case State::Held:
+            if (!pressed) {
+                m_state = State::Idle;
+            } else if ((m_config.repeat_interval_ms > 0) && (elapsed >= m_config.repeat_interval_ms)) {
+                // advance by the interval so repeats do not drift with the update rate
+                m_state_time += m_config.repeat_interval_ms;
+                return ButtonGestureEvent::HoldRepeat;
+            }
+            break;
+
+        default:
+            break;
+    }
+    return ButtonGestureEvent::None;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief Transfer curves from an 8-bit colour value to LED duty.
+ */
+enum class ColorCurve : uint8_t {
+    /**
+     * @brief Duty proportional to value, as analogWrite does.
+     */
+    Linear = 0,
+    /**
+     * @brief Power law with exponent 2.2.
+     */
+    Gamma22,
+    /**
+     * @brief CIE 1931 lightness: equal value steps look like equal brightness steps.
+     */
+    Cie1931,
+};
+
+/**
+ * @brief Duty for each 8-bit value of a curve, 0 to 65535.
+ */
+struct ColorCurveTable {
+    uint16_t values[256];
+};
+
+namespace color_curve_detail {
+
+// x^(1/5) for x in [0, 1] by Newton's method, usable in constant expressions
+constexpr double FifthRoot(double x) {
+    if (x <= 0.0) {
+        return 0.0;
+    }
+    double y = 1.0;
+    for (uint8_t i = 0; i < 64; i++) {
+        const double y4 = y * y * y * y;
+        y = (4.0 * y + x / y4) / 5.0;
+    }
+    return y;
+}
+
+constexpr double Evaluate(ColorCurve curve, double x) {
+    switch (curve) {
+        case ColorCurve::Gamma22:
+            return x * x * FifthRoot(x);
+        case ColorCurve::Cie1931: {
+            const double lightness = 100.0 * x;
+            if (lightness <= 8.0) {
+                return lightness / 903.3;
+            }
+            const double t = (lightness + 16.0) / 116.0;
+            return t * t * t;
+        }
+        default:
+            return x;
+    }
+}
+
+constexpr ColorCurveTable MakeTable(ColorCurve curve) {
+    ColorCurveTable table = {};
+    for (uint16_t i = 0; i < 256; i++) {
+        const double y = Evaluate(curve, i / 255.0);
+        table.values[i] = static_cast<uint16_t>(y * 65535.0 + 0.5);
+    }
+    return table;
+}
+
+constexpr bool IsValid(const ColorCurveTable &table) {
+    if ((table.values[0] != 0) || (table.values[255] != UINT16_MAX)) {
+        return false;
+    }
+    for (uint16_t i = 1; i < 256; i++) {
+        if (table.values[i] < table.values[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace color_curve_detail
+
+/**
+ * @brief Gamma 2.2 table, generated at compile time and stored in flash.
+ */
+inline constexpr ColorCurveTable color_curve_gamma22 PROGMEM =
+    color_curve_detail::MakeTable(ColorCurve::Gamma22);
+
+/**
+ * @brief CIE 1931 lightness table, generated at compile time and stored in flash.
+ */
+inline constexpr ColorCurveTable color_curve_cie1931 PROGMEM =
+    color_curve_detail::MakeTable(ColorCurve::Cie1931);
+
+static_assert(color_curve_detail::IsValid(color_curve_gamma22), "gamma 2.2 table must rise from 0 to 65535");
+static_assert(color_curve_detail::IsValid(color_curve_cie1931), "CIE 1931 table must rise from 0 to 65535");
+
+/**
+ * @brief Look up the duty of a colour value on a curve.
+ *
+ * @param curve Transfer curve.
+ * @param value 8-bit colour value.
+ * @return Duty from 0 to 65535.
+ */
+inline uint16_t ColorCurveLookup(ColorCurve curve, uint8_t value) {
+    switch (curve) {
+        case ColorCurve::Gamma22:
+            return pgm_read_word(&color_curve_gamma22.values[value]);
+        case ColorCurve::Cie1931:
+            return pgm_read_word(&color_curve_cie1931.values[value]);
+        default:
+            return static_cast<uint16_t>(value) * 257;
+    }
+}
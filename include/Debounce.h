@@ -1,7 +1,7 @@
-
 #pragma once
 
 #include <Arduino.h>
+#include <util/atomic.h>
 
 /**
  * @brief Configuration for debounce
@@ -27,6 +27,10 @@ struct DebounceConfiguration {
 
 /**
  * @brief Debounce digital inputs.
+ *
+ * Either poll Update() from the main loop, or call Tick() from a periodic timer interrupt and read edges
+ * with TakeActivated()/TakeDeactivated(). In tick mode the pin can also wake the debounce through its
+ * pin-change interrupt, so ticks cost a single flag check while the input is idle.
  */
 class Debounce {
    public:
@@ -56,12 +60,59 @@ class Debounce {
      */
     bool Update();
 
+    /**
+     * @brief Take one measurement without checking time. Call from a periodic timer interrupt.
+     *
+     * The tick period replaces delay_microseconds. With wake on change enabled, no measurement is taken
+     * while the input is idle.
+     *
+     * @return Current state of pin.
+     */
+    bool Tick();
+
+    /**
+     * @brief Enable the pin-change interrupt of the pin and only measure on ticks after a change.
+     *
+     * The sketch must call Wake() from the pin-change interrupt vector of the pin's port.
+     */
+    void EnableWakeOnChange();
+
+    /**
+     * @brief Resume measurements on ticks. Call from the pin-change interrupt.
+     */
+    void Wake();
+
+    /**
+     * @brief Get current state of pin without taking a measurement.
+     */
+    bool GetState() const;
+
+    /**
+     * @brief Check if state changed to true since the last call, and clear the event.
+     */
+    bool TakeActivated();
+
+    /**
+     * @brief Check if state changed to false since the last call, and clear the event.
+     */
+    bool TakeDeactivated();
+
    private:
+    static constexpr uint8_t event_activated = 0x01;
+    static constexpr uint8_t event_deactivated = 0x02;
+
+    void Measure();
+    bool TakeEvent(uint8_t event);
+
     DebounceConfiguration m_config = {};
 
-    bool m_state = 0;
+    volatile bool m_state = 0;
     uint16_t m_trigger_count = 0;
     uint32_t m_last_update_time = 0;
+
+    volatile uint8_t m_events = 0;
+    bool m_wake_on_change = false;
+    volatile bool m_awake = true;
 };
 
 // Inline functions
@@ -73,8 +124,12 @@ inline void Debounce::Setup(const DebounceConfiguration &config) {
 }
 
 inline void Debounce::Reset(bool pin_state) {
-    m_state = pin_state;
-    m_trigger_count = 0;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        m_state = pin_state;
+        m_trigger_count = 0;
+        m_events = 0;
+        m_awake = true;
+    }
     m_last_update_time = micros();
 }
 
@@ -84,33 +139,81 @@ inline bool Debounce::Update() {
         // update time
         m_last_update_time = now;
         // take measurement
-        bool measured_state = (m_config.polarity != digitalRead(m_config.pin));
-        // run debounce
-        if (m_state) {
-            // state is high, check if low
-            if (!measured_state) {
-                m_trigger_count++;
-                if (m_trigger_count >= m_config.max_count) {
-                    // change state
-                    m_state = false;
-                    m_trigger_count = 0;
-                }
-            } else if (m_trigger_count > 0) {
-                m_trigger_count--;
+        Measure();
+    }
+    return m_state;
+}
+
+inline bool Debounce::Tick() {
+    if (m_wake_on_change && !m_awake) {
+        return m_state;
+    }
+    Measure();
+    if (m_wake_on_change && (m_trigger_count == 0)) {
+        // settled: sleep until the next pin change
+        m_awake = false;
+    }
+    return m_state;
+}
+
+inline void Debounce::EnableWakeOnChange() {
+    volatile uint8_t *pcicr = digitalPinToPCICR(m_config.pin);
+    if (pcicr == nullptr) {
+        return;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        m_wake_on_change = true;
+        m_awake = true;
+        *digitalPinToPCMSK(m_config.pin) |= _BV(digitalPinToPCMSKbit(m_config.pin));
+        *pcicr |= _BV(digitalPinToPCICRbit(m_config.pin));
+    }
+}
+
+inline void Debounce::Wake() { m_awake = true; }
+
+inline bool Debounce::GetState() const { return m_state; }
+
+inline bool Debounce::TakeActivated() { return TakeEvent(event_activated); }
+
+inline bool Debounce::TakeDeactivated() { return TakeEvent(event_deactivated); }
+
+inline bool Debounce::TakeEvent(uint8_t event) {
+    bool taken = false;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        taken = (m_events & event) != 0;
+        m_events &= ~event;
+    }
+    return taken;
+}
+
+inline void Debounce::Measure() {
+    bool measured_state = (m_config.polarity != digitalRead(m_config.pin));
+    // run debounce
+    if (m_state) {
+        // state is high, check if low
+        if (!measured_state) {
+            m_trigger_count++;
+            if (m_trigger_count >= m_config.max_count) {
+                // change state
+                m_state = false;
+                m_trigger_count = 0;
+                m_events |= event_deactivated;
             }
-        } else {
-            // state is low, check if high
-            if (measured_state) {
-                m_trigger_count++;
-                if (m_trigger_count >= m_config.max_count) {
-                    // change state
-                    m_state = true;
-                    m_trigger_count = 0;
-                }
-            } else if (m_trigger_count > 0) {
-                m_trigger_count--;
+        } else if (m_trigger_count > 0) {
+            m_trigger_count--;
+        }
+    } else {
+        // state is low, check if high
+        if (measured_state) {
+            m_trigger_count++;
+            if (m_trigger_count >= m_config.max_count) {
+                // change state
+                m_state = true;
+                m_trigger_count = 0;
+                m_events |= event_activated;
             }
+        } else if (m_trigger_count > 0) {
+            m_trigger_count--;
         }
     }
-    return m_state;
 }
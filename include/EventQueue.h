@@ -0,0 +1,97 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief Fixed-capacity single-producer/single-consumer queue, for passing events from an interrupt to
+ * the main loop.
+ *
+ * The producer only writes the head index and the consumer only writes the tail index. Both are single
+ * bytes, so on AVR every index access is atomic and neither side ever disables interrupts. Indices run
+ * freely and wrap at 256, which is why the capacity must be a power of two.
+ *
+ * @tparam T Event type, copied in and out of the queue.
+ * @tparam Capacity Maximum number of queued events. Power of two, at most 128.
+ */
+template <typename T, uint8_t Capacity>
+class EventQueue {
+    static_assert((Capacity > 0) && (Capacity <= 128) && ((Capacity & (Capacity - 1)) == 0),
+                  "Capacity must be a power of two between 1 and 128");
+
+   public:
+    EventQueue() = default;
+
+    /**
+     * @brief Add an event. Call from the producer only.
+     *
+     * @param event Event to add.
+     * @return False if the queue was full and the event was dropped.
+     */
+    bool Push(const T &event);
+
+    /**
+     * @brief Remove the oldest event. Call from the consumer only.
+     *
+     * @param event Receives the event.
+     * @return False if the queue was empty.
+     */
+    bool Pop(T &event);
+
+    /**
+     * @brief Check if the queue has no events.
+     */
+    bool IsEmpty() const;
+
+    /**
+     * @brief Number of events dropped because the queue was full.
+     */
+    uint8_t GetDropped() const;
+
+   private:
+    T m_buffer[Capacity] = {};
+    uint8_t m_head = 0;
+    uint8_t m_tail = 0;
+    uint8_t m_dropped = 0;
+};
+
+// Inline functions
+// ----------------
+
+template <typename T, uint8_t Capacity>
+inline bool EventQueue<T, Capacity>::Push(const T &event) {
+    const uint8_t head = m_head;
+    const uint8_t tail = __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE);
+    if (static_cast<uint8_t>(head - tail) >= Capacity) {
+        if (m_dropped < UINT8_MAX) {
+            m_dropped++;
+        }
+        return false;
+    }
+    m_buffer[head & (Capacity - 1)] = event;
+    // publish the event after it is written
+    __atomic_store_n(&m_head, static_cast<uint8_t>(head + 1), __ATOMIC_RELEASE);
+    return true;
+}
+
+template <typename T, uint8_t Capacity>
+inline bool EventQueue<T, Capacity>::Pop(T &event) {
+    const uint8_t tail = m_tail;
+    const uint8_t head = __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return false;
+    }
+    event = m_buffer[tail & (Capacity - 1)];
+    // release the slot after it is read
+    __atomic_store_n(&m_tail, static_cast<uint8_t>(tail + 1), __ATOMIC_RELEASE);
+    return true;
+}
+
+template <typename T, uint8_t Capacity>
+inline bool EventQueue<T, Capacity>::IsEmpty() const {
+    return __atomic_load_n(&m_head, __ATOMIC_ACQUIRE) == __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE);
+}
+
+template <typename T, uint8_t Capacity>
+inline uint8_t EventQueue<T, Capacity>::GetDropped() const {
+    return __atomic_load_n(&m_dropped, __ATOMIC_RELAXED);
+}
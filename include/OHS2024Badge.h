@@ -1,6 +1,10 @@
-
+#pragma once
 
 #include <Arduino.h>
+#include <util/atomic.h>
+
+#include "BadgeColor.h"
+#include "ColorCurve.h"
 
 enum class OHS2024BadgeLED
 {
@@ -15,6 +19,30 @@ enum class OHS2024BadgeLED
     NumLEDs
 };
 
+/**
+ * @brief LED bit masks for SetLEDMask. Bit i is OHS2024BadgeLED i.
+ */
+struct OHS2024BadgeLEDMask
+{
+    static constexpr byte Of(const OHS2024BadgeLED led) { return 1 << static_cast<uint8_t>(led); }
+
+    static constexpr byte None = 0x00;
+
+    static constexpr byte HeadRight = 1 << static_cast<uint8_t>(OHS2024BadgeLED::HeadRight);
+    static constexpr byte HeadTop = 1 << static_cast<uint8_t>(OHS2024BadgeLED::HeadTop);
+    static constexpr byte HeadLeft = 1 << static_cast<uint8_t>(OHS2024BadgeLED::HeadLeft);
+    static constexpr byte EyeRight = 1 << static_cast<uint8_t>(OHS2024BadgeLED::EyeRight);
+    static constexpr byte EyeLeft = 1 << static_cast<uint8_t>(OHS2024BadgeLED::EyeLeft);
+    static constexpr byte BodyRight = 1 << static_cast<uint8_t>(OHS2024BadgeLED::BodyRight);
+    static constexpr byte BodyCenter = 1 << static_cast<uint8_t>(OHS2024BadgeLED::BodyCenter);
+    static constexpr byte BodyLeft = 1 << static_cast<uint8_t>(OHS2024BadgeLED::BodyLeft);
+
+    static constexpr byte Head = HeadRight | HeadTop | HeadLeft;
+    static constexpr byte Eyes = EyeRight | EyeLeft;
+    static constexpr byte Body = BodyRight | BodyCenter | BodyLeft;
+    static constexpr byte All = Head | Eyes | Body;
+};
+
 struct OHS2024BadgePins
 {
     byte head_right = 23;
@@ -33,6 +61,100 @@ struct OHS2024BadgePins
     byte pwm_blue = 0;
 };
 
+/**
+ * @brief Anode pins resolved to output registers and grouped by port.
+ *
+ * Resolving once lets writes skip the digitalWrite lookup, and grouping lets any LED pattern be applied
+ * with one write per port.
+ */
+struct OHS2024BadgePortMap
+{
+    static constexpr uint8_t max_ports = 4;
+    static constexpr uint8_t no_port = 0xFF;
+
+    volatile uint8_t *out[max_ports] = {};
+    uint8_t anode_mask[max_ports] = {};
+    uint8_t num_ports = 0;
+
+    uint8_t led_port[static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs)] = {};
+    uint8_t led_mask[static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs)] = {};
+};
+
+/**
+ * @brief Colour channel pin resolved to the registers analogWrite would use.
+ *
+ * A pin on a timer gets its compare register and the COM bit that connects it; a pin without PWM gets its
+ * output register and bit, and is switched on or off at half scale as analogWrite does.
+ */
+struct OHS2024BadgeChannel
+{
+    volatile uint8_t *ocr8 = nullptr;
+    volatile uint16_t *ocr16 = nullptr;
+    volatile uint8_t *tccr = nullptr;
+    uint8_t com = 0;
+    volatile uint8_t *out = nullptr;
+    uint8_t mask = 0;
+};
+
+/**
+ * @brief 8-bit RGB colour of one LED in the framebuffer.
+ */
+using OHS2024BadgeColor = CRGB;
+
+/**
+ * @brief Correction from framebuffer colour to LED duty, applied by SetColor and Present.
+ *
+ * Each channel has its own transfer curve, then is scaled by its white balance so that full white looks
+ * neutral. The result is 16-bit duty. While refresh runs, the fraction below the PWM step can be
+ * shown by temporal dithering: each slot carries its rounding error to the next scan frame, so the
+ * average over frames matches the 16-bit duty and fades stay smooth near black. The default is linear
+ * with no scaling and no dithering, which writes colours unchanged.
+ */
+struct OHS2024BadgeColorCorrection
+{
+    ColorCurve curve_red = ColorCurve::Linear;
+    ColorCurve curve_green = ColorCurve::Linear;
+    ColorCurve curve_blue = ColorCurve::Linear;
+
+    byte white_red = 255;
+    byte white_green = 255;
+    byte white_blue = 255;
+
+    // fraction bits below the PWM step shown by temporal dithering in the refresh scan, 0 to 8
+    byte dither_bits = 0;
+};
+
+/**
+ * @brief 16-bit duty of the colour channels in 8.8 fixed point: the high byte is the PWM value.
+ */
+struct OHS2024BadgeDuty
+{
+    uint16_t r = 0;
+    uint16_t g = 0;
+    uint16_t b = 0;
+};
+
+inline bool operator==(const OHS2024BadgeDuty &a, const OHS2024BadgeDuty &b)
+{
+    return (a.r == b.r) && (a.g == b.g) && (a.b == b.b);
+}
+
+inline bool operator!=(const OHS2024BadgeDuty &a, const OHS2024BadgeDuty &b)
+{
+    return !(a == b);
+}
+
+/**
+ * @brief One slot of the refresh scan: duty loaded and anode bits lit while the slot is active.
+ */
+struct OHS2024BadgeScanSlot
+{
+    OHS2024BadgeDuty duty = {};
+    uint8_t port_bits[OHS2024BadgePortMap::max_ports] = {};
+    // OCR2A while the slot is active, it lasts compare + 1 Timer2 counts
+    uint8_t compare = 0;
+};
+
 class OHS2024Badge
 {
 public:
@@ -42,6 +164,26 @@ public:
 
     inline void SetColor(byte red, byte green, byte blue);
 
+    /**
+     * @brief Set the curves and white balance applied to colours. Takes effect on the next SetColor or
+     * Present().
+     */
+    inline void SetColorCorrection(const OHS2024BadgeColorCorrection &correction);
+
+    /**
+     * @brief Light exactly the LEDs in a mask and turn off all others.
+     *
+     * The pattern is applied with one write per port, so there are no intermediate frames.
+     *
+     * @param mask LED mask, bit i is OHS2024BadgeLED i. See OHS2024BadgeLEDMask.
+     */
+    inline void SetLEDMask(byte mask);
+
+    /**
+     * @brief Get mask of LEDs currently lit.
+     */
+    inline byte GetLEDMask() const;
+
     inline void TurnOnLED(OHS2024BadgeLED led);
     inline void TurnOffLED(OHS2024BadgeLED led);
 
@@ -54,8 +196,173 @@ public:
     inline void TurnOnBodyLEDs();
     inline void TurnOffBodyLEDs();
 
+    /**
+     * @brief Target for the worst-case cost of Refresh() in CPU cycles.
+     */
+    static constexpr uint16_t refresh_cycle_budget = 512;
+
+    /**
+     * @brief Slots of a scan table: one per LED, or the colours of both frames of a PresentCrossfade() and a
+     * blank slot.
+     */
+    static constexpr uint8_t max_scan_slots = static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs) + 2;
+
+    /**
+     * @brief Drive the colour channels from Timer3/Timer4 fast PWM instead of analogWrite.
+     *
+     * Both timers run from the undivided clock with ICR as TOP, so the PWM frequency is F_CPU / 2^bits:
+     * 31.25 kHz at 8 bits, 7.8 kHz at 10 bits at 8 MHz. They are started together through GTCCR so the
+     * three channels stay in phase, and duty is written straight to OCR3B (red), OCR4A (green) and OCR3A
+     * (blue). Only on the ATmega328PB with the default PWM pins; does nothing elsewhere.
+     *
+     * @param bits PWM resolution in bits, 8 to 16.
+     */
+    inline void StartHardwarePWM(uint8_t bits = 10);
+
+    /**
+     * @brief Start multiplexed refresh of the framebuffer, driven by the Timer2 compare match interrupt.
+     *
+     * Each scan frame is split into scan_length slots. Every distinct framebuffer colour takes one slot,
+     * and its LEDs are lit only while that colour is loaded into the shared cathodes, so every LED is lit
+     * 1/scan_length of the time regardless of content. The sketch must call Refresh() from
+     * ISR(TIMER2_COMPA_vect). While refresh runs it owns the anodes and colour channels: draw frames with
+     * BeginFrame()/Present() instead of calling SetLEDMask or SetColor. The colour channel timer outputs are
+     * connected here once, so each slot only writes their compare registers.
+     *
+     * @param refresh_hz Scan frames per second.
+     * @param scan_length Slots per scan frame. Must be at least the number of distinct colours shown.
+     */
+    inline void StartRefresh(uint16_t refresh_hz,
+                             uint8_t scan_length = static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs));
+
+    /**
+     * @brief Stop multiplexed refresh and restore the LED mask and colour set before it started.
+     */
+    inline void StopRefresh();
+
+    /**
+     * @brief Start drawing a frame.
+     *
+     * The framebuffer is only read by Present(), never by the refresh interrupt, so drawing may take
+     * longer than a scan slot. It keeps the previous frame's content.
+     *
+     * @return Framebuffer with one colour per OHS2024BadgeLED.
+     */
+    inline OHS2024BadgeColor *BeginFrame();
+
+    /**
+     * @brief Set the framebuffer colour of one LED. Takes effect on the next Present().
+     */
+    inline void SetPixel(OHS2024BadgeLED led, const OHS2024BadgeColor &color);
+
+    /**
+     * @brief Set the framebuffer colour of all LEDs in a mask. Takes effect on the next Present().
+     */
+    inline void SetPixels(byte mask, const OHS2024BadgeColor &color);
+
+    /**
+     * @brief Get the framebuffer colour of one LED.
+     */
+    inline OHS2024BadgeColor GetPixel(OHS2024BadgeLED led) const;
+
+    /**
+     * @brief Build the back scan table from the framebuffer and queue it for display.
+     *
+     * The refresh interrupt swaps the back and front tables at the next scan frame boundary, so a frame is
+     * never shown half old and half new. If the previously presented frame had not been swapped in yet it
+     * is replaced, and counted as dropped while refresh runs.
+     *
+     * @return False if the framebuffer has more distinct colours than the scan length, in which case the
+     * LEDs with the extra colours stay dark.
+     */
+    inline bool Present();
+
+    /**
+     * @brief Build the back scan table as a crossfade from an outgoing frame to the framebuffer and queue it.
+     *
+     * Instead of blending colours, the two frames share one slot of the running scan in time: each colour
+     * of the outgoing frame is shown for (255 - weight) / 255 / outgoing_scan of it, each colour of the
+     * framebuffer for weight / 255 / incoming_scan, and the rest is blank. Every LED then shows the
+     * weighted sum of what it shows in either frame on its own scan, so brightness is continuous from
+     * weight 0 to 255 and into the incoming scan, and two single-colour frames crossfade at full
+     * brightness. Run the refresh with scan_length 1 while crossfading so a scan frame lasts one slot.
+     *
+     * @param outgoing Frame shown at weight 0, one colour per OHS2024BadgeLED.
+     * @param outgoing_scan Scan length the outgoing frame is shown with on its own.
+     * @param incoming_scan Scan length the framebuffer is shown with on its own.
+     * @param weight Share of the framebuffer, 0 to 255.
+     * @return False if either frame has more distinct colours than its scan length, or both together more
+     * than max_scan_slots - 1, in which case the LEDs with the extra colours stay dark.
+     */
+    inline bool PresentCrossfade(const OHS2024BadgeColor *outgoing, uint8_t outgoing_scan, uint8_t incoming_scan,
+                                 uint8_t weight);
+
+    /**
+     * @brief Check if a presented frame is still waiting for the next scan frame boundary.
+     */
+    inline bool IsPresentPending() const;
+
+    /**
+     * @brief Frames replaced by a newer Present() before they were displayed, since StartRefresh().
+     *
+     * Only counted while refresh runs: before StartRefresh() nothing takes pending frames, so replacing
+     * one drops nothing that could have been shown.
+     */
+    inline uint16_t GetDroppedFrames() const;
+
+    /**
+     * @brief Advance the refresh scan by one slot. Call from ISR(TIMER2_COMPA_vect).
+     */
+    inline void Refresh();
+
+    /**
+     * @brief Worst-case cost of Refresh() since StartRefresh(), in CPU cycles.
+     *
+     * Coarse: it is read from TCNT2 on the way out of Refresh(), so it counts from the compare match,
+     * includes the interrupt entry, and resolves only to one Timer2 prescaler step (1 to 1024 cycles,
+     * depending on the refresh rate). Use it to check a slot against refresh_cycle_budget, not to time
+     * small changes.
+     */
+    inline uint16_t GetRefreshCycles() const;
+
 private:
+    inline void AddAnode(OHS2024BadgeLED led, byte pin);
+    static inline void ResolveChannel(byte pin, OHS2024BadgeChannel &channel);
+    static inline void WriteChannel(const OHS2024BadgeChannel &channel, uint8_t value);
+    inline uint8_t TakeBackTable();
+    inline uint8_t AddSlots(const OHS2024BadgeColor *pixels, OHS2024BadgeScanSlot *slots, uint8_t num_slots,
+                            uint8_t max_slots, uint8_t compare, bool &fits) const;
+    inline void QueueTable(uint8_t back, uint8_t num_slots);
+    inline OHS2024BadgeDuty Correct(const OHS2024BadgeColor &color) const;
+    static inline uint16_t CorrectChannel(ColorCurve curve, byte white, byte value);
+    inline void WriteDuty(uint16_t red, uint16_t green, uint16_t blue);
+    static inline uint16_t Dither(uint16_t duty, uint8_t shift, uint8_t &error);
+
     OHS2024BadgePins m_pins = OHS2024BadgePins();
+
+    OHS2024BadgePortMap m_ports = {};
+    byte m_led_mask = OHS2024BadgeLEDMask::None;
+
+    OHS2024BadgeColor m_pixels[static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs)] = {};
+    OHS2024BadgeScanSlot m_slots[2][max_scan_slots] = {};
+    uint8_t m_num_slots[2] = {};
+    volatile uint8_t m_front = 0;
+    volatile bool m_present_pending = false;
+    uint16_t m_dropped_frames = 0;
+    uint8_t m_scan_length = static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs);
+    uint8_t m_scan_index = 0;
+    uint16_t m_refresh_prescaler = 1;
+    uint8_t m_slot_compare = 0;
+    bool m_hardware_pwm = false;
+    // colour channels written through m_channels (red, green, blue) instead of analogWrite
+    bool m_channels_connected = false;
+    OHS2024BadgeChannel m_channels[3] = {};
+    uint16_t m_pwm_top = 255;
+    uint8_t m_duty_shift = 8;
+    uint8_t m_dither_error[max_scan_slots][3] = {};
+    volatile uint16_t m_refresh_max_cycles = 0;
+    OHS2024BadgeColor m_color = {};
+    OHS2024BadgeColorCorrection m_correction = {};
 };
 
 void OHS2024Badge::Setup()
@@ -87,116 +394,604 @@ void OHS2024Badge::Setup()
     digitalWrite(m_pins.body_center, LOW);
     pinMode(m_pins.body_left, OUTPUT);
     digitalWrite(m_pins.body_left, LOW);
+
+    // Resolve anode ports once
+    m_ports = OHS2024BadgePortMap();
+    AddAnode(OHS2024BadgeLED::HeadRight, m_pins.head_right);
+    AddAnode(OHS2024BadgeLED::HeadTop, m_pins.head_top);
+    AddAnode(OHS2024BadgeLED::HeadLeft, m_pins.head_left);
+    AddAnode(OHS2024BadgeLED::EyeRight, m_pins.eye_right);
+    AddAnode(OHS2024BadgeLED::EyeLeft, m_pins.eye_left);
+    AddAnode(OHS2024BadgeLED::BodyRight, m_pins.body_right);
+    AddAnode(OHS2024BadgeLED::BodyCenter, m_pins.body_center);
+    AddAnode(OHS2024BadgeLED::BodyLeft, m_pins.body_left);
+    m_led_mask = OHS2024BadgeLEDMask::None;
+
+    // Resolve colour channel registers once, the refresh scan writes them directly
+    ResolveChannel(m_pins.pwm_red, m_channels[0]);
+    ResolveChannel(m_pins.pwm_green, m_channels[1]);
+    ResolveChannel(m_pins.pwm_blue, m_channels[2]);
+    m_channels_connected = false;
 }
 
 void OHS2024Badge::SetColor(byte red, byte green, byte blue)
 {
-    red = 255 - red;
-    green = 255 - green;
-    blue = 255 - blue;
-    analogWrite(m_pins.pwm_red, red);
-    analogWrite(m_pins.pwm_green, green);
-    analogWrite(m_pins.pwm_blue, blue);
+    m_color = {red, green, blue};
+    const OHS2024BadgeDuty duty = Correct(m_color);
+    WriteDuty(duty.r >> m_duty_shift, duty.g >> m_duty_shift, duty.b >> m_duty_shift);
+}
+
+void OHS2024Badge::SetColorCorrection(const OHS2024BadgeColorCorrection &correction)
+{
+    m_correction = correction;
+}
+
+void OHS2024Badge::SetLEDMask(const byte mask)
+{
+    // collect anode bits per port
+    uint8_t port_bits[OHS2024BadgePortMap::max_ports] = {};
+    for (uint8_t i = 0; i < static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs); i++) {
+        if ((mask & (1 << i)) && (m_ports.led_port[i] != OHS2024BadgePortMap::no_port)) {
+            port_bits[m_ports.led_port[i]] |= m_ports.led_mask[i];
+        }
+    }
+    // one read-modify-write per port, not interleaved with interrupts writing the same ports
+    const uint8_t sreg = SREG;
+    cli();
+    for (uint8_t k = 0; k < m_ports.num_ports; k++) {
+        *m_ports.out[k] = (*m_ports.out[k] & ~m_ports.anode_mask[k]) | port_bits[k];
+    }
+    SREG = sreg;
+    m_led_mask = mask;
+}
+
+byte OHS2024Badge::GetLEDMask() const
+{
+    return m_led_mask;
 }
 
 void OHS2024Badge::TurnOnLED(const OHS2024BadgeLED led)
 {
-    switch (led) {
-        case OHS2024BadgeLED::HeadRight:
-            digitalWrite(m_pins.head_right, HIGH);
-            break;
-        case OHS2024BadgeLED::HeadTop:
-            digitalWrite(m_pins.head_top, HIGH);
-            break;
-        case OHS2024BadgeLED::HeadLeft:
-            digitalWrite(m_pins.head_left, HIGH);
-            break;
-        case OHS2024BadgeLED::EyeRight:
-            digitalWrite(m_pins.eye_right, HIGH);
-            break;
-        case OHS2024BadgeLED::EyeLeft:
-            digitalWrite(m_pins.eye_left, HIGH);
-            break;
-        case OHS2024BadgeLED::BodyRight:
-            digitalWrite(m_pins.body_right, HIGH);
-            break;
-        case OHS2024BadgeLED::BodyCenter:
-            digitalWrite(m_pins.body_center, HIGH);
-            break;
-        case OHS2024BadgeLED::BodyLeft:
-            digitalWrite(m_pins.body_left, HIGH);
-            break;
-        default:
-            break;
+    if (led >= OHS2024BadgeLED::NumLEDs) {
+        return;
+    }
+    const uint8_t i = static_cast<uint8_t>(led);
+    const uint8_t port = m_ports.led_port[i];
+    if (port != OHS2024BadgePortMap::no_port) {
+        const uint8_t sreg = SREG;
+        cli();
+        *m_ports.out[port] |= m_ports.led_mask[i];
+        SREG = sreg;
     }
+    m_led_mask |= OHS2024BadgeLEDMask::Of(led);
 }
 
 void OHS2024Badge::TurnOffLED(const OHS2024BadgeLED led)
 {
-    switch (led) {
-        case OHS2024BadgeLED::HeadRight:
-            digitalWrite(m_pins.head_right, LOW);
-            break;
-        case OHS2024BadgeLED::HeadTop:
-            digitalWrite(m_pins.head_top, LOW);
-            break;
-        case OHS2024BadgeLED::HeadLeft:
-            digitalWrite(m_pins.head_left, LOW);
-            break;
-        case OHS2024BadgeLED::EyeRight:
-            digitalWrite(m_pins.eye_right, LOW);
-            break;
-        case OHS2024BadgeLED::EyeLeft:
-            digitalWrite(m_pins.eye_left, LOW);
-            break;
-        case OHS2024BadgeLED::BodyRight:
-            digitalWrite(m_pins.body_right, LOW);
-            break;
-        case OHS2024BadgeLED::BodyCenter:
-            digitalWrite(m_pins.body_center, LOW);
-            break;
-        case OHS2024BadgeLED::BodyLeft:
-            digitalWrite(m_pins.body_left, LOW);
-            break;
-        default:
-            break;
+    if (led >= OHS2024BadgeLED::NumLEDs) {
+        return;
     }
+    const uint8_t i = static_cast<uint8_t>(led);
+    const uint8_t port = m_ports.led_port[i];
+    if (port != OHS2024BadgePortMap::no_port) {
+        const uint8_t sreg = SREG;
+        cli();
+        *m_ports.out[port] &= ~m_ports.led_mask[i];
+        SREG = sreg;
+    }
+    m_led_mask &= ~OHS2024BadgeLEDMask::Of(led);
 }
 
 void OHS2024Badge::TurnOnHeadLEDs()
 {
-    digitalWrite(m_pins.head_right, HIGH);
-    digitalWrite(m_pins.head_top, HIGH);
-    digitalWrite(m_pins.head_left, HIGH);
+    SetLEDMask(m_led_mask | OHS2024BadgeLEDMask::Head);
 }
 
 void OHS2024Badge::TurnOffHeadLEDs()
 {
-    digitalWrite(m_pins.head_right, LOW);
-    digitalWrite(m_pins.head_top, LOW);
-    digitalWrite(m_pins.head_left, LOW);
+    SetLEDMask(m_led_mask & ~OHS2024BadgeLEDMask::Head);
 }
 
 void OHS2024Badge::TurnOnEyeLEDs()
 {
-    digitalWrite(m_pins.eye_right, HIGH);
-    digitalWrite(m_pins.eye_left, HIGH);
+    SetLEDMask(m_led_mask | OHS2024BadgeLEDMask::Eyes);
 }
 void OHS2024Badge::TurnOffEyeLEDs()
 {
-    digitalWrite(m_pins.eye_right, LOW);
-    digitalWrite(m_pins.eye_left, LOW);
+    SetLEDMask(m_led_mask & ~OHS2024BadgeLEDMask::Eyes);
 }
 
 void OHS2024Badge::TurnOnBodyLEDs()
 {
-    digitalWrite(m_pins.body_right, HIGH);
-    digitalWrite(m_pins.body_center, HIGH);
-    digitalWrite(m_pins.body_left, HIGH);
+    SetLEDMask(m_led_mask | OHS2024BadgeLEDMask::Body);
 }
 void OHS2024Badge::TurnOffBodyLEDs()
 {
-    digitalWrite(m_pins.body_right, LOW);
-    digitalWrite(m_pins.body_center, LOW);
-    digitalWrite(m_pins.body_left, LOW);
-}
\ No newline at end of file
+    SetLEDMask(m_led_mask & ~OHS2024BadgeLEDMask::Body);
+}
+
+void OHS2024Badge::StartRefresh(const uint16_t refresh_hz, const uint8_t scan_length)
+{
+    m_scan_length = constrain(scan_length, 1, static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs));
+
+    // Timer2 prescaler options and their clock select bits
+    static const uint16_t prescalers[] = {1, 8, 32, 64, 128, 256, 1024};
+    const uint32_t slot_hz = static_cast<uint32_t>((refresh_hz > 0) ? refresh_hz : 1) * m_scan_length;
+    const uint32_t slot_cycles = F_CPU / slot_hz;
+    uint8_t clock_select = 0;
+    while ((clock_select < 6) && ((slot_cycles / prescalers[clock_select]) > 256)) {
+        clock_select++;
+    }
+    const uint32_t top = constrain(slot_cycles / prescalers[clock_select], 1UL, 256UL);
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+#if defined(TCCR3B) && defined(TCCR4B)
+        // colour channels on Timer3/Timer4: run them from the full clock so every slot spans many PWM periods
+        TCCR3B = (TCCR3B & ~(_BV(CS32) | _BV(CS31) | _BV(CS30))) | _BV(CS30);
+        TCCR4B = (TCCR4B & ~(_BV(CS42) | _BV(CS41) | _BV(CS40))) | _BV(CS40);
+#endif
+        // connect the colour channel outputs off, Refresh() then only writes their compare registers
+        for (uint8_t c = 0; (c < 3) && !m_hardware_pwm; c++) {
+            WriteChannel(m_channels[c], 255);
+            if (m_channels[c].tccr != nullptr) {
+                *m_channels[c].tccr |= m_channels[c].com;
+            }
+        }
+        m_channels_connected = true;
+        // Timer2 in CTC mode, one compare match per slot
+        TCCR2A = _BV(WGM21);
+        TCCR2B = clock_select + 1;
+        OCR2A = static_cast<uint8_t>(top - 1);
+        TCNT2 = 0;
+        m_refresh_prescaler = prescalers[clock_select];
+        m_slot_compare = static_cast<uint8_t>(top - 1);
+        m_refresh_max_cycles = 0;
+        m_dropped_frames = 0;
+        m_scan_index = 0;
+        memset(m_dither_error, 0, sizeof(m_dither_error));
+        TIMSK2 |= _BV(OCIE2A);
+    }
+}
+
+void OHS2024Badge::StartHardwarePWM(const uint8_t bits)
+{
+#if defined(TCCR3A) && defined(TCCR4A) && defined(ICR3) && defined(ICR4)
+    if ((m_pins.pwm_red != 2) || (m_pins.pwm_green != 1) || (m_pins.pwm_blue != 0)) {
+        return;
+    }
+    const uint8_t resolution = constrain(bits, 8, 16);
+    m_pwm_top = static_cast<uint16_t>((1UL << resolution) - 1);
+    m_duty_shift = 16 - resolution;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        // halt the prescalers so both timers start counting on the same clock
+        GTCCR = _BV(TSM) | _BV(PSRSYNC);
+
+        // fast PWM with ICR as TOP (mode 14), clear on compare match and set at BOTTOM, clock / 1
+        TCCR3A = _BV(COM3A1) | _BV(COM3B1) | _BV(WGM31);
+        TCCR3B = _BV(WGM33) | _BV(WGM32) | _BV(CS30);
+        TCCR4A = _BV(COM4A1) | _BV(WGM41);
+        TCCR4B = _BV(WGM43) | _BV(WGM42) | _BV(CS40);
+        ICR3 = m_pwm_top;
+        ICR4 = m_pwm_top;
+        TCNT3 = 0;
+        TCNT4 = 0;
+        m_hardware_pwm = true;
+
+        GTCCR = 0;
+    }
+    memset(m_dither_error, 0, sizeof(m_dither_error));
+    SetColor(m_color.r, m_color.g, m_color.b);
+#else
+    (void)bits;
+#endif
+}
+
+void OHS2024Badge::StopRefresh()
+{
+    TIMSK2 &= ~_BV(OCIE2A);
+    m_channels_connected = false;
+    SetLEDMask(m_led_mask);
+    SetColor(m_color.r, m_color.g, m_color.b);
+}
+
+OHS2024BadgeColor *OHS2024Badge::BeginFrame()
+{
+    return m_pixels;
+}
+
+void OHS2024Badge::SetPixel(const OHS2024BadgeLED led, const OHS2024BadgeColor &color)
+{
+    if (led < OHS2024BadgeLED::NumLEDs) {
+        m_pixels[static_cast<uint8_t>(led)] = color;
+    }
+}
+
+void OHS2024Badge::SetPixels(const byte mask, const OHS2024BadgeColor &color)
+{
+    for (uint8_t i = 0; i < static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs); i++) {
+        if (mask & (1 << i)) {
+            m_pixels[i] = color;
+        }
+    }
+}
+
+OHS2024BadgeColor OHS2024Badge::GetPixel(const OHS2024BadgeLED led) const
+{
+    if (led < OHS2024BadgeLED::NumLEDs) {
+        return m_pixels[static_cast<uint8_t>(led)];
+    }
+    return OHS2024BadgeColor();
+}
+
+bool OHS2024Badge::Present()
+{
+    const uint8_t back = TakeBackTable();
+    OHS2024BadgeScanSlot *slots = m_slots[back];
+    bool fits = true;
+    uint8_t num_slots = AddSlots(m_pixels, slots, 0, m_scan_length, m_slot_compare, fits);
+
+    // blank slots for the rest of the scan, so every LED is lit 1/scan_length of the time
+    while (num_slots < m_scan_length) {
+        slots[num_slots] = OHS2024BadgeScanSlot();
+        slots[num_slots].compare = m_slot_compare;
+        num_slots++;
+    }
+    QueueTable(back, num_slots);
+    return fits;
+}
+
+bool OHS2024Badge::PresentCrossfade(const OHS2024BadgeColor *outgoing, const uint8_t outgoing_scan,
+                                    const uint8_t incoming_scan, const uint8_t weight)
+{
+    // Timer2 counts of one slot of the running scan, split between the two frames
+    const uint16_t frame_ticks = static_cast<uint16_t>(m_slot_compare) + 1;
+    const uint8_t outgoing_length = constrain(outgoing_scan, 1, static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs));
+    const uint8_t incoming_length = constrain(incoming_scan, 1, static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs));
+    // rounded down, so the slots never add up to more than the frame and its rate stays fixed
+    const uint16_t outgoing_ticks =
+        static_cast<uint32_t>(frame_ticks) * (UINT8_MAX - weight) / (UINT8_MAX * outgoing_length);
+    const uint16_t incoming_ticks = static_cast<uint32_t>(frame_ticks) * weight / (UINT8_MAX * incoming_length);
+    // shorter slots would end before Refresh() has loaded them
+    const uint16_t min_ticks = (refresh_cycle_budget + m_refresh_prescaler - 1) / m_refresh_prescaler;
+
+    const uint8_t back = TakeBackTable();
+    OHS2024BadgeScanSlot *slots = m_slots[back];
+    bool fits = true;
+    uint8_t num_slots = 0;
+    // one slot stays free for the blank
+    if (outgoing_ticks >= min_ticks) {
+        const uint8_t max_slots = constrain(outgoing_length, 0, max_scan_slots - 1);
+        num_slots = AddSlots(outgoing, slots, num_slots, max_slots, outgoing_ticks - 1, fits);
+    }
+    if (incoming_ticks >= min_ticks) {
+        const uint8_t max_slots = constrain(num_slots + incoming_length, 0, max_scan_slots - 1);
+        num_slots = AddSlots(m_pixels, slots, num_slots, max_slots, incoming_ticks - 1, fits);
+    }
+
+    // blank for the rest of the slot, so the scan frame keeps its length
+    uint16_t lit_ticks = 0;
+    for (uint8_t k = 0; k < num_slots; k++) {
+        lit_ticks += static_cast<uint16_t>(slots[k].compare) + 1;
+    }
+    if (lit_ticks < frame_ticks) {
+        slots[num_slots] = OHS2024BadgeScanSlot();
+        const uint16_t blank_ticks = frame_ticks - lit_ticks;
+        slots[num_slots].compare = ((blank_ticks > min_ticks) ? blank_ticks : min_ticks) - 1;
+        num_slots++;
+    }
+    QueueTable(back, num_slots);
+    return fits;
+}
+
+bool OHS2024Badge::IsPresentPending() const
+{
+    return m_present_pending;
+}
+
+uint16_t OHS2024Badge::GetDroppedFrames() const
+{
+    uint16_t frames;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        frames = m_dropped_frames;
+    }
+    return frames;
+}
+
+void OHS2024Badge::Refresh()
+{
+    // swap in the presented frame at the scan frame boundary
+    if ((m_scan_index == 0) && m_present_pending) {
+        m_front ^= 1;
+        m_present_pending = false;
+    }
+
+    // length of this slot, Timer2 counts up from zero until the compare match
+    const uint8_t num_slots = m_num_slots[m_front];
+    OCR2A = (m_scan_index < num_slots) ? m_slots[m_front][m_scan_index].compare : m_slot_compare;
+
+    // blank anodes before changing colour so the previous slot does not ghost
+    for (uint8_t k = 0; k < m_ports.num_ports; k++) {
+        *m_ports.out[k] &= ~m_ports.anode_mask[k];
+    }
+    if (m_scan_index < num_slots) {
+        const OHS2024BadgeScanSlot &slot = m_slots[m_front][m_scan_index];
+        uint8_t *error = m_dither_error[m_scan_index];
+        WriteDuty(Dither(slot.duty.r, m_duty_shift, error[0]), Dither(slot.duty.g, m_duty_shift, error[1]),
+                  Dither(slot.duty.b, m_duty_shift, error[2]));
+        for (uint8_t k = 0; k < m_ports.num_ports; k++) {
+            *m_ports.out[k] |= slot.port_bits[k];
+        }
+    }
+    m_scan_index++;
+    if (m_scan_index >= num_slots) {
+        m_scan_index = 0;
+    }
+
+    // Timer2 restarted from zero at the compare match that raised this interrupt
+    const uint32_t cycles = static_cast<uint32_t>(TCNT2) * m_refresh_prescaler;
+    if (cycles > m_refresh_max_cycles) {
+        m_refresh_max_cycles = (cycles > UINT16_MAX) ? UINT16_MAX : cycles;
+    }
+}
+
+uint16_t OHS2024Badge::GetRefreshCycles() const
+{
+    uint16_t cycles;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        cycles = m_refresh_max_cycles;
+    }
+    return cycles;
+}
+
+void OHS2024Badge::AddAnode(const OHS2024BadgeLED led, const byte pin)
+{
+    const uint8_t i = static_cast<uint8_t>(led);
+    m_ports.led_port[i] = OHS2024BadgePortMap::no_port;
+    m_ports.led_mask[i] = 0;
+
+    const uint8_t port = digitalPinToPort(pin);
+    if (port == NOT_A_PORT) {
+        return;
+    }
+    volatile uint8_t *out = portOutputRegister(port);
+    const uint8_t mask = digitalPinToBitMask(pin);
+
+    // find or add port
+    uint8_t k = 0;
+    while ((k < m_ports.num_ports) && (m_ports.out[k] != out)) {
+        k++;
+    }
+    if (k == m_ports.num_ports) {
+        if (k == OHS2024BadgePortMap::max_ports) {
+            return;
+        }
+        m_ports.out[k] = out;
+        m_ports.num_ports++;
+    }
+    m_ports.anode_mask[k] |= mask;
+    m_ports.led_port[i] = k;
+    m_ports.led_mask[i] = mask;
+}
+
+void OHS2024Badge::ResolveChannel(const byte pin, OHS2024BadgeChannel &channel)
+{
+    channel = OHS2024BadgeChannel();
+    // the compare output analogWrite would use for the pin
+    switch (digitalPinToTimer(pin)) {
+#if defined(TCCR0A) && defined(COM0A1)
+    case TIMER0A:
+        channel.ocr8 = &OCR0A;
+        channel.tccr = &TCCR0A;
+        channel.com = _BV(COM0A1);
+        return;
+#endif
+#if defined(TCCR0A) && defined(COM0B1)
+    case TIMER0B:
+        channel.ocr8 = &OCR0B;
+        channel.tccr = &TCCR0A;
+        channel.com = _BV(COM0B1);
+        return;
+#endif
+#if defined(TCCR1A) && defined(COM1A1)
+    case TIMER1A:
+        channel.ocr16 = &OCR1A;
+        channel.tccr = &TCCR1A;
+        channel.com = _BV(COM1A1);
+        return;
+#endif
+#if defined(TCCR1A) && defined(COM1B1)
+    case TIMER1B:
+        channel.ocr16 = &OCR1B;
+        channel.tccr = &TCCR1A;
+        channel.com = _BV(COM1B1);
+        return;
+#endif
+#if defined(TCCR2A) && defined(COM2A1)
+    case TIMER2A:
+        channel.ocr8 = &OCR2A;
+        channel.tccr = &TCCR2A;
+        channel.com = _BV(COM2A1);
+        return;
+#endif
+#if defined(TCCR2A) && defined(COM2B1)
+    case TIMER2B:
+        channel.ocr8 = &OCR2B;
+        channel.tccr = &TCCR2A;
+        channel.com = _BV(COM2B1);
+        return;
+#endif
+#if defined(TIMER3A) && defined(TCCR3A) && defined(COM3A1)
+    case TIMER3A:
+        channel.ocr16 = &OCR3A;
+        channel.tccr = &TCCR3A;
+        channel.com = _BV(COM3A1);
+        return;
+#endif
+#if defined(TIMER3B) && defined(TCCR3A) && defined(COM3B1)
+    case TIMER3B:
+        channel.ocr16 = &OCR3B;
+        channel.tccr = &TCCR3A;
+        channel.com = _BV(COM3B1);
+        return;
+#endif
+#if defined(TIMER4A) && defined(TCCR4A) && defined(COM4A1)
+    case TIMER4A:
+        channel.ocr16 = &OCR4A;
+        channel.tccr = &TCCR4A;
+        channel.com = _BV(COM4A1);
+        return;
+#endif
+#if defined(TIMER4B) && defined(TCCR4A) && defined(COM4B1)
+    case TIMER4B:
+        channel.ocr16 = &OCR4B;
+        channel.tccr = &TCCR4A;
+        channel.com = _BV(COM4B1);
+        return;
+#endif
+    default:
+        break;
+    }
+    const uint8_t port = digitalPinToPort(pin);
+    if (port != NOT_A_PORT) {
+        channel.out = portOutputRegister(port);
+        channel.mask = digitalPinToBitMask(pin);
+    }
+}
+
+void OHS2024Badge::WriteChannel(const OHS2024BadgeChannel &channel, const uint8_t value)
+{
+    if (channel.ocr16 != nullptr) {
+        *channel.ocr16 = value;
+    } else if (channel.ocr8 != nullptr) {
+        *channel.ocr8 = value;
+    } else if (channel.out != nullptr) {
+        const uint8_t sreg = SREG;
+        cli();
+        if (value < 128) {
+            *channel.out &= ~channel.mask;
+        } else {
+            *channel.out |= channel.mask;
+        }
+        SREG = sreg;
+    }
+}
+
+uint8_t OHS2024Badge::TakeBackTable()
+{
+    // take back the pending frame, the interrupt only swaps while one is pending
+    uint8_t back;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (m_present_pending) {
+            m_present_pending = false;
+            if (TIMSK2 & _BV(OCIE2A)) {
+                m_dropped_frames++;
+            }
+        }
+        back = m_front ^ 1;
+    }
+    return back;
+}
+
+uint8_t OHS2024Badge::AddSlots(const OHS2024BadgeColor *pixels, OHS2024BadgeScanSlot *slots, uint8_t num_slots,
+                               const uint8_t max_slots, const uint8_t compare, bool &fits) const
+{
+    const OHS2024BadgeColor black = {};
+    const OHS2024BadgeDuty off = {};
+    const uint8_t dropped_bits =
+        (m_duty_shift > m_correction.dither_bits) ? m_duty_shift - m_correction.dither_bits : 0;
+    const uint16_t dither_mask = ~static_cast<uint16_t>((1 << dropped_bits) - 1);
+
+    // one slot per distinct colour, LEDs of the same colour share it
+    const uint8_t first = num_slots;
+    for (uint8_t i = 0; i < static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs); i++) {
+        const uint8_t port = m_ports.led_port[i];
+        if ((pixels[i] == black) || (port == OHS2024BadgePortMap::no_port)) {
+            continue;
+        }
+        // slots hold corrected duty, so the refresh interrupt only dithers it
+        OHS2024BadgeDuty duty = Correct(pixels[i]);
+        duty.r &= dither_mask;
+        duty.g &= dither_mask;
+        duty.b &= dither_mask;
+        if (duty == off) {
+            continue;
+        }
+        uint8_t k = first;
+        while ((k < num_slots) && (slots[k].duty != duty)) {
+            k++;
+        }
+        if (k == num_slots) {
+            if (num_slots >= max_slots) {
+                fits = false;
+                continue;
+            }
+            slots[k] = OHS2024BadgeScanSlot();
+            slots[k].duty = duty;
+            slots[k].compare = compare;
+            num_slots++;
+        }
+        slots[k].port_bits[port] |= m_ports.led_mask[i];
+    }
+    return num_slots;
+}
+
+void OHS2024Badge::QueueTable(const uint8_t back, const uint8_t num_slots)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        m_num_slots[back] = num_slots;
+        m_present_pending = true;
+    }
+}
+
+OHS2024BadgeDuty OHS2024Badge::Correct(const OHS2024BadgeColor &color) const
+{
+    return {CorrectChannel(m_correction.curve_red, m_correction.white_red, color.r),
+            CorrectChannel(m_correction.curve_green, m_correction.white_green, color.g),
+            CorrectChannel(m_correction.curve_blue, m_correction.white_blue, color.b)};
+}
+
+uint16_t OHS2024Badge::CorrectChannel(const ColorCurve curve, const byte white, const byte value)
+{
+    // scale 0-65535 to 8.8 fixed point duty 0-255.0
+    const uint32_t duty = static_cast<uint32_t>(ColorCurveLookup(curve, value)) * (white + 1) >> 8;
+    return duty - (duty >> 8);
+}
+
+void OHS2024Badge::WriteDuty(const uint16_t red, const uint16_t green, const uint16_t blue)
+{
+    // cathodes are active low
+#if defined(TCCR3A) && defined(TCCR4A) && defined(ICR3) && defined(ICR4)
+    if (m_hardware_pwm) {
+        // output is high from BOTTOM to the compare match, so the LED is lit for TOP - OCR counts
+        OCR3B = m_pwm_top - red;
+        OCR4A = m_pwm_top - green;
+        OCR3A = m_pwm_top - blue;
+        return;
+    }
+#endif
+    if (m_channels_connected) {
+        WriteChannel(m_channels[0], 255 - red);
+        WriteChannel(m_channels[1], 255 - green);
+        WriteChannel(m_channels[2], 255 - blue);
+        return;
+    }
+    analogWrite(m_pins.pwm_red, 255 - red);
+    analogWrite(m_pins.pwm_green, 255 - green);
+    analogWrite(m_pins.pwm_blue, 255 - blue);
+}
+
+uint16_t OHS2024Badge::Dither(const uint16_t duty, const uint8_t shift, uint8_t &error)
+{
+    // carry the fraction below the PWM step to the next scan frame of the same slot
+    const uint8_t fraction_mask = (1 << shift) - 1;
+    const uint16_t sum = (duty & fraction_mask) + error;
+    error = sum & fraction_mask;
+    return (duty >> shift) + (sum >> shift);
+}
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "OHS2024Badge.h"
+
+/**
+ * @brief Compile-time location of a pin: data-space address of its PORTx register and bit number.
+ */
+template <uint8_t PortAddress, uint8_t Bit>
+struct OHS2024BadgeStaticPin
+{
+    static constexpr uint8_t port = PortAddress;
+    static constexpr uint8_t ddr = PortAddress - 1;
+    static constexpr uint8_t mask = 1 << Bit;
+};
+
+/**
+ * @brief Data-space addresses of the ATmega328PB PORTx registers.
+ */
+struct OHS2024BadgePortAddress
+{
+    static constexpr uint8_t portb = 0x25;
+    static constexpr uint8_t portc = 0x28;
+    static constexpr uint8_t portd = 0x2B;
+    static constexpr uint8_t porte = 0x2E;
+};
+
+/**
+ * @brief Badge pin map as types, same wiring as OHS2024BadgePins with MiniCore ATmega328PB numbering.
+ */
+struct OHS2024BadgeStaticPins
+{
+    using HeadRight = OHS2024BadgeStaticPin<OHS2024BadgePortAddress::porte, 0>;  // D23
+    using HeadTop = OHS2024BadgeStaticPin<OHS2024BadgePortAddress::portd, 4>;    // D4
+    using HeadLeft = OHS2024BadgeStaticPin<OHS2024BadgePortAddress::portd, 3>;   // D3
+
+    using EyeRight = OHS2024BadgeStaticPin<OHS2024BadgePortAddress::portc, 5>;  // D19
+    using EyeLeft = OHS2024BadgeStaticPin<OHS2024BadgePortAddress::portc, 1>;   // D15
+
+    using BodyRight = OHS2024BadgeStaticPin<OHS2024BadgePortAddress::portc, 4>;   // D18
+    using BodyCenter = OHS2024BadgeStaticPin<OHS2024BadgePortAddress::portc, 3>;  // D17
+    using BodyLeft = OHS2024BadgeStaticPin<OHS2024BadgePortAddress::portc, 2>;    // D16
+
+    static constexpr byte pwm_red = 2;
+    static constexpr byte pwm_green = 1;
+    static constexpr byte pwm_blue = 0;
+};
+
+/**
+ * @brief Badge LED control with the pin map fixed at compile time.
+ *
+ * Same interface as OHS2024Badge, but every function is static and the pin map is a type, so the class
+ * holds no state. With a constant argument TurnOnLED/TurnOffLED reduce to a single sbi/cbi, and group
+ * functions to one masked write per port.
+ *
+ * @tparam PinMap Pin map type with the layout of OHS2024BadgeStaticPins.
+ */
+template <typename PinMap = OHS2024BadgeStaticPins>
+class OHS2024BadgeT
+{
+public:
+    static inline void Setup();
+
+    static inline void SetColor(byte red, byte green, byte blue);
+
+    /**
+     * @brief Light exactly the LEDs in a mask and turn off all others, with one write per port.
+     *
+     * @param mask LED mask, bit i is OHS2024BadgeLED i. See OHS2024BadgeLEDMask.
+     */
+    static inline void SetLEDMask(byte mask);
+
+    static inline void TurnOnLED(OHS2024BadgeLED led);
+    static inline void TurnOffLED(OHS2024BadgeLED led);
+
+    static inline void TurnOnHeadLEDs();
+    static inline void TurnOffHeadLEDs();
+
+    static inline void TurnOnEyeLEDs();
+    static inline void TurnOffEyeLEDs();
+
+    static inline void TurnOnBodyLEDs();
+    static inline void TurnOffBodyLEDs();
+
+private:
+    template <uint8_t Port, typename... Pins>
+    static constexpr uint8_t PortMask()
+    {
+        return ((Pins::port == Port ? Pins::mask : 0) | ... | 0);
+    }
+
+    template <uint8_t Port, typename Pin>
+    static constexpr uint8_t PinBits(const byte mask, const byte led_mask)
+    {
+        return ((Pin::port == Port) && (mask & led_mask)) ? Pin::mask : 0;
+    }
+
+    template <uint8_t Port, uint8_t Mask>
+    static inline void WritePort(bool state);
+
+    template <uint8_t Port>
+    static inline void WritePortMask(byte mask);
+
+    template <typename... Pins>
+    static inline void WritePins(bool state);
+};
+
+template <typename PinMap>
+template <uint8_t Port, uint8_t Mask>
+void OHS2024BadgeT<PinMap>::WritePort(const bool state)
+{
+    if constexpr (Mask == 0) {
+        return;
+    } else if constexpr ((Mask & (Mask - 1)) == 0) {
+        // single bit: sbi/cbi are atomic
+        if (state) {
+            _SFR_MEM8(Port) |= Mask;
+        } else {
+            _SFR_MEM8(Port) &= ~Mask;
+        }
+    } else {
+        // several bits: read-modify-write must not interleave with interrupts
+        const uint8_t sreg = SREG;
+        cli();
+        if (state) {
+            _SFR_MEM8(Port) |= Mask;
+        } else {
+            _SFR_MEM8(Port) &= ~Mask;
+        }
+        SREG = sreg;
+    }
+}
+
+template <typename PinMap>
+template <uint8_t Port>
+void OHS2024BadgeT<PinMap>::WritePortMask(const byte mask)
+{
+    constexpr uint8_t anodes =
+        PortMask<Port, typename PinMap::HeadRight, typename PinMap::HeadTop, typename PinMap::HeadLeft,
+                 typename PinMap::EyeRight, typename PinMap::EyeLeft, typename PinMap::BodyRight,
+                 typename PinMap::BodyCenter, typename PinMap::BodyLeft>();
+    if constexpr (anodes != 0) {
+        const uint8_t bits = PinBits<Port, typename PinMap::HeadRight>(mask, OHS2024BadgeLEDMask::HeadRight) |
+                             PinBits<Port, typename PinMap::HeadTop>(mask, OHS2024BadgeLEDMask::HeadTop) |
+                             PinBits<Port, typename PinMap::HeadLeft>(mask, OHS2024BadgeLEDMask::HeadLeft) |
+                             PinBits<Port, typename PinMap::EyeRight>(mask, OHS2024BadgeLEDMask::EyeRight) |
+                             PinBits<Port, typename PinMap::EyeLeft>(mask, OHS2024BadgeLEDMask::EyeLeft) |
+                             PinBits<Port, typename PinMap::BodyRight>(mask, OHS2024BadgeLEDMask::BodyRight) |
+                             PinBits<Port, typename PinMap::BodyCenter>(mask, OHS2024BadgeLEDMask::BodyCenter) |
+                             PinBits<Port, typename PinMap::BodyLeft>(mask, OHS2024BadgeLEDMask::BodyLeft);
+        const uint8_t sreg = SREG;
+        cli();
+        _SFR_MEM8(Port) = (_SFR_MEM8(Port) & ~anodes) | bits;
+        SREG = sreg;
+    }
+}
+
+template <typename PinMap>
+template <typename... Pins>
+void OHS2024BadgeT<PinMap>::WritePins(const bool state)
+{
+    static_assert(((Pins::port == OHS2024BadgePortAddress::portb || Pins::port == OHS2024BadgePortAddress::portc ||
+                    Pins::port == OHS2024BadgePortAddress::portd || Pins::port == OHS2024BadgePortAddress::porte) &&
+                   ...),
+                  "Pin map uses an unknown port");
+    WritePort<OHS2024BadgePortAddress::portb, PortMask<OHS2024BadgePortAddress::portb, Pins...>()>(state);
+    WritePort<OHS2024BadgePortAddress::portc, PortMask<OHS2024BadgePortAddress::portc, Pins...>()>(state);
+    WritePort<OHS2024BadgePortAddress::portd, PortMask<OHS2024BadgePortAddress::portd, Pins...>()>(state);
+    WritePort<OHS2024BadgePortAddress::porte, PortMask<OHS2024BadgePortAddress::porte, Pins...>()>(state);
+}
+
+template <typename PinMap>
+void OHS2024BadgeT<PinMap>::Setup()
+{
+    // PWM cathodes to HIGH
+    pinMode(PinMap::pwm_red, OUTPUT);
+    digitalWrite(PinMap::pwm_red, HIGH);
+    pinMode(PinMap::pwm_green, OUTPUT);
+    digitalWrite(PinMap::pwm_green, HIGH);
+    pinMode(PinMap::pwm_blue, OUTPUT);
+    digitalWrite(PinMap::pwm_blue, HIGH);
+
+    // Anodes to LOW
+    TurnOffHeadLEDs();
+    TurnOffEyeLEDs();
+    TurnOffBodyLEDs();
+    _SFR_MEM8(PinMap::HeadRight::ddr) |= PinMap::HeadRight::mask;
+    _SFR_MEM8(PinMap::HeadTop::ddr) |= PinMap::HeadTop::mask;
+    _SFR_MEM8(PinMap::HeadLeft::ddr) |= PinMap::HeadLeft::mask;
+    _SFR_MEM8(PinMap::EyeRight::ddr) |= PinMap::EyeRight::mask;
+    _SFR_MEM8(PinMap::EyeLeft::ddr) |= PinMap::EyeLeft::mask;
+    _SFR_MEM8(PinMap::BodyRight::ddr) |= PinMap::BodyRight::mask;
+    _SFR_MEM8(PinMap::BodyCenter::ddr) |= PinMap::BodyCenter::mask;
+    _SFR_MEM8(PinMap::BodyLeft::ddr) |= PinMap::BodyLeft::mask;
+}
+
+template <typename PinMap>
+void OHS2024BadgeT<PinMap>::SetColor(byte red, byte green, byte blue)
+{
+    red = 255 - red;
+    green = 255 - green;
+    blue = 255 - blue;
+    analogWrite(PinMap::pwm_red, red);
+    analogWrite(PinMap::pwm_green, green);
+    analogWrite(PinMap::pwm_blue, blue);
+}
+
+template <typename PinMap>
+void OHS2024BadgeT<PinMap>::SetLEDMask(const byte mask)
+{
+    WritePortMask<OHS2024BadgePortAddress::portb>(mask);
+    WritePortMask<OHS2024BadgePortAddress::portc>(mask);
+    WritePortMask<OHS2024BadgePortAddress::portd>(mask);
+    WritePortMask<OHS2024BadgePortAddress::porte>(mask);
+}
+
+template <typename PinMap>
+void OHS2024BadgeT<PinMap>::TurnOnLED(const OHS2024BadgeLED led)
+{
+    switch (led) {
+        case OHS2024BadgeLED::HeadRight:
+            WritePins<typename PinMap::HeadRight>(HIGH);
+            break;
+        case OHS2024BadgeLED::HeadTop:
+            WritePins<typename PinMap::HeadTop>(HIGH);
+            break;
+        case OHS2024BadgeLED::HeadLeft:
+            WritePins<typename PinMap::HeadLeft>(HIGH);
+            break;
+        case OHS2024BadgeLED::EyeRight:
+            WritePins<typename PinMap::EyeRight>(HIGH);
+            break;
+        case OHS2024BadgeLED::EyeLeft:
+            WritePins<typename PinMap::EyeLeft>(HIGH);
+            break;
+        case OHS2024BadgeLED::BodyRight:
+            WritePins<typename PinMap::BodyRight>(HIGH);
+            break;
+        case OHS2024BadgeLED::BodyCenter:
+            WritePins<typename PinMap::BodyCenter>(HIGH);
+            break;
+        case OHS2024BadgeLED::BodyLeft:
+            WritePins<typename PinMap::BodyLeft>(HIGH);
+            break;
+        default:
+            break;
+    }
+}
+
+template <typename PinMap>
+void OHS2024BadgeT<PinMap>::TurnOffLED(const OHS2024BadgeLED led)
+{
+    switch (led) {
+        case OHS2024BadgeLED::HeadRight:
+            WritePins<typename PinMap::HeadRight>(LOW);
+            break;
+        case OHS2024BadgeLED::HeadTop:
+            WritePins<typename PinMap::HeadTop>(LOW);
+            break;
+        case OHS2024BadgeLED::HeadLeft:
+            WritePins<typename PinMap::HeadLeft>(LOW);
+            break;
+        case OHS2024BadgeLED::EyeRight:
+            WritePins<typename PinMap::EyeRight>(LOW);
+            break;
+        case OHS2024BadgeLED::EyeLeft:
+            WritePins<typename PinMap::EyeLeft>(LOW);
+            break;
+        case OHS2024BadgeLED::BodyRight:
+            WritePins<typename PinMap::BodyRight>(LOW);
+            break;
+        case OHS2024BadgeLED::BodyCenter:
+            WritePins<typename PinMap::BodyCenter>(LOW);
+            break;
+        case OHS2024BadgeLED::BodyLeft:
+            WritePins<typename PinMap::BodyLeft>(LOW);
+            break;
+        default:
+            break;
+    }
+}
+
+template <typename PinMap>
+void OHS2024BadgeT<PinMap>::TurnOnHeadLEDs()
+{
+    WritePins<typename PinMap::HeadRight, typename PinMap::HeadTop, typename PinMap::HeadLeft>(HIGH);
+}
+
+template <typename PinMap>
+void OHS2024BadgeT<PinMap>::TurnOffHeadLEDs()
+{
+    WritePins<typename PinMap::HeadRight, typename PinMap::HeadTop, typename PinMap::HeadLeft>(LOW);
+}
+
+template <typename PinMap>
+void OHS2024BadgeT<PinMap>::TurnOnEyeLEDs()
+{
+    WritePins<typename PinMap::EyeRight, typename PinMap::EyeLeft>(HIGH);
+}
+
+template <typename PinMap>
+void OHS2024BadgeT<PinMap>::TurnOffEyeLEDs()
+{
+    WritePins<typename PinMap::EyeRight, typename PinMap::EyeLeft>(LOW);
+}
+
+template <typename PinMap>
+void OHS2024BadgeT<PinMap>::TurnOnBodyLEDs()
+{
+    WritePins<typename PinMap::BodyRight, typename PinMap::BodyCenter, typename PinMap::BodyLeft>(HIGH);
+}
+
+template <typename PinMap>
+void OHS2024BadgeT<PinMap>::TurnOffBodyLEDs()
+{
+    WritePins<typename PinMap::BodyRight, typename PinMap::BodyCenter, typename PinMap::BodyLeft>(LOW);
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief Waveforms of an Oscillator.
+ */
+enum class OscillatorWave : uint8_t {
+    /**
+     * @brief Sine from 0 to 255, starting at the midpoint and rising.
+     */
+    Sine = 0,
+    /**
+     * @brief Linear rise from 0 to 254 over the first half of the period, then fall back.
+     */
+    Triangle,
+    /**
+     * @brief Triangle eased in and out with a quadratic, same as FastLED quadwave8.
+     */
+    Quad,
+    /**
+     * @brief Linear rise from 0 to 255 over the period.
+     */
+    Sawtooth,
+};
+
+/**
+ * @brief One 8-bit value per phase step of a waveform.
+ */
+struct OscillatorTable {
+    uint8_t values[256];
+};
+
+namespace oscillator_detail {
+
+// sin(2 pi x) for x in [0, 1) by Taylor series on the nearest quarter, usable in constant expressions
+constexpr double Sine(double x) {
+    const double pi = 3.14159265358979323846;
+    double t = x - static_cast<int>(x);
+    double sign = 1.0;
+    if (t >= 0.5) {
+        t -= 0.5;
+        sign = -1.0;
+    }
+    if (t > 0.25) {
+        t = 0.5 - t;
+    }
+    const double a = 2.0 * pi * t;
+    double term = a;
+    double sum = a;
+    for (uint8_t n = 1; n < 12; n++) {
+        term *= -a * a / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sign * sum;
+}
+
+constexpr uint8_t Triangle(uint8_t phase) { return ((phase & 0x80) ? 255 - phase : phase) << 1; }
+
+constexpr uint8_t Quad(uint8_t phase) {
+    const uint8_t i = Triangle(phase);
+    const uint8_t j = (i & 0x80) ? 255 - i : i;
+    const uint8_t jj = (static_cast<uint16_t>(j) * (j + 1)) >> 8;
+    const uint8_t jj2 = jj << 1;
+    return (i & 0x80) ? 255 - jj2 : jj2;
+}
+
+constexpr OscillatorTable MakeSineTable() {
+    OscillatorTable table = {};
+    for (uint16_t i = 0; i < 256; i++) {
+        table.values[i] = static_cast<uint8_t>(127.5 + 127.5 * Sine(i / 256.0) + 0.5);
+    }
+    return table;
+}
+
+constexpr OscillatorTable MakeQuadTable() {
+    OscillatorTable table = {};
+    for (uint16_t i = 0; i < 256; i++) {
+        table.values[i] = Quad(i);
+    }
+    return table;
+}
+
+}  // namespace oscillator_detail
+
+/**
+ * @brief Sine table, generated at compile time and stored in flash.
+ */
+inline constexpr OscillatorTable oscillator_sine PROGMEM = oscillator_detail::MakeSineTable();
+
+/**
+ * @brief Eased triangle table, generated at compile time and stored in flash.
+ */
+inline constexpr OscillatorTable oscillator_quad PROGMEM = oscillator_detail::MakeQuadTable();
+
+static_assert(oscillator_sine.values[0] == 128 && oscillator_sine.values[64] == 255 &&
+                  oscillator_sine.values[192] == 0,
+              "sine table must span 0 to 255 around 128");
+static_assert(oscillator_quad.values[0] == 0 && oscillator_quad.values[128] == 255,
+              "quad table must rise from 0 to 255 at half period");
+
+/**
+ * @brief Phase-accumulator (DDS) oscillator for animation timing.
+ *
+ * The phase is a 32-bit fraction of a period and advances by a fixed increment on every tick, so a tick
+ * is a single add and wraps on its own. The increment is computed once from the period, and changing it
+ * keeps the current phase, so the period can change while running without a jump. Outputs look up the
+ * top 8 bits of the phase.
+ */
+class Oscillator {
+   public:
+    Oscillator() = default;
+
+    /**
+     * @brief Set the period.
+     *
+     * Only the ratio of tick to period matters, so any unit works as long as both use it: pass
+     * microseconds when the tick is not a whole number of milliseconds.
+     *
+     * @param period Period.
+     * @param tick Time between calls to Tick(), in the same unit as the period.
+     */
+    void SetPeriod(uint32_t period, uint32_t tick);
+
+    /**
+     * @brief Set the phase increment per tick directly, as a fraction of 2^32 of a period.
+     */
+    void SetIncrement(uint32_t increment);
+
+    /**
+     * @brief Get the phase increment per tick.
+     */
+    uint32_t GetIncrement() const;
+
+    /**
+     * @brief Set the phase.
+     *
+     * @param phase Fraction of 2^32 of a period.
+     */
+    void SetPhase(uint32_t phase);
+
+    /**
+     * @brief Get the phase as a fraction of 2^32 of a period.
+     */
+    uint32_t GetPhase() const;
+
+    /**
+     * @brief Advance the phase by one tick.
+     */
+    void Tick();
+
+    /**
+     * @brief Sine output, 0 to 255.
+     */
+    uint8_t Sine() const;
+
+    /**
+     * @brief Triangle output, 0 to 254.
+     */
+    uint8_t Triangle() const;
+
+    /**
+     * @brief Eased triangle output, 0 to 255.
+     */
+    uint8_t Quad() const;
+
+    /**
+     * @brief Sawtooth output, 0 to 255.
+     */
+    uint8_t Sawtooth() const;
+
+    /**
+     * @brief Output of a waveform chosen at run time.
+     */
+    uint8_t Output(OscillatorWave wave) const;
+
+   private:
+    uint8_t Phase8() const;
+
+    uint32_t m_phase = 0;
+    uint32_t m_increment = 0;
+};
+
+// Inline functions
+// ----------------
+
+inline void Oscillator::SetPeriod(uint32_t period, uint32_t tick) {
+    if (period == 0) {
+        m_increment = 0;
+        return;
+    }
+    // 2^32 * tick / period, rounded. Whole periods per tick do not move the phase, so only the remainder is
+    // divided, one quotient bit per step in 32 bits instead of pulling a 64-bit division into the image.
+    uint32_t remainder = tick % period;
+    uint32_t increment = 0;
+    for (uint8_t bit = 0; bit < 32; bit++) {
+        // the shifted remainder may carry out of 32 bits when the period is above 2^31
+        const bool carry = (remainder & 0x80000000UL) != 0;
+        remainder <<= 1;
+        increment <<= 1;
+        if (carry || (remainder >= period)) {
+            remainder -= period;
+            increment |= 1;
+        }
+    }
+    if (remainder >= period - remainder) {
+        increment++;
+    }
+    m_increment = increment;
+}
+
+inline void Oscillator::SetIncrement(uint32_t increment) { m_increment = increment; }
+
+inline uint32_t Oscillator::GetIncrement() const { return m_increment; }
+
+inline void Oscillator::SetPhase(uint32_t phase) { m_phase = phase; }
+
+inline uint32_t Oscillator::GetPhase() const { return m_phase; }
+
+inline void Oscillator::Tick() { m_phase += m_increment; }
+
+inline uint8_t Oscillator::Sine() const { return pgm_read_byte(&oscillator_sine.values[Phase8()]); }
+
+inline uint8_t Oscillator::Triangle() const { return oscillator_detail::Triangle(Phase8()); }
+
+inline uint8_t Oscillator::Quad() const { return pgm_read_byte(&oscillator_quad.values[Phase8()]); }
+
+inline uint8_t Oscillator::Sawtooth() const { return Phase8(); }
+
+inline uint8_t Oscillator::Output(OscillatorWave wave) const {
+    switch (wave) {
+        case OscillatorWave::Sine:
+            return Sine();
+        case OscillatorWave::Triangle:
+            return Triangle();
+        case OscillatorWave::Quad:
+            return Quad();
+        default:
+            return Sawtooth();
+    }
+}
+
+inline uint8_t Oscillator::Phase8() const { return m_phase >> 24; }
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "OHS2024Badge.h"
+
+/**
+ * @brief LEDs in particle position order, from the left of the head ring down to the right of the body.
+ *
+ * Position p in 8.8 fixed point lies between LED p >> 8 and the next one.
+ */
+constexpr OHS2024BadgeLED particle_layout[static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs)] = {
+    OHS2024BadgeLED::HeadLeft,  OHS2024BadgeLED::HeadTop,  OHS2024BadgeLED::HeadRight,  OHS2024BadgeLED::EyeRight,
+    OHS2024BadgeLED::EyeLeft,   OHS2024BadgeLED::BodyLeft, OHS2024BadgeLED::BodyCenter, OHS2024BadgeLED::BodyRight,
+};
+
+/**
+ * @brief Fixed pool of particles moving along the badge LEDs.
+ *
+ * Particles are stored as a struct of arrays with live particles packed at the front, so Update() and
+ * Render() are one pass over live particles and removing a particle moves the last one into its place.
+ * Positions and velocities are fixed point and brightness decays by a multiply and shift, so there is no
+ * division or floating point per frame. Nothing is allocated at run time.
+ *
+ * @tparam Capacity Maximum number of live particles.
+ */
+template <uint8_t Capacity>
+class ParticleSystem {
+   public:
+    /**
+     * @brief Largest particle position: on the last LED of particle_layout.
+     */
+    static constexpr int16_t max_position = (static_cast<int16_t>(OHS2024BadgeLED::NumLEDs) - 1) << 8;
+
+    ParticleSystem() = default;
+
+    /**
+     * @brief Remove all particles.
+     */
+    void Clear();
+
+    /**
+     * @brief Add a particle.
+     *
+     * @param position Position along particle_layout in 8.8 fixed point, from 0 to max_position.
+     * @param velocity Velocity in 1/256 LED per frame.
+     * @param color Colour at full brightness.
+     * @param decay Brightness lost per frame, as a fraction of 256 of the current brightness.
+     * @return False if the pool is full.
+     */
+    bool Spawn(int16_t position, int8_t velocity, const OHS2024BadgeColor &color, uint8_t decay);
+
+    /**
+     * @brief Advance all particles by one frame, removing those that faded out or left the badge.
+     */
+    void Update();
+
+    /**
+     * @brief Add all particles to a framebuffer, splitting each between its two nearest LEDs.
+     *
+     * Colours add up and saturate, so overlapping particles blend.
+     *
+     * @param pixels Framebuffer with one colour per OHS2024BadgeLED.
+     */
+    void Render(OHS2024BadgeColor *pixels) const;
+
+    /**
+     * @brief Number of live particles.
+     */
+    uint8_t GetCount() const;
+
+   private:
+    void Remove(uint8_t i);
+
+    int16_t m_position[Capacity] = {};
+    int8_t m_velocity[Capacity] = {};
+    uint8_t m_brightness[Capacity] = {};
+    uint8_t m_decay[Capacity] = {};
+    OHS2024BadgeColor m_color[Capacity] = {};
+    uint8_t m_count = 0;
+};
+
+// Inline functions
+// ----------------
+
+template <uint8_t Capacity>
+inline void ParticleSystem<Capacity>::Clear() {
+    m_count = 0;
+}
+
+template <uint8_t Capacity>
+inline bool ParticleSystem<Capacity>::Spawn(int16_t position, int8_t velocity, const OHS2024BadgeColor &color,
+                                            uint8_t decay) {
+    if ((m_count >= Capacity) || (position < 0) || (position > max_position)) {
+        return false;
+    }
+    const uint8_t i = m_count++;
+    m_position[i] = position;
+    m_velocity[i] = velocity;
+    m_brightness[i] = UINT8_MAX;
+    m_decay[i] = decay;
+    m_color[i] = color;
+    return true;
+}
+
+template <uint8_t Capacity>
+inline void ParticleSystem<Capacity>::Update() {
+    uint8_t i = 0;
+    while (i < m_count) {
+        const int16_t position = m_position[i] + m_velocity[i];
+        // strictly less than the current brightness, so every particle fades out
+        const uint8_t brightness = (static_cast<uint16_t>(m_brightness[i]) * (UINT8_MAX - m_decay[i])) >> 8;
+        if ((brightness == 0) || (position < 0) || (position > max_position)) {
+            Remove(i);
+            continue;
+        }
+        m_position[i] = position;
+        m_brightness[i] = brightness;
+        i++;
+    }
+}
+
+template <uint8_t Capacity>
+inline void ParticleSystem<Capacity>::Render(OHS2024BadgeColor *pixels) const {
+    for (uint8_t i = 0; i < m_count; i++) {
+        const uint8_t index = static_cast<uint16_t>(m_position[i]) >> 8;
+        const uint8_t fraction = m_position[i] & 0xFF;
+        OHS2024BadgeColor &pixel = pixels[static_cast<uint8_t>(particle_layout[index])];
+        pixel = AddSaturate(pixel, Scale8(m_color[i], Scale8(m_brightness[i], UINT8_MAX - fraction)));
+        if (fraction > 0) {
+            OHS2024BadgeColor &next = pixels[static_cast<uint8_t>(particle_layout[index + 1])];
+            next = AddSaturate(next, Scale8(m_color[i], Scale8(m_brightness[i], fraction)));
+        }
+    }
+}
+
+template <uint8_t Capacity>
+inline uint8_t ParticleSystem<Capacity>::GetCount() const {
+    return m_count;
+}
+
+template <uint8_t Capacity>
+inline void ParticleSystem<Capacity>::Remove(uint8_t i) {
+    const uint8_t last = --m_count;
+    m_position[i] = m_position[last];
+    m_velocity[i] = m_velocity[last];
+    m_brightness[i] = m_brightness[last];
+    m_decay[i] = m_decay[last];
+    m_color[i] = m_color[last];
+}
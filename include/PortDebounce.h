@@ -0,0 +1,173 @@
+#pragma once
+
+#include <Arduino.h>
+#include <util/atomic.h>
+
+/**
+ * @brief Configuration for port debounce
+ */
+struct PortDebounceConfiguration {
+    /**
+     * @brief Any pin on the port to debounce. Selects the input register that is sampled.
+     */
+    uint8_t port_pin = 0;
+    /**
+     * @brief Bits of the port to debounce. Other bits always read as inactive.
+     */
+    uint8_t mask = 0xFF;
+    /**
+     * @brief Polarity of each bit. A bit set to 1 is reversed polarity, like HIGH polarity in
+     * DebounceConfiguration: active when the pin reads LOW.
+     */
+    uint8_t polarity = 0x00;
+    /**
+     * @brief Minimum delay between each measurement in microseconds.
+     */
+    uint32_t delay_microseconds = 2000;
+};
+
+/**
+ * @brief Debounce all inputs of an 8-bit port at once.
+ *
+ * The port is sampled with a single register read and each bit gets a 2-bit vertical counter: the
+ * counters of all eight bits are stored bit-sliced in two bytes and updated together with a handful of
+ * logic operations. A bit changes state after 4 consecutive samples that differ from its current state,
+ * so cost does not depend on how many inputs are debounced.
+ */
+class PortDebounce {
+   public:
+    PortDebounce() = default;
+
+    /**
+     * @brief Configure debounce parameters.
+     *
+     * @param config Debounce configuration parameters.
+     */
+    void Setup(const PortDebounceConfiguration &config);
+
+    /**
+     * @brief Reset state of all bits.
+     *
+     * @param state Active state of each bit.
+     */
+    void Reset(uint8_t state);
+
+    /**
+     * @brief Update debounce and get current state of the port.
+     *
+     * One sample of the port will be taken if the configured delay has elapsed.
+     *
+     * @return Active state of each bit.
+     */
+    uint8_t Update();
+
+    /**
+     * @brief Run one debounce step on a port value read elsewhere.
+     *
+     * @param port_value Raw value of the port input register.
+     * @return Active state of each bit.
+     */
+    uint8_t Sample(uint8_t port_value);
+
+    /**
+     * @brief Get current active state of each bit.
+     */
+    uint8_t GetState() const;
+
+    /**
+     * @brief Get bits that became active since the last call, and clear them.
+     */
+    uint8_t TakeActivated();
+
+    /**
+     * @brief Get bits that became inactive since the last call, and clear them.
+     */
+    uint8_t TakeDeactivated();
+
+    /**
+     * @brief Get the bit of a pin in the port state.
+     *
+     * @param pin Pin number.
+     * @return Bit mask of the pin.
+     */
+    static uint8_t PinMask(uint8_t pin);
+
+   private:
+    PortDebounceConfiguration m_config = {};
+    volatile uint8_t *m_input = nullptr;
+
+    uint8_t m_state = 0;
+    uint8_t m_count0 = 0xFF;
+    uint8_t m_count1 = 0xFF;
+    volatile uint8_t m_activated = 0;
+    volatile uint8_t m_deactivated = 0;
+    uint32_t m_last_update_time = 0;
+};
+
+// Inline functions
+// ----------------
+
+inline void PortDebounce::Setup(const PortDebounceConfiguration &config) {
+    m_config = config;
+    const uint8_t port = digitalPinToPort(config.port_pin);
+    m_input = (port != NOT_A_PORT) ? portInputRegister(port) : nullptr;
+    Reset(0);
+}
+
+inline void PortDebounce::Reset(uint8_t state) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        m_state = state & m_config.mask;
+        m_count0 = 0xFF;
+        m_count1 = 0xFF;
+        m_activated = 0;
+        m_deactivated = 0;
+    }
+    m_last_update_time = micros();
+}
+
+inline uint8_t PortDebounce::Update() {
+    const uint32_t now = micros();
+    if ((m_input != nullptr) && ((now - m_last_update_time) >= m_config.delay_microseconds)) {
+        // update time
+        m_last_update_time = now;
+        // take measurement of all bits
+        Sample(*m_input);
+    }
+    return m_state;
+}
+
+inline uint8_t PortDebounce::Sample(uint8_t port_value) {
+    const uint8_t measured = (port_value ^ m_config.polarity) & m_config.mask;
+    // bits that differ from state count down, others reload the counter
+    uint8_t changed = m_state ^ measured;
+    m_count0 = ~(m_count0 & changed);
+    m_count1 = m_count0 ^ (m_count1 & changed);
+    // counter rolled over: toggle state
+    changed &= m_count0 & m_count1;
+    m_state ^= changed;
+    m_activated |= changed & m_state;
+    m_deactivated |= changed & ~m_state;
+    return m_state;
+}
+
+inline uint8_t PortDebounce::GetState() const { return m_state; }
+
+inline uint8_t PortDebounce::TakeActivated() {
+    uint8_t bits;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        bits = m_activated;
+        m_activated = 0;
+    }
+    return bits;
+}
+
+inline uint8_t PortDebounce::TakeDeactivated() {
+    uint8_t bits;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        bits = m_deactivated;
+        m_deactivated = 0;
+    }
+    return bits;
+}
+
+inline uint8_t PortDebounce::PinMask(uint8_t pin) { return digitalPinToBitMask(pin); }
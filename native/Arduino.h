@@ -0,0 +1,406 @@
+#pragma once
+
+/**
+ * Minimal Arduino/AVR hardware abstraction for running the badge firmware on a host machine.
+ *
+ * I/O registers of the ATmega328PB live in a simulated data space, so code that writes PORTx, OCRnx or
+ * TIMSKn directly behaves the same as code that calls digitalWrite. Time is virtual: it only advances when
+ * the firmware calls delay(), when the host calls hal::Advance() or when the runner charges the cost of a
+ * loop() call, and timer interrupts enabled by the firmware are dispatched while it advances. Output level
+ * changes are recorded with their virtual timestamp; changes made by direct register writes are picked up
+ * at the next digitalWrite, interrupt or clock advance.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef F_CPU
+#define F_CPU 8000000UL
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Simulated AVR data space
+// ------------------------
+
+extern volatile uint8_t hal_sfr[0x100];
+
+#define _SFR_MEM8(addr) (hal_sfr[(addr)])
+#define _SFR_MEM16(addr) (*reinterpret_cast<volatile uint16_t *>(&hal_sfr[(addr)]))
+#define _BV(bit) (1 << (bit))
+
+#define SREG _SFR_MEM8(0x5F)
+#define SREG_I 7
+
+#define PINB _SFR_MEM8(0x23)
+#define DDRB _SFR_MEM8(0x24)
+#define PORTB _SFR_MEM8(0x25)
+#define PINC _SFR_MEM8(0x26)
+#define DDRC _SFR_MEM8(0x27)
+#define PORTC _SFR_MEM8(0x28)
+#define PIND _SFR_MEM8(0x29)
+#define DDRD _SFR_MEM8(0x2A)
+#define PORTD _SFR_MEM8(0x2B)
+#define PINE _SFR_MEM8(0x2C)
+#define DDRE _SFR_MEM8(0x2D)
+#define PORTE _SFR_MEM8(0x2E)
+
+#define TIFR0 _SFR_MEM8(0x35)
+#define TIFR2 _SFR_MEM8(0x37)
+#define PCIFR _SFR_MEM8(0x3B)
+
+#define GTCCR _SFR_MEM8(0x43)
+#define TSM 7
+#define PSRASY 1
+#define PSRSYNC 0
+
+#define TCCR0A _SFR_MEM8(0x44)
+#define TCCR0B _SFR_MEM8(0x45)
+#define TCNT0 _SFR_MEM8(0x46)
+#define OCR0A _SFR_MEM8(0x47)
+#define OCR0B _SFR_MEM8(0x48)
+#define COM0A1 7
+#define COM0B1 5
+
+#define PCICR _SFR_MEM8(0x68)
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCIE3 3
+#define PCMSK0 _SFR_MEM8(0x6B)
+#define PCMSK1 _SFR_MEM8(0x6C)
+#define PCMSK2 _SFR_MEM8(0x6D)
+#define PCMSK3 _SFR_MEM8(0x73)
+
+#define TIMSK0 _SFR_MEM8(0x6E)
+#define TIMSK1 _SFR_MEM8(0x6F)
+#define TIMSK2 _SFR_MEM8(0x70)
+#define TIMSK3 _SFR_MEM8(0x71)
+#define TIMSK4 _SFR_MEM8(0x72)
+#define TOIE0 0
+#define OCIE0A 1
+#define OCIE0B 2
+#define OCIE2A 1
+
+#define TCCR1A _SFR_MEM8(0x80)
+#define TCCR1B _SFR_MEM8(0x81)
+#define TCNT1 _SFR_MEM16(0x84)
+#define ICR1 _SFR_MEM16(0x86)
+#define OCR1A _SFR_MEM16(0x88)
+#define OCR1B _SFR_MEM16(0x8A)
+#define COM1A1 7
+#define COM1B1 5
+#define WGM13 4
+
+#define TCCR3A _SFR_MEM8(0x90)
+#define TCCR3B _SFR_MEM8(0x91)
+#define TCNT3 _SFR_MEM16(0x94)
+#define ICR3 _SFR_MEM16(0x96)
+#define OCR3A _SFR_MEM16(0x98)
+#define OCR3B _SFR_MEM16(0x9A)
+
+#define TCCR4A _SFR_MEM8(0xA0)
+#define TCCR4B _SFR_MEM8(0xA1)
+#define TCNT4 _SFR_MEM16(0xA4)
+#define ICR4 _SFR_MEM16(0xA6)
+#define OCR4A _SFR_MEM16(0xA8)
+#define OCR4B _SFR_MEM16(0xAA)
+
+#define COM3A1 7
+#define COM3A0 6
+#define COM3B1 5
+#define COM3B0 4
+#define WGM31 1
+#define WGM30 0
+#define WGM33 4
+#define WGM32 3
+#define CS32 2
+#define CS31 1
+#define CS30 0
+
+#define COM4A1 7
+#define COM4A0 6
+#define COM4B1 5
+#define COM4B0 4
+#define WGM41 1
+#define WGM40 0
+#define WGM43 4
+#define WGM42 3
+#define CS42 2
+#define CS41 1
+#define CS40 0
+
+#define TCCR2A _SFR_MEM8(0xB0)
+#define TCCR2B _SFR_MEM8(0xB1)
+#define TCNT2 _SFR_MEM8(0xB2)
+#define OCR2A _SFR_MEM8(0xB3)
+#define OCR2B _SFR_MEM8(0xB4)
+#define COM2A1 7
+#define COM2B1 5
+#define WGM21 1
+#define WGM20 0
+#define CS22 2
+#define CS21 1
+#define CS20 0
+
+inline void cli() { SREG &= ~_BV(SREG_I); }
+inline void sei() { SREG |= _BV(SREG_I); }
+
+// Interrupt vectors
+// -----------------
+
+#define ISR(vector) extern "C" void vector(void)
+
+extern "C" {
+void TIMER0_COMPA_vect(void);
+void TIMER2_COMPA_vect(void);
+void PCINT0_vect(void);
+void PCINT1_vect(void);
+void PCINT2_vect(void);
+void PCINT3_vect(void);
+}
+
+// Program memory
+// --------------
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t *>(addr))
+#define pgm_read_word(addr) (*reinterpret_cast<const uint16_t *>(addr))
+#define pgm_read_dword(addr) (*reinterpret_cast<const uint32_t *>(addr))
+#define pgm_read_ptr(addr) (*reinterpret_cast<void *const *>(addr))
+#define memcpy_P memcpy
+
+// Pin mapping (MiniCore ATmega328PB)
+// ----------------------------------
+
+#define NOT_A_PORT 0
+#define PB 2
+#define PC 3
+#define PD 4
+#define PE 5
+
+#define NUM_DIGITAL_PINS 27
+
+extern const uint8_t hal_pin_to_port[NUM_DIGITAL_PINS];
+extern const uint8_t hal_pin_to_bit[NUM_DIGITAL_PINS];
+
+#define digitalPinToPort(p) (((p) < NUM_DIGITAL_PINS) ? hal_pin_to_port[(p)] : NOT_A_PORT)
+#define digitalPinToBitMask(p) (((p) < NUM_DIGITAL_PINS) ? _BV(hal_pin_to_bit[(p)]) : 0)
+#define portInputRegister(port) (&hal_sfr[0x23 + 3 * ((port)-PB)])
+#define portModeRegister(port) (&hal_sfr[0x24 + 3 * ((port)-PB)])
+#define portOutputRegister(port) (&hal_sfr[0x25 + 3 * ((port)-PB)])
+
+// Timers of the PWM pins, values as in the core's Arduino.h
+#define NOT_ON_TIMER 0
+#define TIMER0A 1
+#define TIMER0B 2
+#define TIMER1A 3
+#define TIMER1B 4
+#define TIMER2A 7
+#define TIMER2B 8
+#define TIMER3A 9
+#define TIMER3B 10
+#define TIMER4A 12
+#define TIMER4B 13
+
+extern const uint8_t hal_pin_to_timer[NUM_DIGITAL_PINS];
+
+#define digitalPinToTimer(p) (((p) < NUM_DIGITAL_PINS) ? hal_pin_to_timer[(p)] : NOT_ON_TIMER)
+
+#define digitalPinToPCICR(p) (((p) < NUM_DIGITAL_PINS) ? (&PCICR) : nullptr)
+#define digitalPinToPCICRbit(p) (hal_pin_to_port[(p)] == PB ? PCIE0 : hal_pin_to_port[(p)] == PC ? PCIE1 : hal_pin_to_port[(p)] == PD ? PCIE2 : PCIE3)
+#define digitalPinToPCMSK(p) (hal_pin_to_port[(p)] == PB ? (&PCMSK0) : hal_pin_to_port[(p)] == PC ? (&PCMSK1) : hal_pin_to_port[(p)] == PD ? (&PCMSK2) : (&PCMSK3))
+#define digitalPinToPCMSKbit(p) (hal_pin_to_bit[(p)])
+
+// SPI pins, constants as in the core's pins_arduino.h
+static const uint8_t SS = 10;
+static const uint8_t MOSI = 11;
+static const uint8_t MISO = 12;
+static const uint8_t SCK = 13;
+
+// Arduino API
+// -----------
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+int analogRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+void setup();
+void loop();
+
+// Serial
+// ------
+
+/**
+ * @brief Serial port that writes to standard output, or to a simulated line once the host opens one.
+ *
+ * On the line every byte takes ten bit times at the rate given to begin(). Received bytes wait in a
+ * 64 byte ring like the core's and are lost when it is full, and writes wait while the core's 64 byte
+ * transmit buffer is full.
+ */
+class HardwareSerial {
+   public:
+    void begin(unsigned long baud);
+    int available();
+    int read();
+    size_t write(uint8_t value);
+    size_t print(char value);
+    size_t print(const char *text);
+    size_t print(unsigned long value);
+    size_t println(const char *text = "");
+    size_t println(unsigned long value);
+};
+
+extern HardwareSerial Serial;
+
+// Host control
+// ------------
+
+namespace hal {
+
+/**
+ * @brief Recorded change of an output pin level or PWM duty.
+ */
+struct PinEvent {
+    uint32_t time_us;
+    uint8_t pin;
+    uint8_t value;
+    bool pwm;
+};
+
+/**
+ * @brief Reset registers, virtual clock and the recorded pin events.
+ */
+void Reset();
+
+/**
+ * @brief Advance the virtual clock, dispatching any enabled timer interrupts on the way.
+ *
+ * @param us Microseconds to advance.
+ */
+void Advance(uint32_t us);
+
+/**
+ * @brief Drive an input pin from outside, as a button or add-on would.
+ *
+ * Pin-change interrupts enabled for the pin are dispatched.
+ *
+ * @param pin Digital pin number.
+ * @param level Electrical level at the pin.
+ */
+void SetInput(uint8_t pin, uint8_t level);
+
+/**
+ * @brief Current electrical level of an output pin.
+ */
+uint8_t GetOutput(uint8_t pin);
+
+/**
+ * @brief PWM duty of a pin, 0 to 255.
+ *
+ * While the pin's timer output is connected, as after analogWrite, this is its compare value scaled to the
+ * timer's TOP; otherwise 0 or 255 from the pin level. Pins never driven by analogWrite or their timer
+ * read 0. Duty changes are recorded as PWM pin events.
+ */
+uint8_t GetDuty(uint8_t pin);
+
+/**
+ * @brief Number of digitalRead calls on a pin since the last Reset().
+ */
+uint32_t GetReadCount(uint8_t pin);
+
+/**
+ * @brief Enable or disable recording of pin events.
+ */
+void SetRecording(bool enabled);
+
+/**
+ * @brief Recorded pin events since the last Reset() or ClearEvents().
+ */
+const PinEvent *GetEvents(uint32_t *count);
+
+/**
+ * @brief Drop recorded pin events.
+ */
+void ClearEvents();
+
+/**
+ * @brief Number of interrupt handlers dispatched since the last Reset().
+ */
+uint32_t GetInterruptCount();
+
+/**
+ * @brief Virtual time in CPU cycles since the last Reset().
+ */
+uint64_t GetCycles();
+
+/**
+ * @brief Number of values drawn by random() since the last Reset().
+ */
+uint32_t GetRandomDraws();
+
+/**
+ * @brief Virtual microseconds charged for each call of micros(), millis() and Serial.available().
+ *
+ * Busy-wait loops on those calls then advance the clock by themselves. The cost is 0 after Reset().
+ */
+void SetPollCost(uint32_t us);
+
+/**
+ * @brief Connect Serial to a simulated line to the host instead of standard output.
+ */
+void OpenSerialLine();
+
+/**
+ * @brief Send bytes to the firmware over the serial line.
+ *
+ * @param data Bytes to send.
+ * @param length Number of bytes.
+ * @param start_us Virtual time the first byte starts, or later when the line is still busy.
+ */
+void SendSerial(const uint8_t *data, uint32_t length, uint32_t start_us);
+
+/**
+ * @brief Take the bytes the firmware has finished sending on the serial line.
+ *
+ * @param data Buffer for the bytes.
+ * @param max_length Size of the buffer.
+ * @param end_us Set to the virtual time the last byte taken finished, if any was.
+ * @return Number of bytes taken.
+ */
+uint32_t TakeSerial(uint8_t *data, uint32_t max_length, uint32_t *end_us);
+
+/**
+ * @brief Received bytes lost to a full ring since the last Reset().
+ */
+uint32_t GetSerialOverruns();
+
+}  // namespace hal
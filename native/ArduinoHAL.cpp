@@ -0,0 +1,602 @@
+#include <Arduino.h>
+#include <stdio.h>
+
+#include <deque>
+#include <vector>
+
+// Simulated AVR data space
+// ------------------------
+
+volatile uint8_t hal_sfr[0x100] = {};
+
+// MiniCore ATmega328PB pinout
+const uint8_t hal_pin_to_port[NUM_DIGITAL_PINS] = {
+    PD, PD, PD, PD, PD, PD, PD, PD,  // D0 - D7
+    PB, PB, PB, PB, PB, PB,          // D8 - D13
+    PC, PC, PC, PC, PC, PC,          // D14 - D19
+    PB, PB,                          // D20 - D21
+    PC,                              // D22
+    PE, PE, PE, PE,                  // D23 - D26
+};
+
+const uint8_t hal_pin_to_bit[NUM_DIGITAL_PINS] = {
+    0, 1, 2, 3, 4, 5, 6, 7,  // D0 - D7
+    0, 1, 2, 3, 4, 5,        // D8 - D13
+    0, 1, 2, 3, 4, 5,        // D14 - D19
+    6, 7,                    // D20 - D21
+    6,                       // D22
+    0, 1, 2, 3,              // D23 - D26
+};
+
+// MiniCore ATmega328PB PWM pins; D2 has OC3B and OC4B, the badge drives it from Timer3
+const uint8_t hal_pin_to_timer[NUM_DIGITAL_PINS] = {
+    TIMER3A,      TIMER4A, TIMER3B, TIMER2B, NOT_ON_TIMER, TIMER0B, TIMER0A, NOT_ON_TIMER,  // D0 - D7
+    NOT_ON_TIMER, TIMER1A, TIMER1B, TIMER2A, NOT_ON_TIMER, NOT_ON_TIMER,                    // D8 - D13
+    NOT_ON_TIMER, NOT_ON_TIMER, NOT_ON_TIMER, NOT_ON_TIMER, NOT_ON_TIMER, NOT_ON_TIMER,     // D14 - D19
+    NOT_ON_TIMER, NOT_ON_TIMER,                                                             // D20 - D21
+    NOT_ON_TIMER,                                                                           // D22
+    NOT_ON_TIMER, NOT_ON_TIMER, NOT_ON_TIMER, NOT_ON_TIMER,                                 // D23 - D26
+};
+
+// Default interrupt handlers, replaced by the firmware's ISR() definitions
+extern "C" {
+__attribute__((weak)) void TIMER0_COMPA_vect(void) {}
+__attribute__((weak)) void TIMER2_COMPA_vect(void) {}
+__attribute__((weak)) void PCINT0_vect(void) {}
+__attribute__((weak)) void PCINT1_vect(void) {}
+__attribute__((weak)) void PCINT2_vect(void) {}
+__attribute__((weak)) void PCINT3_vect(void) {}
+}
+
+namespace {
+
+// Arduino core runs Timer0 with prescaler 64 and overflow at 256
+constexpr uint32_t timer0_period_cycles = 64UL * 256UL;
+
+// Timer2 clock select to prescaler
+constexpr uint16_t timer2_prescalers[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+// HardwareSerial ring sizes of the core
+constexpr uint32_t serial_rx_buffer = 64;
+constexpr uint32_t serial_tx_buffer = 64;
+
+// Compare output of a timer: TCCRnA and OCRnx addresses and the COMnx1 bit that connects it to its pin
+struct PwmChannel {
+    uint8_t tccra;
+    uint8_t com_bit;
+    uint8_t ocr;
+    bool wide;  // 16-bit timer, TCCRnB at tccra + 1 and ICRn at tccra + 6
+};
+
+// Indexed by the core's timer numbers, empty for timers the ATmega328PB lacks
+const PwmChannel pwm_channels[] = {
+    {},                      // NOT_ON_TIMER
+    {0x44, 7, 0x47, false},  // TIMER0A
+    {0x44, 5, 0x48, false},  // TIMER0B
+    {0x80, 7, 0x88, true},   // TIMER1A
+    {0x80, 5, 0x8A, true},   // TIMER1B
+    {},                      // TIMER1C
+    {},                      // TIMER2
+    {0xB0, 7, 0xB3, false},  // TIMER2A
+    {0xB0, 5, 0xB4, false},  // TIMER2B
+    {0x90, 7, 0x98, true},   // TIMER3A
+    {0x90, 5, 0x9A, true},   // TIMER3B
+    {},                      // TIMER3C
+    {0xA0, 7, 0xA8, true},   // TIMER4A
+    {0xA0, 5, 0xAA, true},   // TIMER4B
+};
+
+struct SerialByte {
+    uint64_t cycle;  // arrival or end of transmission
+    uint8_t value;
+};
+
+struct State {
+    uint64_t cycles = 0;
+    uint64_t timer0_next = 0;
+    uint64_t timer2_next = 0;
+    uint32_t interrupts = 0;
+
+    uint8_t input_level[NUM_DIGITAL_PINS] = {};
+    uint8_t output_level[NUM_DIGITAL_PINS] = {};
+    uint8_t duty[NUM_DIGITAL_PINS] = {};
+    bool pwm[NUM_DIGITAL_PINS] = {};  // driven by analogWrite or its timer since Reset()
+    uint32_t reads[NUM_DIGITAL_PINS] = {};
+
+    bool recording = true;
+    std::vector<hal::PinEvent> events;
+
+    uint32_t random_state = 1;
+    uint32_t random_draws = 0;
+
+    uint32_t poll_cycles = 0;
+
+    // serial line to the host
+    bool serial_line = false;
+    uint32_t serial_byte_cycles = 1;
+    std::deque<SerialByte> serial_incoming;  // sent by the host, not yet in the ring
+    std::deque<uint8_t> serial_ring;
+    uint64_t serial_rx_end = 0;
+    uint32_t serial_overruns = 0;
+    std::deque<SerialByte> serial_outgoing;  // sent by the firmware, not yet taken by the host
+    uint64_t serial_tx_end = 0;
+};
+
+State state;
+
+volatile uint8_t &PinRegister(const uint8_t pin, const uint8_t offset) {
+    return hal_sfr[0x23 + 3 * (hal_pin_to_port[pin] - PB) + offset];
+}
+
+uint8_t PinLevel(const uint8_t pin) {
+    const uint8_t mask = _BV(hal_pin_to_bit[pin]);
+    if (PinRegister(pin, 1) & mask) {
+        return (PinRegister(pin, 2) & mask) ? HIGH : LOW;
+    }
+    return state.input_level[pin];
+}
+
+const PwmChannel *FindChannel(const uint8_t pin) {
+    const uint8_t timer = hal_pin_to_timer[pin];
+    if ((timer >= sizeof(pwm_channels) / sizeof(pwm_channels[0])) || (pwm_channels[timer].tccra == 0)) {
+        return nullptr;
+    }
+    return &pwm_channels[timer];
+}
+
+bool PwmConnected(const PwmChannel *channel) {
+    return (channel != nullptr) && (hal_sfr[channel->tccra] & _BV(channel->com_bit));
+}
+
+// Compare value scaled to 0 - 255 while the timer drives the pin, else the pin level at full scale
+uint8_t PinDuty(const uint8_t pin) {
+    const PwmChannel *channel = FindChannel(pin);
+    if (!PwmConnected(channel)) {
+        return (PinLevel(pin) == HIGH) ? 255 : 0;
+    }
+    if (!channel->wide) {
+        return hal_sfr[channel->ocr];
+    }
+    // the core runs 16-bit timers in 8-bit PWM, modes with WGMn3 set take TOP from ICRn
+    const uint16_t ocr = _SFR_MEM16(channel->ocr);
+    const uint16_t icr = _SFR_MEM16(channel->tccra + 6);
+    const uint32_t top = ((hal_sfr[channel->tccra + 1] & _BV(WGM13)) && (icr != 0)) ? icr : 255;
+    const uint32_t duty = (static_cast<uint32_t>(ocr) * 255 + top / 2) / top;
+    return (duty > 255) ? 255 : static_cast<uint8_t>(duty);
+}
+
+void Record(const uint8_t pin, const uint8_t value, const bool pwm) {
+    if (state.recording) {
+        const uint32_t time_us = static_cast<uint32_t>(state.cycles / (F_CPU / 1000000UL));
+        state.events.push_back({time_us, pin, value, pwm});
+    }
+}
+
+// Refresh PINx from outputs and external levels and record output changes
+void SyncPins() {
+    for (uint8_t pin = 0; pin < NUM_DIGITAL_PINS; pin++) {
+        const uint8_t mask = _BV(hal_pin_to_bit[pin]);
+        const uint8_t level = PinLevel(pin);
+        if (level) {
+            PinRegister(pin, 0) |= mask;
+        } else {
+            PinRegister(pin, 0) &= ~mask;
+        }
+        if ((PinRegister(pin, 1) & mask) && (level != state.output_level[pin])) {
+            state.output_level[pin] = level;
+            Record(pin, level, false);
+        }
+        if (PwmConnected(FindChannel(pin))) {
+            state.pwm[pin] = true;
+        }
+        if (state.pwm[pin]) {
+            const uint8_t duty = PinDuty(pin);
+            if (duty != state.duty[pin]) {
+                state.duty[pin] = duty;
+                Record(pin, duty, true);
+            }
+        }
+    }
+}
+
+void Dispatch(void (*vector)(void)) {
+    if (!(SREG & _BV(SREG_I))) {
+        return;
+    }
+    cli();
+    vector();
+    sei();
+    state.interrupts++;
+    SyncPins();
+}
+
+uint64_t Timer2Period() {
+    const uint16_t prescaler = timer2_prescalers[TCCR2B & 0x07];
+    return static_cast<uint64_t>(OCR2A + 1) * prescaler;
+}
+
+void AdvanceTo(const uint64_t target) {
+    while (true) {
+        // schedule enabled timers
+        if (TIMSK0 & _BV(OCIE0A)) {
+            if (state.timer0_next == 0) {
+                state.timer0_next = state.cycles + timer0_period_cycles;
+            }
+        } else {
+            state.timer0_next = 0;
+        }
+        if ((TIMSK2 & _BV(OCIE2A)) && (TCCR2B & 0x07)) {
+            if (state.timer2_next == 0) {
+                state.timer2_next = state.cycles + Timer2Period();
+            }
+        } else {
+            state.timer2_next = 0;
+        }
+
+        // next interrupt before the target time
+        uint64_t next = target;
+        if ((state.timer0_next != 0) && (state.timer0_next < next)) {
+            next = state.timer0_next;
+        }
+        if ((state.timer2_next != 0) && (state.timer2_next < next)) {
+            next = state.timer2_next;
+        }
+        state.cycles = next;
+        if (next == target) {
+            break;
+        }
+
+        if (next == state.timer2_next) {
+            // CTC restarts from zero at the match, an OCR2A written by the interrupt sets the period just begun
+            TCNT2 = 0;
+            Dispatch(TIMER2_COMPA_vect);
+            state.timer2_next += Timer2Period();
+        }
+        if (next == state.timer0_next) {
+            state.timer0_next += timer0_period_cycles;
+            Dispatch(TIMER0_COMPA_vect);
+        }
+    }
+    SyncPins();
+}
+
+void ChargePoll() {
+    if (state.poll_cycles != 0) {
+        AdvanceTo(state.cycles + state.poll_cycles);
+    }
+}
+
+// Move bytes that have arrived by now into the receive ring, dropping those that find it full
+void ReceiveArrived() {
+    while (!state.serial_incoming.empty() && (state.serial_incoming.front().cycle <= state.cycles)) {
+        if (state.serial_ring.size() < serial_rx_buffer) {
+            state.serial_ring.push_back(state.serial_incoming.front().value);
+        } else {
+            state.serial_overruns++;
+        }
+        state.serial_incoming.pop_front();
+    }
+}
+
+// Bytes written by the firmware that are still waiting or being sent
+uint32_t TransmitBacklog() {
+    uint32_t backlog = 0;
+    for (auto it = state.serial_outgoing.rbegin(); (it != state.serial_outgoing.rend()) && (it->cycle > state.cycles);
+         ++it) {
+        backlog++;
+    }
+    return backlog;
+}
+
+}  // namespace
+
+// Arduino API
+// -----------
+
+void pinMode(const uint8_t pin, const uint8_t mode) {
+    if (pin >= NUM_DIGITAL_PINS) {
+        return;
+    }
+    const uint8_t mask = _BV(hal_pin_to_bit[pin]);
+    if (mode == OUTPUT) {
+        PinRegister(pin, 1) |= mask;
+    } else {
+        PinRegister(pin, 1) &= ~mask;
+        if (mode == INPUT_PULLUP) {
+            PinRegister(pin, 2) |= mask;
+        } else {
+            PinRegister(pin, 2) &= ~mask;
+        }
+    }
+    SyncPins();
+}
+
+void digitalWrite(const uint8_t pin, const uint8_t val) {
+    if (pin >= NUM_DIGITAL_PINS) {
+        return;
+    }
+    const uint8_t mask = _BV(hal_pin_to_bit[pin]);
+    const uint8_t sreg = SREG;
+    cli();
+    // disconnects the timer output, as turnOffPWM() in the core
+    const PwmChannel *channel = FindChannel(pin);
+    if (channel != nullptr) {
+        hal_sfr[channel->tccra] &= ~_BV(channel->com_bit);
+    }
+    if (val == LOW) {
+        PinRegister(pin, 2) &= ~mask;
+    } else {
+        PinRegister(pin, 2) |= mask;
+    }
+    SREG = sreg;
+    SyncPins();
+}
+
+int digitalRead(const uint8_t pin) {
+    if (pin >= NUM_DIGITAL_PINS) {
+        return LOW;
+    }
+    state.reads[pin]++;
+    SyncPins();
+    return (PinRegister(pin, 0) & _BV(hal_pin_to_bit[pin])) ? HIGH : LOW;
+}
+
+void analogWrite(const uint8_t pin, const int val) {
+    if (pin >= NUM_DIGITAL_PINS) {
+        return;
+    }
+    pinMode(pin, OUTPUT);
+    state.pwm[pin] = true;
+    const PwmChannel *channel = FindChannel(pin);
+    // full scale and pins without a timer are plain outputs, as in the core
+    if ((val <= 0) || (val >= 255) || (channel == nullptr)) {
+        digitalWrite(pin, (val >= 128) ? HIGH : LOW);
+        return;
+    }
+    if (channel->wide) {
+        _SFR_MEM16(channel->ocr) = static_cast<uint16_t>(val);
+    } else {
+        hal_sfr[channel->ocr] = static_cast<uint8_t>(val);
+    }
+    hal_sfr[channel->tccra] |= _BV(channel->com_bit);
+    SyncPins();
+}
+
+int analogRead(const uint8_t) { return 0; }
+
+unsigned long millis() {
+    ChargePoll();
+    return static_cast<unsigned long>(state.cycles / (F_CPU / 1000UL));
+}
+
+unsigned long micros() {
+    ChargePoll();
+    return static_cast<unsigned long>(state.cycles / (F_CPU / 1000000UL));
+}
+
+void delay(const unsigned long ms) { hal::Advance(ms * 1000UL); }
+
+void delayMicroseconds(const unsigned int us) { hal::Advance(us); }
+
+long random(const long howbig) {
+    if (howbig <= 0) {
+        return 0;
+    }
+    state.random_draws++;
+    // same generator as avr-libc random(): Park-Miller minimal standard
+    int32_t hi = state.random_state / 127773L;
+    int32_t lo = state.random_state % 127773L;
+    int32_t x = 16807L * lo - 2836L * hi;
+    if (x <= 0) {
+        x += 0x7FFFFFFFL;
+    }
+    state.random_state = x;
+    return x % howbig;
+}
+
+long random(const long howsmall, const long howbig) {
+    if (howsmall >= howbig) {
+        return howsmall;
+    }
+    return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(const unsigned long seed) {
+    if (seed != 0) {
+        state.random_state = seed;
+    }
+}
+
+long map(const long x, const long in_min, const long in_max, const long out_min, const long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+HardwareSerial Serial;
+
+void HardwareSerial::begin(const unsigned long baud) {
+    if (baud != 0) {
+        state.serial_byte_cycles = static_cast<uint32_t>((10ULL * F_CPU + baud - 1) / baud);
+    }
+}
+
+int HardwareSerial::available() {
+    ChargePoll();
+    ReceiveArrived();
+    return static_cast<int>(state.serial_ring.size());
+}
+
+int HardwareSerial::read() {
+    ReceiveArrived();
+    if (state.serial_ring.empty()) {
+        return -1;
+    }
+    const uint8_t value = state.serial_ring.front();
+    state.serial_ring.pop_front();
+    return value;
+}
+
+size_t HardwareSerial::write(const uint8_t value) {
+    if (!state.serial_line) {
+        return (putchar(value) == EOF) ? 0 : 1;
+    }
+    // wait for room in the transmit buffer, the byte in the shift register is not in it
+    while (TransmitBacklog() > serial_tx_buffer) {
+        const size_t waiting = state.serial_outgoing.size() - TransmitBacklog();
+        AdvanceTo(state.serial_outgoing[waiting].cycle);
+    }
+    const uint64_t start = (state.serial_tx_end > state.cycles) ? state.serial_tx_end : state.cycles;
+    state.serial_tx_end = start + state.serial_byte_cycles;
+    state.serial_outgoing.push_back({state.serial_tx_end, value});
+    return 1;
+}
+
+size_t HardwareSerial::print(const char value) { return write(static_cast<uint8_t>(value)); }
+
+size_t HardwareSerial::print(const char *text) {
+    size_t length = 0;
+    while (text[length] != '\0') {
+        write(static_cast<uint8_t>(text[length++]));
+    }
+    return length;
+}
+
+size_t HardwareSerial::print(const unsigned long value) {
+    char text[16];
+    snprintf(text, sizeof(text), "%lu", value);
+    return print(text);
+}
+
+size_t HardwareSerial::println(const char *text) { return print(text) + print("\n"); }
+
+size_t HardwareSerial::println(const unsigned long value) { return print(value) + print("\n"); }
+
+// Host control
+// ------------
+
+namespace hal {
+
+void Reset() {
+    for (auto &reg : hal_sfr) {
+        reg = 0;
+    }
+    state = State();
+    for (uint8_t pin = 0; pin < NUM_DIGITAL_PINS; pin++) {
+        state.input_level[pin] = HIGH;
+    }
+    // Arduino core enables interrupts before setup()
+    sei();
+    SyncPins();
+}
+
+void Advance(const uint32_t us) { AdvanceTo(state.cycles + static_cast<uint64_t>(us) * (F_CPU / 1000000UL)); }
+
+void SetInput(const uint8_t pin, const uint8_t level) {
+    if ((pin >= NUM_DIGITAL_PINS) || (state.input_level[pin] == level)) {
+        return;
+    }
+    state.input_level[pin] = level;
+    SyncPins();
+
+    // pin-change interrupt
+    const uint8_t port = hal_pin_to_port[pin];
+    const uint8_t group = (port == PB) ? 0 : (port == PC) ? 1 : (port == PD) ? 2 : 3;
+    volatile uint8_t *const pcmsk[4] = {&PCMSK0, &PCMSK1, &PCMSK2, &PCMSK3};
+    void (*const vectors[4])(void) = {PCINT0_vect, PCINT1_vect, PCINT2_vect, PCINT3_vect};
+    if ((PCICR & _BV(group)) && (*pcmsk[group] & _BV(hal_pin_to_bit[pin]))) {
+        Dispatch(vectors[group]);
+    }
+}
+
+uint8_t GetOutput(const uint8_t pin) { return (pin < NUM_DIGITAL_PINS) ? state.output_level[pin] : LOW; }
+
+uint8_t GetDuty(const uint8_t pin) {
+    if (pin >= NUM_DIGITAL_PINS) {
+        return 0;
+    }
+    SyncPins();
+    return state.duty[pin];
+}
+
+uint32_t GetReadCount(const uint8_t pin) { return (pin < NUM_DIGITAL_PINS) ? state.reads[pin] : 0; }
+
+void SetRecording(const bool enabled) { state.recording = enabled; }
+
+const PinEvent *GetEvents(uint32_t *count) {
+    *count = static_cast<uint32_t>(state.events.size());
+    return state.events.data();
+}
+
+void ClearEvents() { state.events.clear(); }
+
+uint32_t GetInterruptCount() { return state.interrupts; }
+
+uint64_t GetCycles() { return state.cycles; }
+
+uint32_t GetRandomDraws() { return state.random_draws; }
+
+void SetPollCost(const uint32_t us) { state.poll_cycles = us * (F_CPU / 1000000UL); }
+
+void OpenSerialLine() { state.serial_line = true; }
+
+void SendSerial(const uint8_t *data, const uint32_t length, const uint32_t start_us) {
+    const uint64_t start = static_cast<uint64_t>(start_us) * (F_CPU / 1000000UL);
+    uint64_t cycle = (state.serial_rx_end > start) ? state.serial_rx_end : start;
+    for (uint32_t i = 0; i < length; i++) {
+        cycle += state.serial_byte_cycles;
+        state.serial_incoming.push_back({cycle, data[i]});
+    }
+    state.serial_rx_end = cycle;
+}
+
+uint32_t TakeSerial(uint8_t *data, const uint32_t max_length, uint32_t *end_us) {
+    uint32_t length = 0;
+    while ((length < max_length) && !state.serial_outgoing.empty() &&
+           (state.serial_outgoing.front().cycle <= state.cycles)) {
+        data[length++] = state.serial_outgoing.front().value;
+        *end_us = static_cast<uint32_t>(state.serial_outgoing.front().cycle / (F_CPU / 1000000UL));
+        state.serial_outgoing.pop_front();
+    }
+    return length;
+}
+
+uint32_t GetSerialOverruns() { return state.serial_overruns; }
+
+}  // namespace hal
+
+// Firmware runner
+// ---------------
+
+// pio test links src/ for the tests in test/, which bring their own main
+#if !defined(HAL_NO_MAIN) && !defined(PIO_UNIT_TESTING)
+
+/**
+ * Run setup() and loop() against the virtual clock.
+ *
+ * Usage: program [seconds] [loop_us]
+ *   seconds  Virtual seconds to run, default 10.
+ *   loop_us  Virtual time charged for each loop() call, default 100.
+ */
+int main(int argc, char **argv) {
+    const double seconds = (argc > 1) ? atof(argv[1]) : 10.0;
+    const uint32_t loop_us = (argc > 2) ? static_cast<uint32_t>(atol(argv[2])) : 100;
+    const uint64_t end_cycles = static_cast<uint64_t>(seconds * F_CPU);
+
+    hal::Reset();
+    setup();
+    uint64_t loops = 0;
+    while (hal::GetCycles() < end_cycles) {
+        loop();
+        hal::Advance(loop_us);
+        loops++;
+    }
+
+    uint32_t num_events = 0;
+    hal::GetEvents(&num_events);
+    printf("virtual time: %.3f s\n", static_cast<double>(hal::GetCycles()) / F_CPU);
+    printf("loop calls: %llu\n", static_cast<unsigned long long>(loops));
+    printf("interrupts: %lu\n", static_cast<unsigned long>(hal::GetInterruptCount()));
+    printf("pin events: %lu\n", static_cast<unsigned long>(num_events));
+    return 0;
+}
+
+#endif
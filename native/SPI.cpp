@@ -0,0 +1,49 @@
+#include <SPI.h>
+
+namespace {
+
+hal::SPIDevice spi_device = nullptr;
+// SPI clock divider of the current transaction, 4 as after SPI.begin() on the AVR
+uint8_t spi_divider = 4;
+
+}  // namespace
+
+SPISettings::SPISettings(const uint32_t clock, const uint8_t, const uint8_t) : m_divider(128) {
+    for (uint8_t divider = 2; divider <= 128; divider *= 2) {
+        if (clock >= F_CPU / divider) {
+            m_divider = divider;
+            break;
+        }
+    }
+}
+
+SPISettings::SPISettings() : SPISettings(4000000, MSBFIRST, SPI_MODE0) {}
+
+SPIClass SPI;
+
+void SPIClass::begin() {
+    // SS is pulled high only if it is not already an output, as the AVR library does
+    if (!(*portModeRegister(digitalPinToPort(SS)) & digitalPinToBitMask(SS))) {
+        digitalWrite(SS, HIGH);
+    }
+    pinMode(SS, OUTPUT);
+    pinMode(SCK, OUTPUT);
+    pinMode(MOSI, OUTPUT);
+}
+
+void SPIClass::end() {}
+
+void SPIClass::beginTransaction(const SPISettings settings) { spi_divider = settings.m_divider; }
+
+void SPIClass::endTransaction() {}
+
+uint8_t SPIClass::transfer(const uint8_t data) {
+    hal::Advance((8UL * spi_divider * 1000000UL) / F_CPU);
+    return (spi_device != nullptr) ? spi_device(data) : 0xFF;
+}
+
+namespace hal {
+
+void SetSPIDevice(const SPIDevice device) { spi_device = device; }
+
+}  // namespace hal
@@ -0,0 +1,51 @@
+#pragma once
+
+/**
+ * Host version of the Arduino SPI library.
+ *
+ * Transfers go to a device model set with hal::SetSPIDevice() and advance the virtual clock by eight SPI clocks.
+ * The SPI clock is the fastest of F_CPU / 2 to F_CPU / 128 not above the one asked for, as on the AVR.
+ */
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings {
+   public:
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode);
+    SPISettings();
+
+   private:
+    uint8_t m_divider;
+
+    friend class SPIClass;
+};
+
+class SPIClass {
+   public:
+    void begin();
+    void end();
+    void beginTransaction(SPISettings settings);
+    void endTransaction();
+    uint8_t transfer(uint8_t data);
+};
+
+extern SPIClass SPI;
+
+namespace hal {
+
+/**
+ * @brief SPI device model: takes the byte shifted out on MOSI and returns the byte shifted in on MISO.
+ */
+typedef uint8_t (*SPIDevice)(uint8_t mosi);
+
+/**
+ * @brief Connect a device model to the SPI bus, nullptr for none (MISO reads 0xFF).
+ */
+void SetSPIDevice(SPIDevice device);
+
+}  // namespace hal
@@ -0,0 +1,14 @@
+#pragma once
+
+/**
+ * Host version of the avr-libc EEPROM byte access: EEMEM variables are ordinary RAM, so they keep their
+ * value for the run of the program and start out zero instead of erased.
+ */
+
+#include <Arduino.h>
+
+#define EEMEM
+
+inline uint8_t eeprom_read_byte(const uint8_t *address) { return *address; }
+
+inline void eeprom_update_byte(uint8_t *address, uint8_t value) { *address = value; }
@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * Host version of avr-libc atomic blocks: interrupts are masked in the simulated SREG for the duration
+ * of the block and the previous state is restored on exit.
+ */
+
+#include <Arduino.h>
+
+#define ATOMIC_RESTORESTATE uint8_t hal_sreg_save __attribute__((__cleanup__(hal_RestoreState))) = SREG
+#define ATOMIC_FORCEON uint8_t hal_sreg_save __attribute__((__cleanup__(hal_ForceOn))) = 0
+
+inline void hal_RestoreState(const uint8_t *sreg) {
+    __asm__ __volatile__("" ::: "memory");
+    SREG = *sreg;
+}
+
+inline void hal_ForceOn(const uint8_t *) {
+    __asm__ __volatile__("" ::: "memory");
+    sei();
+}
+
+inline uint8_t hal_IrqOff() {
+    cli();
+    __asm__ __volatile__("" ::: "memory");
+    return 1;
+}
+
+#define ATOMIC_BLOCK(type) for (type, hal_atomic_once = hal_IrqOff(); hal_atomic_once; hal_atomic_once = 0)
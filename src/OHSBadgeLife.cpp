@@ -36,59 +36,20 @@
 */
 #include <Arduino.h>
 
+#include "BadgeEvent.h"
+#include "ButtonGesture.h"
+#include "Debounce.h"
+#include "EventQueue.h"
+#include "OHS2024Badge.h"
+#include "Oscillator.h"
+
 // Pin Definitions
 // ===============
 
 #define MODE_BUTTON_PIN 26
 
-#define LED_PIN_HEAD_RIGHT 23
-#define LED_PIN_HEAD_TOP 4
-#define LED_PIN_HEAD_LEFT 3
-
-#define LED_PIN_EYE_RIGHT 19
-#define LED_PIN_EYE_LEFT 15
-
-#define LED_PIN_BODY_RIGHT 18
-#define LED_PIN_BODY_CENTER 17
-#define LED_PIN_BODY_LEFT 16
-
-#define COLOR_PIN_RED 2
-#define COLOR_PIN_GREEN 1
-#define COLOR_PIN_BLUE 0
-
-// LED Index
-// =========
-
-#define LED_HEAD_RIGHT 0
-#define LED_HEAD_TOP 1
-#define LED_HEAD_LEFT 2
-
-#define LED_EYE_LEFT 3
-#define LED_EYE_RIGHT 4
-
-#define LED_BODY_RIGHT 5
-#define LED_BODY_CENTER 6
-#define LED_BODY_LEFT 7
-
-#define NUM_LEDS 8
-
-// LED functions
-// =============
-
-void SetColor(int red, int green, int blue);
-void SetColorBrightness(int red, int green, int blue, int brightness);
-
-void TurnOnLed(int index);
-void TurnOffLed(int index);
-
-void TurnOnHeadLEDs();
-void TurnOffHeadLEDs();
-
-void TurnOnEyeLEDs();
-void TurnOffEyeLEDs();
-
-void TurnOnBodyLEDs();
-void TurnOffBodyLEDs();
+// badge LED control
+OHS2024Badge badge = {};
 
 // Animations
 // ==========
@@ -97,244 +58,164 @@ void TurnOffBodyLEDs();
 #define ANIM_NUM_MODES 3
 int anim_mode = 0;
 
-// button debounce
-#define DEBOUNCE_MAX_STEPS 10
-bool ButtonDebounce(int button_input);
-
-// polling timer at 20 milliseconds (50 times per second)
-#define TIMER_STEP_MS 20
-uint32_t timer_prev;
-
-void setup() {
-    // PWM cathodes to HIGH
-    pinMode(COLOR_PIN_RED, OUTPUT);
-    digitalWrite(COLOR_PIN_RED, HIGH);
-    pinMode(COLOR_PIN_GREEN, OUTPUT);
-    digitalWrite(COLOR_PIN_GREEN, HIGH);
-    pinMode(COLOR_PIN_BLUE, OUTPUT);
-    digitalWrite(COLOR_PIN_BLUE, HIGH);
-
-    // Anodes to LOW
-    pinMode(LED_PIN_HEAD_RIGHT, OUTPUT);
-    digitalWrite(LED_PIN_HEAD_RIGHT, LOW);
-    pinMode(LED_PIN_HEAD_TOP, OUTPUT);
-    digitalWrite(LED_PIN_HEAD_TOP, LOW);
-    pinMode(LED_PIN_HEAD_LEFT, OUTPUT);
-    digitalWrite(LED_PIN_HEAD_LEFT, LOW);
-
-    pinMode(LED_PIN_EYE_RIGHT, OUTPUT);
-    digitalWrite(LED_PIN_EYE_RIGHT, LOW);
-    pinMode(LED_PIN_EYE_LEFT, OUTPUT);
-    digitalWrite(LED_PIN_EYE_LEFT, LOW);
-
-    pinMode(LED_PIN_BODY_RIGHT, OUTPUT);
-    digitalWrite(LED_PIN_BODY_RIGHT, LOW);
-    pinMode(LED_PIN_BODY_CENTER, OUTPUT);
-    digitalWrite(LED_PIN_BODY_CENTER, LOW);
-    pinMode(LED_PIN_BODY_LEFT, OUTPUT);
-    digitalWrite(LED_PIN_BODY_LEFT, LOW);
-
-    // Button mode
-    pinMode(MODE_BUTTON_PIN, INPUT_PULLUP);
-
-    // Start with eyes on
-    TurnOffBodyLEDs();
-    TurnOffHeadLEDs();
-    TurnOnEyeLEDs();
-
-    // Start with green
-    SetColor(0, 200, 50);
-
-    // timer begin
-    timer_prev = millis();
+// LEDs lit in each animation mode
+const byte anim_mode_leds[ANIM_NUM_MODES] = {
+    OHS2024BadgeLEDMask::Eyes,
+    OHS2024BadgeLEDMask::Body,
+    OHS2024BadgeLEDMask::Head,
+};
+
+// Color and brightness, long press and hold change brightness
+const OHS2024BadgeColor anim_color = {0, 200, 50};
+#define ANIM_BRIGHTNESS_STEP 16
+uint8_t anim_brightness = UINT8_MAX;
+bool anim_brightness_up = false;
+
+// Breathing, advanced on every frame tick
+#define ANIM_BREATHING_PERIOD_MS 2000
+Oscillator anim_breathing = {};
+
+void AnimApplyColor() {
+    const uint16_t level = ((anim_brightness + 1) * (anim_breathing.Quad() + 1)) >> 8;
+    badge.SetColor((anim_color.r * level) >> 8, (anim_color.g * level) >> 8, (anim_color.b * level) >> 8);
 }
 
-void loop() {
-    // get mode button input
-    bool button_pressed = ButtonDebounce(digitalRead(MODE_BUTTON_PIN));
-
-    // run timer
-    uint32_t now = millis();
-    uint32_t elapsed = now - timer_prev;
-    if (elapsed >= TIMER_STEP_MS) {
-        // advance timer
-        timer_prev = timer_prev + TIMER_STEP_MS;
-
-        // process mode button press
-        if (button_pressed) {
-            // button pressed: go to next animation mode
-            anim_mode = (anim_mode + 1) % ANIM_NUM_MODES;
-            // transition state
-            switch (anim_mode) {
-                case 0:
-                    // Transition to Eyes
-                    TurnOffBodyLEDs();
-                    TurnOffHeadLEDs();
-                    TurnOnEyeLEDs();
-                    break;
-
-                case 1:
-                    // Transition to Body
-                    TurnOffEyeLEDs();
-                    TurnOffHeadLEDs();
-                    TurnOnBodyLEDs();
-                    break;
-
-                case 2:
-                    // Transition to Head
-                    TurnOffBodyLEDs();
-                    TurnOffEyeLEDs();
-                    TurnOnHeadLEDs();
-                    break;
-
-                default:
-                    break;
-            }
-        }
-
-        // TODO: animate color
+void AnimStepBrightness() {
+    if (anim_brightness_up) {
+        anim_brightness =
+            (anim_brightness > UINT8_MAX - ANIM_BRIGHTNESS_STEP) ? UINT8_MAX : anim_brightness + ANIM_BRIGHTNESS_STEP;
+    } else {
+        anim_brightness = (anim_brightness < ANIM_BRIGHTNESS_STEP) ? 0 : anim_brightness - ANIM_BRIGHTNESS_STEP;
     }
+    AnimApplyColor();
 }
 
-void SetColorBrightness(int red, int green, int blue, int brightness) {
-    red = (constrain(red, 0, 255) * constrain(brightness, 0, 255)) / 255;
-    green = (constrain(green, 0, 255) * constrain(brightness, 0, 255)) / 255;
-    blue = (constrain(blue, 0, 255) * constrain(brightness, 0, 255)) / 255;
-    analogWrite(COLOR_PIN_RED, red);
-    analogWrite(COLOR_PIN_GREEN, green);
-    analogWrite(COLOR_PIN_BLUE, blue);
+void AnimSetMode(int mode) {
+    anim_mode = mode;
+    // transition state in a single update
+    badge.SetLEDMask(anim_mode_leds[anim_mode]);
 }
 
-void SetColor(int red, int green, int blue) {
-    red = 255 - constrain(red, 0, 255);
-    green = 255 - constrain(green, 0, 255);
-    blue = 255 - constrain(blue, 0, 255);
-    analogWrite(COLOR_PIN_RED, red);
-    analogWrite(COLOR_PIN_GREEN, green);
-    analogWrite(COLOR_PIN_BLUE, blue);
-}
+// events from interrupts to the main loop
+EventQueue<BadgeEvent, 16> events = {};
 
-void TurnOnLed(int index) {
-    switch (index) {
-        case LED_HEAD_RIGHT:
-            digitalWrite(LED_PIN_HEAD_RIGHT, HIGH);
-            break;
-        case LED_HEAD_TOP:
-            digitalWrite(LED_PIN_HEAD_TOP, HIGH);
-            break;
-        case LED_HEAD_LEFT:
-            digitalWrite(LED_PIN_HEAD_LEFT, HIGH);
-            break;
-        case LED_EYE_RIGHT:
-            digitalWrite(LED_PIN_EYE_RIGHT, HIGH);
-            break;
-        case LED_EYE_LEFT:
-            digitalWrite(LED_PIN_EYE_LEFT, HIGH);
-            break;
-        case LED_BODY_RIGHT:
-            digitalWrite(LED_PIN_BODY_RIGHT, HIGH);
-            break;
-        case LED_BODY_CENTER:
-            digitalWrite(LED_PIN_BODY_CENTER, HIGH);
-            break;
-        case LED_BODY_LEFT:
-            digitalWrite(LED_PIN_BODY_LEFT, HIGH);
-            break;
-        default:
-            break;
+// button debounce, ticked from Timer0 compare A every 2.048 ms
+#define DEBOUNCE_MAX_STEPS 10
+Debounce debounce = {};
+
+// button gestures, recognized from the debounced state on every Timer0 tick
+ButtonGesture gesture = {};
+
+// badge event for each ButtonGestureEvent
+const BadgeEventType gesture_events[] = {
+    BadgeEventType::None,
+    BadgeEventType::ButtonClick,
+    BadgeEventType::ButtonDoubleClick,
+    BadgeEventType::ButtonLongPress,
+    BadgeEventType::ButtonHoldRepeat,
+};
+
+// Timer0 compare A period: prescaler 64, 256 counts
+#define TIMER0_TICK_US (64UL * 256UL / (F_CPU / 1000000UL))
+
+// frame tick every 10 Timer0 ticks (20.48 milliseconds, about 49 times per second)
+#define FRAME_TICKS 10
+uint8_t frame_ticks = 0;
+
+ISR(TIMER0_COMPA_vect) {
+    debounce.Tick();
+    if (debounce.TakeActivated()) {
+        events.Push({BadgeEventType::ButtonDown, 0});
+    }
+    if (debounce.TakeDeactivated()) {
+        events.Push({BadgeEventType::ButtonUp, 0});
+    }
+    const ButtonGestureEvent gesture_event = gesture.Update(debounce.GetState(), millis());
+    if (gesture_event != ButtonGestureEvent::None) {
+        events.Push({gesture_events[static_cast<uint8_t>(gesture_event)], 0});
     }
-}
 
-void TurnOffLed(int index) {
-    switch (index) {
-        case LED_HEAD_RIGHT:
-            digitalWrite(LED_PIN_HEAD_RIGHT, LOW);
-            break;
-        case LED_HEAD_TOP:
-            digitalWrite(LED_PIN_HEAD_TOP, LOW);
-            break;
-        case LED_HEAD_LEFT:
-            digitalWrite(LED_PIN_HEAD_LEFT, LOW);
-            break;
-        case LED_EYE_RIGHT:
-            digitalWrite(LED_PIN_EYE_RIGHT, LOW);
-            break;
-        case LED_EYE_LEFT:
-            digitalWrite(LED_PIN_EYE_LEFT, LOW);
-            break;
-        case LED_BODY_RIGHT:
-            digitalWrite(LED_PIN_BODY_RIGHT, LOW);
-            break;
-        case LED_BODY_CENTER:
-            digitalWrite(LED_PIN_BODY_CENTER, LOW);
-            break;
-        case LED_BODY_LEFT:
-            digitalWrite(LED_PIN_BODY_LEFT, LOW);
-            break;
-        default:
-            break;
+    frame_ticks++;
+    if (frame_ticks >= FRAME_TICKS) {
+        frame_ticks = 0;
+        events.Push({BadgeEventType::FrameTick, 0});
     }
 }
 
-void TurnOnHeadLEDs() {
-    digitalWrite(LED_PIN_HEAD_RIGHT, HIGH);
-    digitalWrite(LED_PIN_HEAD_TOP, HIGH);
-    digitalWrite(LED_PIN_HEAD_LEFT, HIGH);
+// mode button pin 26 is PE3, on pin-change interrupt 3
+ISR(PCINT3_vect) {
+    debounce.Wake();
 }
 
-void TurnOffHeadLEDs() {
-    digitalWrite(LED_PIN_HEAD_RIGHT, LOW);
-    digitalWrite(LED_PIN_HEAD_TOP, LOW);
-    digitalWrite(LED_PIN_HEAD_LEFT, LOW);
-}
+void setup() {
+    // PWM cathodes to HIGH, anodes to LOW
+    badge.Setup();
 
-void TurnOnEyeLEDs() {
-    digitalWrite(LED_PIN_EYE_RIGHT, HIGH);
-    digitalWrite(LED_PIN_EYE_LEFT, HIGH);
-}
-void TurnOffEyeLEDs() {
-    digitalWrite(LED_PIN_EYE_RIGHT, LOW);
-    digitalWrite(LED_PIN_EYE_LEFT, LOW);
-}
+    // perceptual brightness curve so fades look even
+    OHS2024BadgeColorCorrection correction = {};
+    correction.curve_red = ColorCurve::Cie1931;
+    correction.curve_green = ColorCurve::Cie1931;
+    correction.curve_blue = ColorCurve::Cie1931;
+    badge.SetColorCorrection(correction);
 
-void TurnOnBodyLEDs() {
-    digitalWrite(LED_PIN_BODY_RIGHT, HIGH);
-    digitalWrite(LED_PIN_BODY_CENTER, HIGH);
-    digitalWrite(LED_PIN_BODY_LEFT, HIGH);
-}
-void TurnOffBodyLEDs() {
-    digitalWrite(LED_PIN_BODY_RIGHT, LOW);
-    digitalWrite(LED_PIN_BODY_CENTER, LOW);
-    digitalWrite(LED_PIN_BODY_LEFT, LOW);
+    // 10-bit PWM at 7.8 kHz on Timer3/Timer4: no flicker on camera or against the refresh scan
+    badge.StartHardwarePWM(10);
+
+    // Button mode
+    pinMode(MODE_BUTTON_PIN, INPUT_PULLUP);
+    DebounceConfiguration debounce_config = {};
+    debounce_config.pin = MODE_BUTTON_PIN;
+    debounce_config.polarity = HIGH;
+    debounce_config.max_count = DEBOUNCE_MAX_STEPS;
+    debounce.Setup(debounce_config);
+    debounce.EnableWakeOnChange();
+    gesture.Setup(ButtonGestureConfiguration{});
+
+    // Timer0 already runs for millis(), add its compare A interrupt halfway through each overflow
+    OCR0A = 0x80;
+    TIMSK0 |= _BV(OCIE0A);
+
+    // Start with eyes on
+    AnimSetMode(0);
+
+    // Start with green, breathing from the top of the wave
+    anim_breathing.SetPeriod(ANIM_BREATHING_PERIOD_MS * 1000UL, FRAME_TICKS * TIMER0_TICK_US);
+    anim_breathing.SetPhase(UINT32_MAX / 2);
+    AnimApplyColor();
 }
 
-bool ButtonDebounce(int button_input) {
-    static int button_prev = HIGH;
-    static int button_steps = 0;
-
-    bool button_pressed = false;
-    if (button_prev == HIGH) {
-        if (button_input == LOW) {
-            button_steps++;
-            if (button_steps > DEBOUNCE_MAX_STEPS) {
-                button_pressed = true;
-                button_prev = LOW;
-                button_steps = 0;
-            }
-        } else if (button_steps > 0) {
-            button_steps--;
-        }
-    } else {
-        if (button_input == HIGH) {
-            button_steps++;
-            if (button_steps > DEBOUNCE_MAX_STEPS) {
-                button_prev = HIGH;
-                button_steps = 0;
-            }
-        } else if (button_steps > 0) {
-            button_steps--;
+void loop() {
+    // handle events posted by interrupts
+    BadgeEvent event;
+    while (events.Pop(event)) {
+        switch (event.type) {
+            case BadgeEventType::ButtonClick:
+                // click: go to next animation mode
+                AnimSetMode((anim_mode + 1) % ANIM_NUM_MODES);
+                break;
+
+            case BadgeEventType::ButtonDoubleClick:
+                // double click: go to previous animation mode
+                AnimSetMode((anim_mode + ANIM_NUM_MODES - 1) % ANIM_NUM_MODES);
+                break;
+
+            case BadgeEventType::ButtonLongPress:
+                // long press: reverse brightness direction, then step while held
+                anim_brightness_up = !anim_brightness_up;
+                AnimStepBrightness();
+                break;
+
+            case BadgeEventType::ButtonHoldRepeat:
+                AnimStepBrightness();
+                break;
+
+            case BadgeEventType::FrameTick:
+                anim_breathing.Tick();
+                AnimApplyColor();
+                break;
+
+            default:
+                break;
         }
     }
-
-    return button_pressed;
-}
\ No newline at end of file
+}
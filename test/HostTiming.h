@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+
+/**
+ * @brief Host nanoseconds per call of a function, fastest of five runs.
+ *
+ * @param function Function to call.
+ * @param rounds Calls in each run.
+ */
+template <typename Function>
+double TimeCalls(Function function, const uint32_t rounds) {
+    double best = 0;
+    for (uint8_t run = 0; run < 5; run++) {
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t n = 0; n < rounds; n++) {
+            function();
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        const double ns = elapsed.count() / rounds;
+        best = ((run == 0) || (ns < best)) ? ns : best;
+    }
+    return best;
+}
@@ -0,0 +1,214 @@
+// Every DefaultBadge animation must render a frame and return: no Update() may advance the virtual clock or
+// step more frames than BadgeAnimationFrames() allows, and the press of the mode button must be displayed
+// within button_response_us.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include <chrono>
+#include <vector>
+
+#include "BadgeAnimation.h"
+#include "Debounce.h"
+#include "OHS2024Badge.h"
+
+// examples/DefaultBadge
+extern OHS2024Badge badge;
+extern Debounce mode_button;
+
+namespace {
+
+constexpr uint32_t run_ms = 30000;
+constexpr uint32_t num_frames = run_ms / badge_animation_frame_ms;
+constexpr uint8_t num_runs = 3;
+
+// Frames BadgeAnimationFrames() steps at most in one Update()
+constexpr uint8_t max_frames_per_update = 4;
+// Every stall_period frames the next Update() comes stall_ms late, so the effects have frames to catch up on
+constexpr uint32_t stall_period = 500;
+constexpr uint32_t stall_ms = 1000;
+
+// Press to first displayed frame rendered after it
+constexpr uint32_t button_response_us = 20000;
+constexpr uint8_t button_pin = 26;
+// virtual time charged for each loop() call
+constexpr uint32_t loop_us = 100;
+
+struct BudgetResult {
+    uint32_t blocked_frames = 0;
+    uint32_t worst_draws = 0;
+    double worst_ns = 0;
+    double mean_ns = 0;
+};
+
+/**
+ * @brief Render every frame of an animation and take the cost of each Update().
+ *
+ * The random() draws of each call are counted in virtual time; the host time of each call is the minimum
+ * over num_runs identical runs and is only reported.
+ */
+template <typename Animation, typename Configure>
+BudgetResult Measure(Configure configure) {
+    std::vector<double> frame_ns(num_frames, 1e12);
+    BudgetResult result;
+    for (uint8_t run = 0; run < num_runs; run++) {
+        hal::Reset();
+        randomSeed(1);
+        Animation animation;
+        configure(animation);
+        animation.Start(0);
+        OHS2024BadgeColor pixels[static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs)] = {};
+
+        uint32_t now = 0;
+        for (uint32_t frame = 0; frame < num_frames; frame++) {
+            now += badge_animation_frame_ms + (((frame % stall_period) == 0) ? stall_ms : 0);
+            const uint64_t cycles = hal::GetCycles();
+            const uint32_t draws = hal::GetRandomDraws();
+            const auto start = std::chrono::steady_clock::now();
+            animation.Update(now, pixels);
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            if (elapsed.count() < frame_ns[frame]) {
+                frame_ns[frame] = elapsed.count();
+            }
+            if (run == 0) {
+                if (hal::GetCycles() != cycles) {
+                    result.blocked_frames++;
+                }
+                if (hal::GetRandomDraws() - draws > result.worst_draws) {
+                    result.worst_draws = hal::GetRandomDraws() - draws;
+                }
+            }
+        }
+    }
+
+    double total_ns = 0;
+    for (const double ns : frame_ns) {
+        total_ns += ns;
+        if (ns > result.worst_ns) {
+            result.worst_ns = ns;
+        }
+    }
+    result.mean_ns = total_ns / num_frames;
+    return result;
+}
+
+/**
+ * @brief Check that no Update() blocked or drew more than draws_per_frame values for each frame it may step.
+ */
+void CheckBudget(const char *name, const BudgetResult &result, const uint32_t draws_per_frame) {
+    char message[128];
+    snprintf(message, sizeof(message), "%s: worst %lu draws, %.0f ns, mean %.0f ns per Update()", name,
+             static_cast<unsigned long>(result.worst_draws), result.worst_ns, result.mean_ns);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, result.blocked_frames, name);
+    TEST_ASSERT_TRUE_MESSAGE(result.worst_draws <= max_frames_per_update * draws_per_frame, name);
+}
+
+/**
+ * @brief Run the sketch, press the button at press_us and return the time until the press is displayed.
+ */
+uint32_t MeasureResponse(const uint32_t press_us) {
+    hal::Reset();
+    hal::SetRecording(false);
+    setup();
+    while (micros() < press_us) {
+        loop();
+        hal::Advance(loop_us);
+    }
+    hal::SetInput(button_pin, LOW);
+    const uint32_t start_us = micros();
+
+    // the pass that registers the press renders and presents at once
+    while (!mode_button.GetState()) {
+        loop();
+        hal::Advance(loop_us);
+        TEST_ASSERT_TRUE(micros() - start_us < 1000000);
+    }
+    TEST_ASSERT_TRUE(badge.IsPresentPending());
+
+    // shown once the refresh interrupt swaps it in
+    while (badge.IsPresentPending()) {
+        hal::Advance(loop_us);
+    }
+    const uint32_t response_us = micros() - start_us;
+    hal::SetInput(button_pin, HIGH);
+    return response_us;
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_group_cycles() {
+    CheckBudget("group cycle", Measure<GroupCycleAnimation>([](GroupCycleAnimation &cycle) {
+                    cycle.Setup(100, {255, 0, 0}, false);
+                }),
+                0);
+    CheckBudget("random cycle", Measure<GroupCycleAnimation>([](GroupCycleAnimation &cycle) {
+                    cycle.Setup(150, {}, true);
+                }),
+                3);
+}
+
+void test_fireworks() {
+    // a chance draw each frame, and a burst draws channels, peak, position and a velocity per spark
+    CheckBudget("fast fireworks", Measure<FireworkAnimation>([](FireworkAnimation &fireworks) {
+                    FireworkConfiguration config = {};
+                    config.chance = 4;
+                    config.sparks = 3;
+                    config.max_speed = 48;
+                    config.decay = 40;
+                    fireworks.Setup(config);
+                }),
+                1 + 3 + 3);
+    // a burst on every frame keeps the spark pool full
+    CheckBudget("fireworks, full pool", Measure<FireworkAnimation>([](FireworkAnimation &fireworks) {
+                    FireworkConfiguration config = {};
+                    config.chance = 1;
+                    config.sparks = FireworkAnimation::max_sparks;
+                    config.decay = 4;
+                    fireworks.Setup(config);
+                }),
+                1 + 3 + FireworkAnimation::max_sparks);
+}
+
+void test_twinkle_and_strand() {
+    CheckBudget("twinkle", Measure<TwinkleAnimation>([](TwinkleAnimation &twinkle) { twinkle.Setup(1); }), 2);
+    CheckBudget("strand", Measure<StrandAnimation>([](StrandAnimation &strand) { strand.Setup(2); }), 0);
+}
+
+void test_boot_and_self_test() {
+    CheckBudget("boot", Measure<BootAnimation>([](BootAnimation &) {}), 0);
+    CheckBudget("self-test", Measure<SelfTestAnimation>([](SelfTestAnimation &) {}), 0);
+}
+
+void test_button_response() {
+    // press at 0.3 ms steps over 15 ms, covering every phase of the 2 ms debounce samples and 5 ms scan
+    // frames, both during the boot sequence and in a mode
+    const uint32_t starts_us[] = {500000, 4000000};
+    uint32_t worst_us = 0;
+    for (const uint32_t start_us : starts_us) {
+        for (uint32_t offset_us = 0; offset_us < 15000; offset_us += 300) {
+            const uint32_t response_us = MeasureResponse(start_us + offset_us);
+            worst_us = (response_us > worst_us) ? response_us : worst_us;
+        }
+    }
+    char message[64];
+    snprintf(message, sizeof(message), "button press to display: worst %lu us",
+             static_cast<unsigned long>(worst_us));
+    TEST_MESSAGE(message);
+    TEST_ASSERT_LESS_THAN(button_response_us, worst_us);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_group_cycles);
+    RUN_TEST(test_fireworks);
+    RUN_TEST(test_twinkle_and_strand);
+    RUN_TEST(test_boot_and_self_test);
+    RUN_TEST(test_button_response);
+    return UNITY_END();
+}
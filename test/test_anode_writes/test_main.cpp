@@ -0,0 +1,186 @@
+// Port-register anode writes: same pin levels as per-pin digitalWrite with fewer register writes and less host time.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include <chrono>
+
+#include "OHS2024Badge.h"
+
+namespace {
+
+/**
+ * @brief The anode writes OHS2024Badge made before it resolved ports: a digitalWrite per pin.
+ */
+class DigitalWriteAnodes {
+   public:
+    void TurnOnHeadLEDs() { Write(m_pins.head_right, m_pins.head_top, m_pins.head_left, HIGH); }
+    void TurnOffHeadLEDs() { Write(m_pins.head_right, m_pins.head_top, m_pins.head_left, LOW); }
+    void TurnOnEyeLEDs() { Write(m_pins.eye_right, m_pins.eye_left, no_pin, HIGH); }
+    void TurnOffEyeLEDs() { Write(m_pins.eye_right, m_pins.eye_left, no_pin, LOW); }
+    void TurnOnBodyLEDs() { Write(m_pins.body_right, m_pins.body_center, m_pins.body_left, HIGH); }
+    void TurnOffBodyLEDs() { Write(m_pins.body_right, m_pins.body_center, m_pins.body_left, LOW); }
+
+    uint32_t GetWrites() const { return m_writes; }
+
+   private:
+    static constexpr uint8_t no_pin = 0xFF;
+
+    void Write(const uint8_t a, const uint8_t b, const uint8_t c, const uint8_t level) {
+        const uint8_t pins[] = {a, b, c};
+        for (const uint8_t pin : pins) {
+            if (pin != no_pin) {
+                digitalWrite(pin, level);
+                m_writes++;
+            }
+        }
+    }
+
+    OHS2024BadgePins m_pins = OHS2024BadgePins();
+    uint32_t m_writes = 0;
+};
+
+// Group operations in the order the benchmark cycles through them
+enum class GroupOp : uint8_t { HeadOn, HeadOff, EyesOn, EyesOff, BodyOn, BodyOff, NumOps };
+
+void Apply(OHS2024Badge &anodes, const GroupOp op) {
+    switch (op) {
+        case GroupOp::HeadOn: anodes.TurnOnHeadLEDs(); break;
+        case GroupOp::HeadOff: anodes.TurnOffHeadLEDs(); break;
+        case GroupOp::EyesOn: anodes.TurnOnEyeLEDs(); break;
+        case GroupOp::EyesOff: anodes.TurnOffEyeLEDs(); break;
+        case GroupOp::BodyOn: anodes.TurnOnBodyLEDs(); break;
+        default: anodes.TurnOffBodyLEDs(); break;
+    }
+}
+
+void Apply(DigitalWriteAnodes &anodes, const GroupOp op) {
+    switch (op) {
+        case GroupOp::HeadOn: anodes.TurnOnHeadLEDs(); break;
+        case GroupOp::HeadOff: anodes.TurnOffHeadLEDs(); break;
+        case GroupOp::EyesOn: anodes.TurnOnEyeLEDs(); break;
+        case GroupOp::EyesOff: anodes.TurnOffEyeLEDs(); break;
+        case GroupOp::BodyOn: anodes.TurnOnBodyLEDs(); break;
+        default: anodes.TurnOffBodyLEDs(); break;
+    }
+}
+
+const uint8_t anode_pins[] = {23, 4, 3, 19, 15, 18, 17, 16};
+
+// Output register of each port in the simulated data space
+volatile uint8_t *const ports[] = {&PORTB, &PORTC, &PORTD, &PORTE};
+
+uint8_t AnodeLevels() {
+    hal::Advance(0);
+    uint8_t levels = 0;
+    for (uint8_t i = 0; i < sizeof(anode_pins); i++) {
+        levels |= hal::GetOutput(anode_pins[i]) << i;
+    }
+    return levels;
+}
+
+// Nanoseconds per group operation over a fixed sequence
+template <typename Anodes>
+double TimeGroupOps(Anodes &anodes) {
+    constexpr uint32_t rounds = 20000;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < rounds; n++) {
+        for (uint8_t op = 0; op < static_cast<uint8_t>(GroupOp::NumOps); op++) {
+            Apply(anodes, static_cast<GroupOp>(op));
+        }
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (rounds * static_cast<uint8_t>(GroupOp::NumOps));
+}
+
+}  // namespace
+
+void setUp() {
+    hal::Reset();
+}
+
+void tearDown() {}
+
+void test_backends_drive_the_same_levels() {
+    OHS2024Badge port_anodes;
+    port_anodes.Setup();
+    DigitalWriteAnodes digital_anodes;
+
+    // every pair of group operations, starting with all LEDs off
+    for (uint8_t first = 0; first < static_cast<uint8_t>(GroupOp::NumOps); first++) {
+        for (uint8_t second = 0; second < static_cast<uint8_t>(GroupOp::NumOps); second++) {
+            Apply(digital_anodes, static_cast<GroupOp>(first));
+            Apply(digital_anodes, static_cast<GroupOp>(second));
+            const uint8_t expected = AnodeLevels();
+            port_anodes.SetLEDMask(OHS2024BadgeLEDMask::None);
+            digital_anodes.TurnOffHeadLEDs();
+            digital_anodes.TurnOffEyeLEDs();
+            digital_anodes.TurnOffBodyLEDs();
+
+            Apply(port_anodes, static_cast<GroupOp>(first));
+            Apply(port_anodes, static_cast<GroupOp>(second));
+            TEST_ASSERT_EQUAL_HEX8(expected, AnodeLevels());
+            TEST_ASSERT_EQUAL_HEX8(expected, port_anodes.GetLEDMask());
+            port_anodes.SetLEDMask(OHS2024BadgeLEDMask::None);
+        }
+    }
+}
+
+void test_group_calls_change_each_port_once() {
+    OHS2024Badge port_anodes;
+    port_anodes.Setup();
+    DigitalWriteAnodes digital_anodes;
+
+    // ports changed by one call of each group, from all off; the 328PB pinout puts the head on two ports
+    const GroupOp ops[] = {GroupOp::HeadOn, GroupOp::EyesOn, GroupOp::BodyOn};
+    const uint8_t expected_ports[] = {2, 1, 1};
+    const uint8_t expected_digital_writes[] = {3, 2, 3};
+    char message[96];
+    for (uint8_t k = 0; k < 3; k++) {
+        port_anodes.SetLEDMask(OHS2024BadgeLEDMask::None);
+        uint8_t before[4];
+        for (uint8_t p = 0; p < 4; p++) {
+            before[p] = *ports[p];
+        }
+        Apply(port_anodes, ops[k]);
+        uint8_t changed = 0;
+        for (uint8_t p = 0; p < 4; p++) {
+            changed += (*ports[p] != before[p]) ? 1 : 0;
+        }
+
+        const uint32_t writes = digital_anodes.GetWrites();
+        Apply(digital_anodes, ops[k]);
+        const uint32_t digital_writes = digital_anodes.GetWrites() - writes;
+
+        snprintf(message, sizeof(message), "group %u: %u ports changed, %u digitalWrite calls", k, changed,
+                 static_cast<unsigned>(digital_writes));
+        TEST_MESSAGE(message);
+        TEST_ASSERT_EQUAL_UINT8(expected_ports[k], changed);
+        TEST_ASSERT_EQUAL_UINT32(expected_digital_writes[k], digital_writes);
+    }
+}
+
+void test_benchmark_group_calls() {
+    hal::SetRecording(false);
+    OHS2024Badge port_anodes;
+    port_anodes.Setup();
+    DigitalWriteAnodes digital_anodes;
+
+    const double port_ns = TimeGroupOps(port_anodes);
+    const double digital_ns = TimeGroupOps(digital_anodes);
+
+    char message[96];
+    snprintf(message, sizeof(message), "host ns per group call: port %.1f, digitalWrite %.1f", port_ns,
+             digital_ns);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(port_ns < digital_ns);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_backends_drive_the_same_levels);
+    RUN_TEST(test_group_calls_change_each_port_once);
+    RUN_TEST(test_benchmark_group_calls);
+    return UNITY_END();
+}
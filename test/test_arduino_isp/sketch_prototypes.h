@@ -0,0 +1,9 @@
+// Prototypes the Arduino builder generates for examples/ArduinoISP: functions the sketch calls before their
+// definition. Included inside each namespace the sketch is built in, so there is no include guard.
+
+void flash_service();
+void avrisp();
+uint8_t write_eeprom_chunk(unsigned int start, unsigned int length);
+void write_eeprom_bytes(unsigned int start, unsigned int length);
+void write_eeprom_pages(unsigned int start, unsigned int length);
+void eeprom_wait();
@@ -0,0 +1,630 @@
+// examples/ArduinoISP writing and reading a simulated ATmega328PB for a host that sends what avrdude sends.
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include <vector>
+
+// hardware SPI, as on the AVR boards the sketch runs on
+#define ARDUINO_ARCH_AVR
+
+namespace isp_default {
+#include "sketch_prototypes.h"
+#include "../../examples/ArduinoISP/ArduinoISP.ino"
+}  // namespace isp_default
+
+#undef PAGE_BUFFERS
+#define ARDUINOISP_SINGLE_PAGE_BUFFER
+namespace isp_single {
+#include "sketch_prototypes.h"
+#include "../../examples/ArduinoISP/ArduinoISP.ino"
+}  // namespace isp_single
+#undef ARDUINOISP_SINGLE_PAGE_BUFFER
+#undef PAGE_BUFFERS
+
+#undef SPI_CLOCK
+#undef BAUDRATE
+#define ARDUINOISP_FAST
+namespace isp_fast {
+#include "sketch_prototypes.h"
+#include "../../examples/ArduinoISP/ArduinoISP.ino"
+}  // namespace isp_fast
+
+void setUp();
+
+namespace {
+
+struct Sketch {
+    const char *name;
+    unsigned long baud;
+    void (*setup)();
+    void (*loop)();
+    int *isp_error;
+};
+
+const Sketch sketch_default = {"default", 19200, isp_default::setup, isp_default::loop, &isp_default::ISPError};
+const Sketch sketch_single = {"single buffer", 19200, isp_single::setup, isp_single::loop, &isp_single::ISPError};
+const Sketch sketch_fast = {"fast", 115200, isp_fast::setup, isp_fast::loop, &isp_fast::ISPError};
+
+// RESET of the sketch, held low while the target is programmed
+constexpr uint8_t target_reset_pin = 10;
+
+constexpr uint32_t flash_size = 32768;
+constexpr uint32_t flash_block = 128;
+constexpr uint32_t eeprom_size = 1024;
+constexpr uint32_t eeprom_block = 4;
+
+uint32_t Now() { return static_cast<uint32_t>(hal::GetCycles() / (F_CPU / 1000000UL)); }
+
+/**
+ * @brief ATmega328PB serial programming, see "Serial Downloading" in the datasheet.
+ */
+struct Target {
+    static constexpr uint32_t flash_words = flash_size / 2;
+    static constexpr uint8_t flash_page_words = 64;
+    static constexpr uint8_t eeprom_page_size = 4;
+    static constexpr uint32_t flash_write_us = 4500;
+    static constexpr uint32_t eeprom_write_us = 3600;
+    static constexpr uint32_t erase_us = 9000;
+
+    struct EepromPageWrite {
+        uint16_t page;
+        uint8_t loaded;  // bit per byte of the page buffer loaded since the last page write
+    };
+
+    uint16_t flash[flash_words];
+    uint16_t page_buffer[flash_page_words];
+    uint8_t eeprom[eeprom_size];
+    uint8_t eeprom_buffer[eeprom_page_size];
+    uint8_t eeprom_loaded;
+    uint8_t fuses[4];  // low, high, extended, lock
+
+    bool enabled;
+    uint8_t instruction[4];
+    uint8_t index;
+    uint64_t busy_until;
+
+    std::vector<uint32_t> flash_commit_us;
+    std::vector<EepromPageWrite> eeprom_page_writes;
+    uint32_t eeprom_byte_writes;
+    uint32_t violations;
+
+    void Reset() {
+        memset(flash, 0xFF, sizeof(flash));
+        memset(page_buffer, 0xFF, sizeof(page_buffer));
+        memset(eeprom, 0xFF, sizeof(eeprom));
+        eeprom_loaded = 0;
+        const uint8_t default_fuses[4] = {0x62, 0xD9, 0xF7, 0xFF};
+        memcpy(fuses, default_fuses, sizeof(fuses));
+        enabled = false;
+        index = 0;
+        busy_until = 0;
+        flash_commit_us.clear();
+        eeprom_page_writes.clear();
+        eeprom_byte_writes = 0;
+        violations = 0;
+    }
+
+    bool Busy() const { return hal::GetCycles() < busy_until; }
+
+    void StartWrite(const uint32_t us) { busy_until = hal::GetCycles() + us * (F_CPU / 1000000UL); }
+
+    uint8_t Transfer(const uint8_t mosi) {
+        if (hal::GetOutput(target_reset_pin) == HIGH) {
+            enabled = false;
+            index = 0;
+            return 0xFF;
+        }
+        instruction[index] = mosi;
+        if (index < 3) {
+            // each byte comes back while the next one is shifted in
+            const uint8_t echo = (index > 0) ? instruction[index - 1] : 0;
+            index++;
+            return echo;
+        }
+        index = 0;
+        return Execute();
+    }
+
+    // act on a complete instruction, returning its fourth output byte
+    uint8_t Execute() {
+        const uint8_t *in = instruction;
+        const uint16_t address = (in[1] << 8) | in[2];
+        if (!enabled) {
+            enabled = (in[0] == 0xAC) && (in[1] == 0x53);
+            return in[2];
+        }
+        if (in[0] == 0xF0) {
+            return Busy() ? 0x01 : 0x00;
+        }
+        if (Busy()) {
+            violations++;
+            return 0xFF;
+        }
+        switch (in[0]) {
+            case 0xAC:
+                if (in[1] == 0x80) {
+                    memset(flash, 0xFF, sizeof(flash));
+                    memset(eeprom, 0xFF, sizeof(eeprom));
+                    StartWrite(erase_us);
+                } else {
+                    const uint8_t fuse = (in[1] == 0xA0) ? 0 : (in[1] == 0xA8) ? 1 : (in[1] == 0xA4) ? 2 : 3;
+                    fuses[fuse] = in[3];
+                    StartWrite(flash_write_us);
+                }
+                return in[2];
+            case 0x30: {
+                const uint8_t signature[3] = {0x1E, 0x95, 0x16};
+                return signature[in[2] % 3];
+            }
+            case 0x50:
+                return fuses[(in[1] == 0x08) ? 2 : 0];
+            case 0x58:
+                return fuses[(in[1] == 0x08) ? 1 : 3];
+            case 0x38:
+                return 0x9A;
+            case 0x40:
+                page_buffer[address % flash_page_words] = (page_buffer[address % flash_page_words] & 0xFF00) | in[3];
+                return in[2];
+            case 0x48:
+                page_buffer[address % flash_page_words] =
+                    (page_buffer[address % flash_page_words] & 0x00FF) | (in[3] << 8);
+                return in[2];
+            case 0x4C: {
+                // programming only clears bits
+                const uint32_t page = (address % flash_words) & ~(flash_page_words - 1U);
+                for (uint8_t i = 0; i < flash_page_words; i++) {
+                    flash[page + i] &= page_buffer[i];
+                    page_buffer[i] = 0xFFFF;
+                }
+                flash_commit_us.push_back(Now());
+                StartWrite(flash_write_us);
+                return in[2];
+            }
+            case 0x20:
+                return flash[address % flash_words] & 0xFF;
+            case 0x28:
+                return flash[address % flash_words] >> 8;
+            case 0xC0:
+                eeprom[address % eeprom_size] = in[3];
+                eeprom_byte_writes++;
+                StartWrite(eeprom_write_us);
+                return in[2];
+            case 0xC1:
+                eeprom_buffer[address % eeprom_page_size] = in[3];
+                eeprom_loaded |= 1 << (address % eeprom_page_size);
+                return in[2];
+            case 0xC2: {
+                const uint16_t page = (address % eeprom_size) & ~(eeprom_page_size - 1U);
+                for (uint8_t i = 0; i < eeprom_page_size; i++) {
+                    if (eeprom_loaded & (1 << i)) {
+                        eeprom[page + i] = eeprom_buffer[i];
+                    }
+                }
+                eeprom_page_writes.push_back({page, eeprom_loaded});
+                eeprom_loaded = 0;
+                StartWrite(eeprom_write_us);
+                return in[2];
+            }
+            case 0xA0:
+                return eeprom[address % eeprom_size];
+            default:
+                violations++;
+                return 0xFF;
+        }
+    }
+};
+
+Target target;
+
+uint8_t TargetTransfer(const uint8_t mosi) { return target.Transfer(mosi); }
+
+/**
+ * @brief Serial line as the host sees it: a command goes out a fixed latency after the last reply arrived.
+ */
+class Link {
+   public:
+    Link(const Sketch &sketch, const uint32_t latency_us)
+        : m_sketch(sketch), m_latency_us(latency_us), m_ready_us(Now()) {}
+
+    /**
+     * @brief Send a command and run the programmer until the reply is complete.
+     *
+     * @return False if the reply took longer than a second.
+     */
+    bool Transact(const std::vector<uint8_t> &command, uint8_t *reply, const uint32_t reply_length) {
+        const uint32_t start_us = m_ready_us + m_latency_us;
+        hal::SendSerial(command.data(), command.size(), start_us);
+        uint32_t received = 0;
+        while (received < reply_length) {
+            if (Now() > start_us + 1000000UL) {
+                return false;
+            }
+            m_sketch.loop();
+            received += hal::TakeSerial(reply + received, reply_length - received, &m_ready_us);
+        }
+        round_trips++;
+        return true;
+    }
+
+    /**
+     * @brief Let the host wait before its next command.
+     */
+    void Wait(const uint32_t us) { m_ready_us += us; }
+
+    /**
+     * @brief Virtual time the last reply was complete.
+     */
+    uint32_t GetReadyTime() const { return m_ready_us; }
+
+    uint32_t round_trips = 0;
+
+   private:
+    const Sketch &m_sketch;
+    uint32_t m_latency_us;
+    uint32_t m_ready_us;
+};
+
+enum class Memory { Flash, Eeprom };
+
+/**
+ * @brief Commands avrdude -c stk500v1 sends to program an ATmega328PB.
+ */
+class Avrdude {
+   public:
+    explicit Avrdude(Link &link) : m_link(link) {}
+
+    /**
+     * @brief Sign on, pass the device parameters and enter programming mode.
+     *
+     * @param polling RDY/BSY polling flag of the device parameters.
+     * @param extended Send the extended parameters with the EEPROM page size.
+     */
+    void Begin(const bool polling = true, const bool extended = true) {
+        V1({'0'}, nullptr, 0);
+        // devicecode, revision, progtype, parmode, polling, selftimed, lockbytes, fusebytes, flash poll values,
+        // EEPROM poll values, page size, EEPROM size and flash size
+        V1({'B', 0x86, 0x00, 0x00, 0x01, polling ? uint8_t(1) : uint8_t(0), 0x01, 0x01, 0x03, 0xFF, 0xFF, 0xFF, 0xFF,
+            0x00, flash_block, eeprom_size >> 8, eeprom_size & 0xFF, 0x00, 0x00, flash_size >> 8, 0x00},
+           nullptr, 0);
+        if (extended) {
+            // length, EEPROM page size, PAGEL, BS2, reset disposition
+            V1({'E', 0x05, eeprom_block, 0xD7, 0xC2, 0x00}, nullptr, 0);
+        }
+        V1({'P'}, nullptr, 0);
+    }
+
+    void Erase() {
+        uint8_t result;
+        V1({'V', 0xAC, 0x80, 0x00, 0x00}, &result, 1);
+        // avrdude sleeps for the chip erase delay
+        m_link.Wait(Target::erase_us);
+    }
+
+    /**
+     * @brief Write memory a block at a time, each block with its own load address.
+     */
+    void Write(const Memory memory, const uint32_t address, const uint8_t *data, const uint32_t length,
+               const uint32_t block) {
+        for (uint32_t offset = 0; offset < length; offset += block) {
+            const uint32_t size = (length - offset < block) ? length - offset : block;
+            LoadAddress(memory, address + offset);
+            WriteBlock(memory, data + offset, size);
+            write_replies_us.push_back(m_link.GetReadyTime());
+        }
+    }
+
+    /**
+     * @brief Read memory a block at a time, each block with its own load address.
+     */
+    void Read(const Memory memory, const uint32_t address, uint8_t *data, const uint32_t length, const uint32_t block) {
+        for (uint32_t offset = 0; offset < length; offset += block) {
+            const uint32_t size = (length - offset < block) ? length - offset : block;
+            LoadAddress(memory, address + offset);
+            ReadBlock(memory, data + offset, size);
+        }
+    }
+
+    void End() {
+        V1({'Q'}, nullptr, 0);
+    }
+
+    // replies that were missing, out of sync or not OK
+    uint32_t errors = 0;
+    // virtual time each block write was answered
+    std::vector<uint32_t> write_replies_us;
+
+   private:
+    void LoadAddress(const Memory memory, const uint32_t address) {
+        // word addresses
+        const uint32_t load = address / 2;
+        V1({'U', static_cast<uint8_t>(load & 0xFF), static_cast<uint8_t>(load >> 8)}, nullptr, 0);
+    }
+
+    void WriteBlock(const Memory memory, const uint8_t *data, const uint32_t size) {
+        const bool flash = (memory == Memory::Flash);
+        std::vector<uint8_t> command = {'d', static_cast<uint8_t>(size >> 8), static_cast<uint8_t>(size & 0xFF),
+                   flash ? uint8_t('F') : uint8_t('E')};
+        command.insert(command.end(), data, data + size);
+        V1(command, nullptr, 0);
+    }
+
+    void ReadBlock(const Memory memory, uint8_t *data, const uint32_t size) {
+        const bool flash = (memory == Memory::Flash);
+        V1({'t', static_cast<uint8_t>(size >> 8), static_cast<uint8_t>(size & 0xFF),
+            flash ? uint8_t('F') : uint8_t('E')},
+           data, size);
+    }
+
+    // STK500v1 command and its reply: STK_INSYNC, (length) bytes of data, STK_OK
+    void V1(std::vector<uint8_t> command, uint8_t *data, const uint32_t length) {
+        command.push_back(' ');
+        std::vector<uint8_t> reply(length + 2);
+        if (!m_link.Transact(command, reply.data(), reply.size()) || (reply.front() != 0x14) ||
+            (reply.back() != 0x10)) {
+            errors++;
+        }
+        if (data != nullptr) {
+            memcpy(data, &reply[1], length);
+        }
+    }
+
+    Link &m_link;
+};
+
+void Start(const Sketch &sketch, const unsigned long baud) {
+    sketch.setup();
+    Serial.begin(baud);
+    *sketch.isp_error = 0;
+}
+
+void FillRandom(uint8_t *data, const uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        data[i] = static_cast<uint8_t>(random(256));
+    }
+}
+
+bool FlashMatches(const uint8_t *image, const uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        const uint16_t word = target.flash[i / 2];
+        if (image[i] != ((i & 1) ? (word >> 8) : (word & 0xFF))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AssertClean(const Sketch &sketch, const Avrdude &avrdude) {
+    TEST_ASSERT_EQUAL_UINT32(0, avrdude.errors);
+    TEST_ASSERT_EQUAL_INT(0, *sketch.isp_error);
+    TEST_ASSERT_EQUAL_UINT32(0, target.violations);
+    TEST_ASSERT_EQUAL_UINT32(0, hal::GetSerialOverruns());
+}
+
+struct Timing {
+    uint32_t write_us;
+    uint32_t read_us;
+    uint32_t write_round_trips;
+    uint32_t read_round_trips;
+};
+
+/**
+ * @brief Write (length) bytes of (memory) from a fresh start and read them back, in avrdude's blocks.
+ *
+ * Times run from the first command to the last reply the host gets. The contents are checked.
+ */
+Timing TimeTransfer(const Sketch &sketch, const unsigned long baud, const uint32_t latency_us, const Memory memory,
+                    const uint32_t length, const bool polling = true, const bool extended = true) {
+    setUp();
+    Start(sketch, baud);
+    Link link(sketch, latency_us);
+    Avrdude avrdude(link);
+    static uint8_t image[flash_size];
+    static uint8_t read_back[flash_size];
+    FillRandom(image, length);
+    const uint32_t block = (memory == Memory::Flash) ? flash_block : eeprom_block;
+    avrdude.Begin(polling, extended);
+
+    Timing timing;
+    uint32_t start_us = link.GetReadyTime();
+    uint32_t start_round_trips = link.round_trips;
+    avrdude.Write(memory, 0, image, length, block);
+    timing.write_us = link.GetReadyTime() - start_us;
+    timing.write_round_trips = link.round_trips - start_round_trips;
+
+    start_us = link.GetReadyTime();
+    start_round_trips = link.round_trips;
+    avrdude.Read(memory, 0, read_back, length, block);
+    timing.read_us = link.GetReadyTime() - start_us;
+    timing.read_round_trips = link.round_trips - start_round_trips;
+    avrdude.End();
+
+    AssertClean(sketch, avrdude);
+    TEST_ASSERT_EQUAL_MEMORY(image, read_back, length);
+    return timing;
+}
+
+}  // namespace
+
+void setUp() {
+    hal::Reset();
+    hal::SetRecording(false);
+    hal::SetPollCost(2);
+    hal::OpenSerialLine();
+    hal::SetSPIDevice(TargetTransfer);
+    target.Reset();
+    randomSeed(1);
+}
+
+void tearDown() {}
+
+void test_flash_image_round_trip() {
+    const Sketch *sketches[] = {&sketch_default, &sketch_single, &sketch_fast};
+    for (const Sketch *sketch : sketches) {
+        setUp();
+        Start(*sketch, sketch->baud);
+        Link link(*sketch, 1000);
+        Avrdude avrdude(link);
+        static uint8_t image[4096];
+        static uint8_t read_back[sizeof(image)];
+        FillRandom(image, sizeof(image));
+
+        avrdude.Begin();
+        avrdude.Erase();
+        avrdude.Write(Memory::Flash, 0, image, sizeof(image), flash_block);
+        // the read right after the last page must see that page written
+        avrdude.Read(Memory::Flash, 0, read_back, sizeof(read_back), flash_block);
+        avrdude.End();
+
+        AssertClean(*sketch, avrdude);
+        TEST_ASSERT_TRUE(FlashMatches(image, sizeof(image)));
+        TEST_ASSERT_EQUAL_MEMORY(image, read_back, sizeof(image));
+        TEST_ASSERT_EQUAL_UINT32(sizeof(image) / flash_block, target.flash_commit_us.size());
+    }
+}
+
+void test_page_job_commits_after_reply() {
+    Start(sketch_default, sketch_default.baud);
+    Link link(sketch_default, 1000);
+    Avrdude avrdude(link);
+    uint8_t image[16 * flash_block];
+    FillRandom(image, sizeof(image));
+
+    avrdude.Begin();
+    avrdude.Write(Memory::Flash, 0, image, sizeof(image), flash_block);
+    avrdude.End();
+
+    AssertClean(sketch_default, avrdude);
+    TEST_ASSERT_TRUE(FlashMatches(image, sizeof(image)));
+    const uint32_t pages = sizeof(image) / flash_block;
+    TEST_ASSERT_EQUAL_UINT32(pages, target.flash_commit_us.size());
+    for (uint32_t page = 0; page < pages; page++) {
+        // answered as soon as received, then loaded and committed while the host sends the next page
+        TEST_ASSERT_GREATER_THAN_UINT32(avrdude.write_replies_us[page], target.flash_commit_us[page]);
+        if (page + 1 < pages) {
+            // and committed before the next page is taken into the other buffer
+            TEST_ASSERT_LESS_THAN_UINT32(avrdude.write_replies_us[page + 1], target.flash_commit_us[page]);
+        }
+    }
+}
+
+void test_polling_ends_waits_early() {
+    // 16 bytes of EEPROM written byte by byte, with and without RDY/BSY polling
+    const uint32_t length = 16;
+    const Timing polled = TimeTransfer(sketch_default, 115200, 1000, Memory::Eeprom, length, true, false);
+    TEST_ASSERT_EQUAL_UINT32(length, target.eeprom_byte_writes);
+    const Timing timed = TimeTransfer(sketch_default, 115200, 1000, Memory::Eeprom, length, false, false);
+    TEST_ASSERT_EQUAL_UINT32(length, target.eeprom_byte_writes);
+
+    // polled: each byte within 2 ms of the target's write time, never sooner
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(length * Target::eeprom_write_us, polled.write_us);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(length * (Target::eeprom_write_us + 2000), polled.write_us);
+    // without polling the sketch waits the worst case for every byte
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(length * TWD_EEPROM_US, timed.write_us);
+}
+
+void test_eeprom_writes_split_into_pages() {
+    Start(sketch_default, sketch_default.baud);
+    Link link(sketch_default, 1000);
+    Avrdude avrdude(link);
+    memset(target.eeprom, 0x5A, eeprom_size);
+    uint8_t data[9];
+    FillRandom(data, sizeof(data));
+
+    avrdude.Begin();
+    // one write of bytes 6 to 14: the end of the page at 4, the page at 8 and the start of the page at 12
+    avrdude.Write(Memory::Eeprom, 6, data, sizeof(data), sizeof(data));
+    avrdude.End();
+
+    AssertClean(sketch_default, avrdude);
+    TEST_ASSERT_EQUAL_UINT32(0, target.eeprom_byte_writes);
+    const Target::EepromPageWrite expected[] = {{4, 0x0C}, {8, 0x0F}, {12, 0x07}};
+    TEST_ASSERT_EQUAL_UINT32(3, target.eeprom_page_writes.size());
+    for (uint8_t i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_UINT16(expected[i].page, target.eeprom_page_writes[i].page);
+        TEST_ASSERT_EQUAL_HEX8(expected[i].loaded, target.eeprom_page_writes[i].loaded);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(data, &target.eeprom[6], sizeof(data));
+    // the rest of the partly written pages is left alone
+    TEST_ASSERT_EQUAL_HEX8(0x5A, target.eeprom[4]);
+    TEST_ASSERT_EQUAL_HEX8(0x5A, target.eeprom[5]);
+    TEST_ASSERT_EQUAL_HEX8(0x5A, target.eeprom[15]);
+}
+
+void test_eeprom_byte_writes_without_page_size() {
+    Start(sketch_default, sketch_default.baud);
+    Link link(sketch_default, 1000);
+    Avrdude avrdude(link);
+    uint8_t data[9];
+    FillRandom(data, sizeof(data));
+
+    // no extended parameters, so no EEPROM page size
+    avrdude.Begin(true, false);
+    avrdude.Write(Memory::Eeprom, 6, data, sizeof(data), sizeof(data));
+    avrdude.End();
+
+    AssertClean(sketch_default, avrdude);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(data), target.eeprom_byte_writes);
+    TEST_ASSERT_EQUAL_UINT32(0, target.eeprom_page_writes.size());
+    TEST_ASSERT_EQUAL_MEMORY(data, &target.eeprom[6], sizeof(data));
+}
+
+void test_report_flash_times() {
+    struct Row {
+        const Sketch *sketch;
+        unsigned long baud;
+        uint32_t latency_us;
+    };
+    const Row rows[] = {
+        {&sketch_single, 19200, 1000},   {&sketch_default, 19200, 1000},   {&sketch_single, 19200, 16000},
+        {&sketch_default, 19200, 16000}, {&sketch_single, 115200, 1000},   {&sketch_default, 115200, 1000},
+        {&sketch_fast, 115200, 1000},    {&sketch_fast, 115200, 16000},
+    };
+    for (const Row &row : rows) {
+        const Timing timing = TimeTransfer(*row.sketch, row.baud, row.latency_us, Memory::Flash, flash_size);
+        char message[160];
+        snprintf(message, sizeof(message),
+                 "%s, %lu baud, %lu ms latency: 32 KB flash write %.1f s, read %.1f s (%lu B/s), %lu + %lu round trips",
+                 row.sketch->name, row.baud, static_cast<unsigned long>(row.latency_us / 1000), timing.write_us / 1e6,
+                 timing.read_us / 1e6, static_cast<unsigned long>(flash_size * 1000000ULL / timing.read_us),
+                 static_cast<unsigned long>(timing.write_round_trips),
+                 static_cast<unsigned long>(timing.read_round_trips));
+        TEST_MESSAGE(message);
+    }
+}
+
+void test_report_eeprom_times() {
+    struct Row {
+        const Sketch *sketch;
+        const char *name;
+        bool polling;
+        bool extended;
+    };
+    const Row rows[] = {
+        {&sketch_default, "fixed wait, byte writes", false, false},
+        {&sketch_default, "polled, byte writes", true, false},
+        {&sketch_default, "polled, page writes", true, true},
+    };
+    for (const Row &row : rows) {
+        const Timing timing =
+            TimeTransfer(*row.sketch, 115200, 1000, Memory::Eeprom, eeprom_size, row.polling, row.extended);
+        char message[160];
+        snprintf(message, sizeof(message), "%s, 115200 baud, 1 ms latency, %s: 1 KB EEPROM write %.1f s, read %.1f s",
+                 row.sketch->name, row.name, timing.write_us / 1e6, timing.read_us / 1e6);
+        TEST_MESSAGE(message);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_flash_image_round_trip);
+    RUN_TEST(test_page_job_commits_after_reply);
+    RUN_TEST(test_polling_ends_waits_early);
+    RUN_TEST(test_eeprom_writes_split_into_pages);
+    RUN_TEST(test_eeprom_byte_writes_without_page_size);
+    RUN_TEST(test_report_flash_times);
+    RUN_TEST(test_report_eeprom_times);
+    return UNITY_END();
+}
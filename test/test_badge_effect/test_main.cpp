@@ -0,0 +1,394 @@
+// BadgeTransition weights and BadgeEffectPlayer mode cycling, saved mode and effect state.
+//
+// Transition weights must start at exactly 0 on every LED, rise without stepping back, and reach exactly
+// 255 by the end, so the first and last frames are the outgoing and incoming frames unchanged. The wipe
+// must run from the top of the head down to the body. The player is driven through a registry of
+// recording test effects: Next() and Previous() wrap around the modes, the mode is saved to and resumed
+// from an EEMEM byte, one-shot effects hand over to their next effect and then back to the mode that was
+// running, and effect state is constructed afresh in one of two fixed slots every time an effect starts.
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include "BadgeEffect.h"
+#include "BadgeTransition.h"
+
+namespace {
+
+constexpr uint8_t num_leds = static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs);
+
+// Start() calls of the test effects, in order
+struct StartRecord {
+    uint8_t id;
+    const void *state;
+    // frames the effect had rendered when it started, 0 if it was constructed afresh
+    uint8_t frames;
+};
+StartRecord starts[64];
+uint8_t num_starts = 0;
+
+void RecordStart(const uint8_t id, const void *state, const uint8_t frames) {
+    if (num_starts < sizeof(starts) / sizeof(starts[0])) {
+        starts[num_starts++] = {id, state, frames};
+    }
+}
+
+OHS2024BadgeColor ColorOf(const uint8_t id) { return OHS2024BadgeColor(40 * id + 20, 255 - 30 * id, 7 * id); }
+
+// Runs until another effect starts, every LED in the colour of its id
+template <uint8_t Id, uint8_t Padding>
+struct ModeAnimation {
+    uint8_t frames = 0;
+    uint8_t padding[Padding] = {};
+
+    void Start(uint32_t) { RecordStart(Id, this, frames); }
+    void Update(uint32_t, OHS2024BadgeColor *pixels) {
+        frames++;
+        for (uint8_t i = 0; i < num_leds; i++) {
+            pixels[i] = ColorOf(Id);
+        }
+    }
+};
+
+// Done after DurationMs
+template <uint8_t Id, uint16_t DurationMs>
+struct OnceAnimation {
+    uint8_t frames = 0;
+    uint32_t start_time = 0;
+    uint32_t time = 0;
+
+    void Start(uint32_t now) {
+        RecordStart(Id, this, frames);
+        start_time = now;
+        time = now;
+    }
+    void Update(uint32_t now, OHS2024BadgeColor *pixels) {
+        frames++;
+        time = now;
+        for (uint8_t i = 0; i < num_leds; i++) {
+            pixels[i] = ColorOf(Id);
+        }
+    }
+    bool IsDone() const { return (time - start_time) >= DurationMs; }
+};
+
+// three modes of different state sizes, then a one-shot that resumes and one that hands over to it
+constexpr uint8_t num_modes = 3;
+constexpr uint8_t effect_resuming = 3;
+constexpr uint8_t effect_chained = 4;
+constexpr BadgeEffect effects[] PROGMEM = {
+    MakeBadgeEffect<ModeAnimation<0, 1>>(num_leds, BadgeTransitionType::Crossfade),
+    MakeBadgeEffect<ModeAnimation<1, 20>>(num_leds, BadgeTransitionType::Wipe),
+    MakeBadgeEffect<ModeAnimation<2, 5>>(num_leds, BadgeTransitionType::Dissolve),
+    MakeBadgeEffectOnce<OnceAnimation<3, 100>>(1, BadgeTransitionType::Crossfade, badge_effect_resume),
+    MakeBadgeEffectOnce<OnceAnimation<4, 50>>(1, BadgeTransitionType::Crossfade, effect_resuming),
+};
+constexpr uint8_t num_effects = sizeof(effects) / sizeof(effects[0]);
+static_assert(BadgeEffectMaxStateSize(effects) == sizeof(ModeAnimation<1, 20>), "largest state sizes the player");
+
+using Player = BadgeEffectPlayer<BadgeEffectMaxStateSize(effects)>;
+
+// erased EEPROM
+uint8_t saved_mode EEMEM = 0xFF;
+
+BadgeEffectPlayerConfiguration MakeConfig(const uint16_t transition_ms) {
+    BadgeEffectPlayerConfiguration config = {};
+    config.effects = effects;
+    config.num_effects = num_effects;
+    config.num_modes = num_modes;
+    config.default_mode = 1;
+    config.saved_mode = &saved_mode;
+    config.transition_ms = transition_ms;
+    return config;
+}
+
+bool SameFrame(const OHS2024BadgeColor *a, const OHS2024BadgeColor *b) {
+    for (uint8_t i = 0; i < num_leds; i++) {
+        if (!(a[i] == b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AssertAllWeights(const BadgeTransition &transition, const uint8_t weight) {
+    for (uint8_t i = 0; i < num_leds; i++) {
+        TEST_ASSERT_EQUAL_UINT8(weight, transition.GetWeight(static_cast<OHS2024BadgeLED>(i)));
+    }
+}
+
+}  // namespace
+
+void setUp() {
+    hal::Reset();
+    randomSeed(3);
+    num_starts = 0;
+    saved_mode = 0xFF;
+}
+
+void tearDown() {}
+
+void test_transition_weights_reach_endpoints() {
+    const BadgeTransitionType types[] = {BadgeTransitionType::Crossfade, BadgeTransitionType::Wipe,
+                                         BadgeTransitionType::Dissolve};
+    const uint16_t durations[] = {1, 20, 255, 256, 600, 1000, 65279};
+    const uint32_t start = 123456;
+    for (const BadgeTransitionType type : types) {
+        for (const uint16_t duration : durations) {
+            BadgeTransition transition;
+            transition.Start(type, duration, start);
+            TEST_ASSERT_TRUE(transition.IsActive());
+            TEST_ASSERT_TRUE(transition.Update(start));
+            AssertAllWeights(transition, 0);
+
+            uint8_t previous[num_leds] = {};
+            for (uint32_t elapsed = 1; elapsed < duration; elapsed++) {
+                TEST_ASSERT_TRUE(transition.Update(start + elapsed));
+                for (uint8_t i = 0; i < num_leds; i++) {
+                    const uint8_t weight = transition.GetWeight(static_cast<OHS2024BadgeLED>(i));
+                    TEST_ASSERT_GREATER_OR_EQUAL(previous[i], weight);
+                    previous[i] = weight;
+                }
+            }
+            // a millisecond is at most 1/256 of the longer durations, so the last one is all incoming
+            if (duration >= 256) {
+                AssertAllWeights(transition, 255);
+            }
+            // ended at the duration, the incoming frame is shown alone
+            TEST_ASSERT_FALSE(transition.Update(start + duration));
+            TEST_ASSERT_FALSE(transition.IsActive());
+        }
+    }
+
+    // zero duration ends on the first update
+    BadgeTransition transition;
+    transition.Start(BadgeTransitionType::Crossfade, 0, start);
+    TEST_ASSERT_FALSE(transition.Update(start));
+}
+
+void test_blend_at_endpoints_is_exact() {
+    OHS2024BadgeColor outgoing[num_leds];
+    OHS2024BadgeColor incoming[num_leds];
+    for (uint8_t i = 0; i < num_leds; i++) {
+        outgoing[i] = OHS2024BadgeColor(255 - i, 3 * i, 128 + i);
+        incoming[i] = OHS2024BadgeColor(17 * i, 255, i);
+    }
+    BadgeTransition transition;
+    transition.Start(BadgeTransitionType::Wipe, 600, 0);
+    OHS2024BadgeColor pixels[num_leds];
+
+    transition.Update(0);
+    memcpy(pixels, incoming, sizeof(pixels));
+    transition.Blend(outgoing, pixels);
+    TEST_ASSERT_TRUE(SameFrame(outgoing, pixels));
+
+    transition.Update(599);
+    memcpy(pixels, incoming, sizeof(pixels));
+    transition.Blend(outgoing, pixels);
+    TEST_ASSERT_TRUE(SameFrame(incoming, pixels));
+}
+
+void test_wipe_runs_head_to_body() {
+    // each group is at least as far along as the next one down
+    const OHS2024BadgeLED order[][2] = {
+        {OHS2024BadgeLED::HeadTop, OHS2024BadgeLED::HeadTop},
+        {OHS2024BadgeLED::HeadRight, OHS2024BadgeLED::HeadLeft},
+        {OHS2024BadgeLED::EyeRight, OHS2024BadgeLED::EyeLeft},
+        {OHS2024BadgeLED::BodyRight, OHS2024BadgeLED::BodyLeft},
+        {OHS2024BadgeLED::BodyCenter, OHS2024BadgeLED::BodyCenter},
+    };
+    BadgeTransition transition;
+    transition.Start(BadgeTransitionType::Wipe, 600, 0);
+    bool split = false;
+    for (uint32_t now = 0; now < 600; now++) {
+        transition.Update(now);
+        for (uint8_t g = 0; g < 5; g++) {
+            // LEDs of a group move together
+            const uint8_t weight = transition.GetWeight(order[g][0]);
+            TEST_ASSERT_EQUAL_UINT8(weight, transition.GetWeight(order[g][1]));
+            if (g > 0) {
+                TEST_ASSERT_LESS_OR_EQUAL(transition.GetWeight(order[g - 1][0]), weight);
+            }
+        }
+        // the head top is done as the body center starts
+        split |= (transition.GetWeight(OHS2024BadgeLED::HeadTop) == 255) &&
+                 (transition.GetWeight(OHS2024BadgeLED::BodyCenter) <= 1);
+    }
+    TEST_ASSERT_TRUE(split);
+}
+
+void test_modes_cycle_and_wrap() {
+    Player player;
+    player.Setup(MakeConfig(0));
+    uint32_t now = 0;
+    player.Start(0, now, false);
+    const uint8_t forward[] = {1, 2, 0, 1};
+    for (const uint8_t index : forward) {
+        player.Next(now += 100);
+        TEST_ASSERT_EQUAL_UINT8(index, player.GetIndex());
+    }
+    const uint8_t backward[] = {0, 2, 1, 0, 2};
+    for (const uint8_t index : backward) {
+        player.Previous(now += 100);
+        TEST_ASSERT_EQUAL_UINT8(index, player.GetIndex());
+    }
+    // every change started the effect once
+    TEST_ASSERT_EQUAL_UINT8(1 + 4 + 5, num_starts);
+    TEST_ASSERT_EQUAL_UINT8(2, starts[num_starts - 1].id);
+
+    // out of range indices are ignored
+    player.Start(num_effects, now, false);
+    TEST_ASSERT_EQUAL_UINT8(2, player.GetIndex());
+}
+
+void test_render_fades_between_modes() {
+    Player player;
+    player.Setup(MakeConfig(600));
+    player.Start(0, 0, false);
+    OHS2024BadgeColor pixels[num_leds];
+    player.Render(0, pixels);
+    OHS2024BadgeColor expected[num_leds];
+    ModeAnimation<0, 1>().Update(0, expected);
+    TEST_ASSERT_TRUE(SameFrame(expected, pixels));
+    TEST_ASSERT_EQUAL_UINT8(num_leds, player.GetScanLength());
+
+    // blended on a slot per LED: the outgoing frame at the press, the incoming one once it ends
+    player.Next(1000);
+    player.Render(1000, pixels);
+    TEST_ASSERT_TRUE(SameFrame(expected, pixels));
+    TEST_ASSERT_EQUAL_UINT8(num_leds, player.GetScanLength());
+    player.Render(1300, pixels);
+    TEST_ASSERT_FALSE(SameFrame(expected, pixels));
+    player.Render(1600, pixels);
+    ModeAnimation<1, 20>().Update(0, expected);
+    TEST_ASSERT_TRUE(SameFrame(expected, pixels));
+    TEST_ASSERT_EQUAL_UINT8(num_leds, player.GetScanLength());
+}
+
+void test_mode_saved_and_resumed() {
+    // erased EEPROM: the default mode, and starting it saves it
+    Player player;
+    player.Setup(MakeConfig(0));
+    player.Start(badge_effect_resume, 0, false);
+    TEST_ASSERT_EQUAL_UINT8(1, player.GetIndex());
+    TEST_ASSERT_EQUAL_UINT8(1, eeprom_read_byte(&saved_mode));
+    player.Next(100);
+    TEST_ASSERT_EQUAL_UINT8(2, eeprom_read_byte(&saved_mode));
+
+    // one-shot effects are not modes and leave it alone
+    player.Start(effect_resuming, 200, false);
+    TEST_ASSERT_EQUAL_UINT8(2, eeprom_read_byte(&saved_mode));
+
+    // after a power cycle the saved mode is resumed
+    Player restarted;
+    restarted.Setup(MakeConfig(0));
+    restarted.Start(badge_effect_resume, 0, false);
+    TEST_ASSERT_EQUAL_UINT8(2, restarted.GetIndex());
+
+    // a byte that is not a mode falls back to the default
+    saved_mode = num_modes;
+    Player corrupted;
+    corrupted.Setup(MakeConfig(0));
+    corrupted.Start(badge_effect_resume, 0, false);
+    TEST_ASSERT_EQUAL_UINT8(1, corrupted.GetIndex());
+
+    // without an EEMEM byte nothing is saved
+    saved_mode = 0;
+    BadgeEffectPlayerConfiguration config = MakeConfig(0);
+    config.saved_mode = nullptr;
+    Player unsaved;
+    unsaved.Setup(config);
+    unsaved.Start(badge_effect_resume, 0, false);
+    TEST_ASSERT_EQUAL_UINT8(1, unsaved.GetIndex());
+    unsaved.Next(100);
+    TEST_ASSERT_EQUAL_UINT8(0, saved_mode);
+}
+
+void test_one_shot_returns_to_mode() {
+    const uint16_t transition_ms = 40;
+    Player player;
+    player.Setup(MakeConfig(transition_ms));
+    player.Start(2, 0, false);
+
+    // the chained effect hands over to the resuming one, which resumes mode 2
+    OHS2024BadgeColor pixels[num_leds];
+    player.Start(effect_chained, 1000, true);
+    uint32_t now = 1000;
+    uint8_t seen[num_effects] = {};
+    while (now < 1400) {
+        player.Render(now, pixels);
+        seen[player.GetIndex()] = 1;
+        now += 10;
+    }
+    TEST_ASSERT_EQUAL_UINT8(1, seen[effect_chained]);
+    TEST_ASSERT_EQUAL_UINT8(1, seen[effect_resuming]);
+    TEST_ASSERT_EQUAL_UINT8(2, player.GetIndex());
+    TEST_ASSERT_EQUAL_UINT8(2, starts[num_starts - 1].id);
+    TEST_ASSERT_EQUAL_UINT8(effect_resuming, starts[num_starts - 2].id);
+    TEST_ASSERT_EQUAL_UINT8(effect_chained, starts[num_starts - 3].id);
+
+    // a press during a one-shot skips to its next effect instead of cycling the modes
+    player.Start(effect_chained, now, true);
+    player.Next(now + 10);
+    TEST_ASSERT_EQUAL_UINT8(effect_resuming, player.GetIndex());
+    player.Next(now + 20);
+    TEST_ASSERT_EQUAL_UINT8(2, player.GetIndex());
+}
+
+void test_state_constructed_in_two_slots() {
+    Player player;
+    player.Setup(MakeConfig(600));
+    player.Start(0, 0, false);
+    OHS2024BadgeColor pixels[num_leds];
+
+    // every start, faded or not, reuses one of two state slots inside the player
+    uint32_t now = 0;
+    for (uint8_t n = 0; n < 12; n++) {
+        for (uint8_t frame = 0; frame < 5; frame++) {
+            player.Render(now += 20, pixels);
+        }
+        player.Next(now);
+    }
+    const uint8_t *begin = reinterpret_cast<const uint8_t *>(&player);
+    const uint8_t *end = begin + sizeof(player);
+    const void *slots[2] = {starts[0].state, nullptr};
+    for (uint8_t n = 0; n < num_starts; n++) {
+        const uint8_t *state = static_cast<const uint8_t *>(starts[n].state);
+        TEST_ASSERT_TRUE((state >= begin) && (state < end));
+        // constructed afresh, not left with the frames the previous occupant rendered
+        TEST_ASSERT_EQUAL_UINT8(0, starts[n].frames);
+        if ((state != slots[0]) && (slots[1] == nullptr)) {
+            slots[1] = state;
+        }
+        TEST_ASSERT_TRUE((state == slots[0]) || (state == slots[1]));
+        // a fade keeps the outgoing effect, so the incoming one takes the other slot
+        if (n > 0) {
+            TEST_ASSERT_TRUE(state != starts[n - 1].state);
+        }
+    }
+    TEST_ASSERT_NOT_NULL(slots[1]);
+    TEST_ASSERT_EQUAL(13, num_starts);
+
+    // without a fade the running slot is reused
+    num_starts = 0;
+    player.Start(1, now, false);
+    player.Render(now += 20, pixels);
+    player.Start(2, now, false);
+    TEST_ASSERT_TRUE(starts[0].state == starts[1].state);
+    TEST_ASSERT_EQUAL_UINT8(0, starts[1].frames);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_transition_weights_reach_endpoints);
+    RUN_TEST(test_blend_at_endpoints_is_exact);
+    RUN_TEST(test_wipe_runs_head_to_body);
+    RUN_TEST(test_modes_cycle_and_wrap);
+    RUN_TEST(test_render_fades_between_modes);
+    RUN_TEST(test_mode_saved_and_resumed);
+    RUN_TEST(test_one_shot_returns_to_mode);
+    RUN_TEST(test_state_constructed_in_two_slots);
+    return UNITY_END();
+}
@@ -0,0 +1,270 @@
+// BadgeScriptIsValid() rejections, and fades, loops and the per-tick operation cap of BadgeScriptAnimation.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include "../HostTiming.h"
+#include "BadgeScript.h"
+#include "Oscillator.h"
+
+namespace {
+
+constexpr uint8_t num_leds = static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs);
+
+// smallest valid script, the base of the invalid ones below
+constexpr uint8_t script_valid[] PROGMEM = {
+    BADGE_SCRIPT_WAIT(1),
+    BADGE_SCRIPT_END,
+};
+
+constexpr uint8_t script_bad_opcode[] PROGMEM = {
+    BADGE_SCRIPT_WAIT(1),
+    static_cast<uint8_t>(BadgeScriptOp::NumOps),
+    BADGE_SCRIPT_END,
+};
+
+// operands running past the end of the script
+constexpr uint8_t script_truncated[] PROGMEM = {
+    BADGE_SCRIPT_WAIT(1),
+    static_cast<uint8_t>(BadgeScriptOp::Fade),
+    255,
+    0,
+};
+
+constexpr uint8_t script_no_end[] PROGMEM = {
+    BADGE_SCRIPT_WAIT(1),
+};
+
+constexpr uint8_t script_after_end[] PROGMEM = {
+    BADGE_SCRIPT_WAIT(1),
+    BADGE_SCRIPT_END,
+    BADGE_SCRIPT_WAIT(1),
+};
+
+constexpr uint8_t script_unclosed_loop[] PROGMEM = {
+    BADGE_SCRIPT_LOOP(2),
+    BADGE_SCRIPT_WAIT(1),
+    BADGE_SCRIPT_END,
+};
+
+constexpr uint8_t script_stray_end_loop[] PROGMEM = {
+    BADGE_SCRIPT_WAIT(1),
+    BADGE_SCRIPT_END_LOOP,
+    BADGE_SCRIPT_END,
+};
+
+constexpr uint8_t script_too_deep[] PROGMEM = {
+    BADGE_SCRIPT_LOOP(2),     BADGE_SCRIPT_LOOP(2),     BADGE_SCRIPT_LOOP(2), BADGE_SCRIPT_WAIT(1),
+    BADGE_SCRIPT_END_LOOP,    BADGE_SCRIPT_END_LOOP,    BADGE_SCRIPT_END_LOOP, BADGE_SCRIPT_END,
+};
+
+constexpr uint8_t script_empty_random[] PROGMEM = {
+    BADGE_SCRIPT_RANDOM(OHS2024BadgeLEDMask::None),
+    BADGE_SCRIPT_WAIT(1),
+    BADGE_SCRIPT_END,
+};
+
+// never takes time, so a tick would only ever stop at the operation cap
+constexpr uint8_t script_untimed[] PROGMEM = {
+    BADGE_SCRIPT_COLOR(255, 0, 0),
+    BADGE_SCRIPT_WAIT(0),
+    BADGE_SCRIPT_FADE(0, 0, 0, 0),
+    BADGE_SCRIPT_END,
+};
+
+constexpr uint8_t script_fade[] PROGMEM = {
+    BADGE_SCRIPT_COLOR(10, 200, 0),
+    BADGE_SCRIPT_FADE(250, 0, 100, 10),
+    BADGE_SCRIPT_WAIT(5),
+    BADGE_SCRIPT_END,
+};
+static_assert(BadgeScriptIsValid(script_fade), "invalid script");
+
+// red, then green twice, three times over; then blue
+constexpr uint8_t script_nested_loops[] PROGMEM = {
+    BADGE_SCRIPT_LOOP(3),      BADGE_SCRIPT_COLOR(255, 0, 0), BADGE_SCRIPT_WAIT(1),
+    BADGE_SCRIPT_LOOP(2),      BADGE_SCRIPT_COLOR(0, 255, 0), BADGE_SCRIPT_WAIT(1),
+    BADGE_SCRIPT_END_LOOP,     BADGE_SCRIPT_END_LOOP,         BADGE_SCRIPT_COLOR(0, 0, 255),
+    BADGE_SCRIPT_WAIT(1),      BADGE_SCRIPT_END,
+};
+static_assert(BadgeScriptIsValid(script_nested_loops), "invalid script");
+
+// red counting up from 1 to 20 with no time between, then a tick of wait
+constexpr uint8_t script_many_ops[] PROGMEM = {
+    BADGE_SCRIPT_COLOR(1, 0, 0),  BADGE_SCRIPT_COLOR(2, 0, 0),  BADGE_SCRIPT_COLOR(3, 0, 0),
+    BADGE_SCRIPT_COLOR(4, 0, 0),  BADGE_SCRIPT_COLOR(5, 0, 0),  BADGE_SCRIPT_COLOR(6, 0, 0),
+    BADGE_SCRIPT_COLOR(7, 0, 0),  BADGE_SCRIPT_COLOR(8, 0, 0),  BADGE_SCRIPT_COLOR(9, 0, 0),
+    BADGE_SCRIPT_COLOR(10, 0, 0), BADGE_SCRIPT_COLOR(11, 0, 0), BADGE_SCRIPT_COLOR(12, 0, 0),
+    BADGE_SCRIPT_COLOR(13, 0, 0), BADGE_SCRIPT_COLOR(14, 0, 0), BADGE_SCRIPT_COLOR(15, 0, 0),
+    BADGE_SCRIPT_COLOR(16, 0, 0), BADGE_SCRIPT_COLOR(17, 0, 0), BADGE_SCRIPT_COLOR(18, 0, 0),
+    BADGE_SCRIPT_COLOR(19, 0, 0), BADGE_SCRIPT_COLOR(20, 0, 0), BADGE_SCRIPT_WAIT(1),
+    BADGE_SCRIPT_END,
+};
+static_assert(BadgeScriptIsValid(script_many_ops), "invalid script");
+
+// the eye breathing of examples/BadgeScript
+constexpr uint8_t script_breathing[] PROGMEM = {
+    BADGE_SCRIPT_MASK(OHS2024BadgeLEDMask::Eyes),
+    BADGE_SCRIPT_LOOP(0),
+    BADGE_SCRIPT_FADE(0, 200, 100, 25),
+    BADGE_SCRIPT_FADE(0, 0, 0, 25),
+    BADGE_SCRIPT_END_LOOP,
+    BADGE_SCRIPT_END,
+};
+static_assert(BadgeScriptIsValid(script_breathing), "invalid script");
+
+/**
+ * @brief Script animation started at time 0, ticked by hand.
+ */
+class Runner {
+   public:
+    explicit Runner(const uint8_t *script) {
+        m_script.Setup(script);
+        m_script.Start(0);
+    }
+
+    void Tick() { m_script.Tick(); }
+
+    // colour of one LED after the ticks so far
+    OHS2024BadgeColor Get(const OHS2024BadgeLED led) {
+        OHS2024BadgeColor pixels[num_leds] = {};
+        m_script.Update(0, pixels);
+        return pixels[static_cast<uint8_t>(led)];
+    }
+
+   private:
+    BadgeScriptAnimation m_script;
+};
+
+void AssertColor(const OHS2024BadgeColor &expected, const OHS2024BadgeColor &actual) {
+    TEST_ASSERT_EQUAL_UINT8(expected.r, actual.r);
+    TEST_ASSERT_EQUAL_UINT8(expected.g, actual.g);
+    TEST_ASSERT_EQUAL_UINT8(expected.b, actual.b);
+}
+
+}  // namespace
+
+void setUp() {
+    hal::Reset();
+}
+
+void tearDown() {}
+
+void test_validator_rejects_malformed_scripts() {
+    TEST_ASSERT_TRUE(BadgeScriptIsValid(script_valid));
+    TEST_ASSERT_FALSE(BadgeScriptIsValid(script_bad_opcode));
+    TEST_ASSERT_FALSE(BadgeScriptIsValid(script_truncated));
+    TEST_ASSERT_FALSE(BadgeScriptIsValid(script_no_end));
+    TEST_ASSERT_FALSE(BadgeScriptIsValid(script_after_end));
+    TEST_ASSERT_FALSE(BadgeScriptIsValid(script_unclosed_loop));
+    TEST_ASSERT_FALSE(BadgeScriptIsValid(script_stray_end_loop));
+    TEST_ASSERT_FALSE(BadgeScriptIsValid(script_too_deep));
+    TEST_ASSERT_FALSE(BadgeScriptIsValid(script_empty_random));
+    TEST_ASSERT_FALSE(BadgeScriptIsValid(script_untimed));
+}
+
+void test_fade_endpoints_and_ticks() {
+    const OHS2024BadgeColor from = {10, 200, 0};
+    const OHS2024BadgeColor to = {250, 0, 100};
+    // Start() runs the first tick of the fade
+    Runner runner(script_fade);
+    const OHS2024BadgeColor first = runner.Get(OHS2024BadgeLED::BodyCenter);
+    OHS2024BadgeColor previous = from;
+    for (uint8_t tick = 1; tick < 10; tick++) {
+        const OHS2024BadgeColor color = runner.Get(OHS2024BadgeLED::BodyCenter);
+        // moves towards the target every tick without reaching it
+        TEST_ASSERT_TRUE(color.r > previous.r);
+        TEST_ASSERT_TRUE(color.g < previous.g);
+        TEST_ASSERT_TRUE(color.b > previous.b);
+        TEST_ASSERT_TRUE(color.r < to.r);
+        previous = color;
+        runner.Tick();
+    }
+    // the last of the 10 ticks lands exactly on the target, then held for the 5 ticks of the wait
+    for (uint8_t tick = 0; tick < 1 + 5; tick++) {
+        AssertColor(to, runner.Get(OHS2024BadgeLED::BodyCenter));
+        runner.Tick();
+    }
+    // then the script restarts from the colour it sets, in the first tick of the fade again
+    AssertColor(first, runner.Get(OHS2024BadgeLED::BodyCenter));
+}
+
+void test_nested_loop_counts() {
+    const OHS2024BadgeColor red = {255, 0, 0};
+    const OHS2024BadgeColor green = {0, 255, 0};
+    const OHS2024BadgeColor blue = {0, 0, 255};
+    const OHS2024BadgeColor expected[] = {red, green, green, red, green, green, red, green, green, blue, red};
+    Runner runner(script_nested_loops);
+    for (const OHS2024BadgeColor &color : expected) {
+        AssertColor(color, runner.Get(OHS2024BadgeLED::HeadTop));
+        runner.Tick();
+    }
+}
+
+void test_ops_per_tick_cap() {
+    // the first tick stops after max_ops_per_tick colours, the next runs the rest up to the wait
+    Runner runner(script_many_ops);
+    TEST_ASSERT_EQUAL_UINT8(BadgeScriptAnimation::max_ops_per_tick, runner.Get(OHS2024BadgeLED::EyeLeft).r);
+    runner.Tick();
+    TEST_ASSERT_EQUAL_UINT8(20, runner.Get(OHS2024BadgeLED::EyeLeft).r);
+
+    // an unchecked script that never takes time still returns from every tick
+    Runner untimed(script_untimed);
+    for (uint8_t tick = 0; tick < 10; tick++) {
+        untimed.Tick();
+    }
+    AssertColor({0, 0, 0}, untimed.Get(OHS2024BadgeLED::EyeLeft));
+}
+
+void test_breathing_against_native() {
+    // black again after the 25-tick fade up and the 25-tick fade down, brightest halfway
+    Runner runner(script_breathing);
+    for (uint8_t tick = 1; tick < 25; tick++) {
+        runner.Tick();
+    }
+    AssertColor({0, 200, 100}, runner.Get(OHS2024BadgeLED::EyeRight));
+    for (uint8_t tick = 0; tick < 25; tick++) {
+        runner.Tick();
+    }
+    AssertColor({0, 0, 0}, runner.Get(OHS2024BadgeLED::EyeRight));
+
+    constexpr uint32_t rounds = 100000;
+    OHS2024BadgeColor pixels[num_leds] = {};
+    BadgeScriptAnimation script = {};
+    script.Setup(script_breathing);
+    script.Start(0);
+    uint32_t now = 0;
+    const double script_ns = TimeCalls(
+        [&script, &pixels, &now]() {
+            now += badge_animation_frame_ms;
+            script.Update(now, pixels);
+        },
+        rounds);
+
+    const OHS2024BadgeColor color = {0, 200, 100};
+    Oscillator breathing = {};
+    breathing.SetPeriod(1000, badge_animation_frame_ms);
+    const double native_ns = TimeCalls(
+        [&breathing, &pixels, &color]() {
+            breathing.Tick();
+            BadgeAnimationFill(pixels, OHS2024BadgeLEDMask::Eyes,
+                               Blend(OHS2024BadgeColor{}, color, breathing.Quad()));
+        },
+        rounds);
+
+    char message[96];
+    snprintf(message, sizeof(message), "host ns per breathing frame: script %.1f, native Oscillator %.1f", script_ns,
+             native_ns);
+    TEST_MESSAGE(message);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_validator_rejects_malformed_scripts);
+    RUN_TEST(test_fade_endpoints_and_ticks);
+    RUN_TEST(test_nested_loop_counts);
+    RUN_TEST(test_ops_per_tick_cap);
+    RUN_TEST(test_breathing_against_native);
+    return UNITY_END();
+}
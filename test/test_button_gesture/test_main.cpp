@@ -0,0 +1,168 @@
+// ButtonGesture events and the times they are reported, driven through Update() on a virtual millisecond clock.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "ButtonGesture.h"
+
+namespace {
+
+struct Reported {
+    ButtonGestureEvent event;
+    uint32_t ms;
+};
+
+/**
+ * @brief Drive a gesture recognizer with one button state for a while, updating every step_ms.
+ */
+class Driver {
+   public:
+    explicit Driver(const ButtonGestureConfiguration &config, const uint32_t step_ms = 1) : m_step_ms(step_ms) {
+        m_gesture.Setup(config);
+    }
+
+    // Button in one state from now until now + ms, updated at now, now + step, ... before the end
+    void Hold(const bool pressed, const uint32_t ms) {
+        const uint32_t end_ms = m_now_ms + ms;
+        while (m_now_ms < end_ms) {
+            const ButtonGestureEvent event = m_gesture.Update(pressed, m_now_ms);
+            if (event != ButtonGestureEvent::None) {
+                events.push_back({event, m_now_ms});
+            }
+            m_now_ms += m_step_ms;
+        }
+    }
+
+    void Reset() { m_gesture.Reset(); }
+
+    std::vector<Reported> events;
+
+   private:
+    ButtonGesture m_gesture;
+    uint32_t m_step_ms;
+    uint32_t m_now_ms = 0;
+};
+
+void AssertEvents(const std::vector<Reported> &expected, const std::vector<Reported> &actual) {
+    TEST_ASSERT_EQUAL_UINT32(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(expected[i].event), static_cast<uint8_t>(actual[i].event));
+        TEST_ASSERT_EQUAL_UINT32(expected[i].ms, actual[i].ms);
+    }
+}
+
+const ButtonGestureConfiguration defaults = ButtonGestureConfiguration();
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_click_waits_for_double_click_window() {
+    Driver driver(defaults);
+    driver.Hold(true, 100);
+    driver.Hold(false, 1000);
+    // released at 100, reported once the 300 ms window has passed
+    AssertEvents({{ButtonGestureEvent::Click, 400}}, driver.events);
+}
+
+void test_double_click_window_edge() {
+    // second press on the update where the 300 ms window ends
+    Driver inside(defaults);
+    inside.Hold(true, 100);
+    inside.Hold(false, 300);
+    inside.Hold(true, 100);
+    inside.Hold(false, 1000);
+    AssertEvents({{ButtonGestureEvent::DoubleClick, 400}}, inside.events);
+
+    // one update later the first click is already reported and the press starts a new one
+    Driver outside(defaults);
+    outside.Hold(true, 100);
+    outside.Hold(false, 301);
+    outside.Hold(true, 100);
+    outside.Hold(false, 1000);
+    AssertEvents({{ButtonGestureEvent::Click, 400}, {ButtonGestureEvent::Click, 801}}, outside.events);
+}
+
+void test_double_click_disabled() {
+    ButtonGestureConfiguration config;
+    config.double_click_ms = 0;
+    Driver driver(config);
+    driver.Hold(true, 50);
+    driver.Hold(false, 20);
+    driver.Hold(true, 50);
+    driver.Hold(false, 20);
+    // each click on its release, no waiting and no double click
+    AssertEvents({{ButtonGestureEvent::Click, 50}, {ButtonGestureEvent::Click, 120}}, driver.events);
+}
+
+void test_long_press_threshold() {
+    // released one update short of the threshold: a click
+    Driver short_press(defaults);
+    short_press.Hold(true, 600);
+    short_press.Hold(false, 1000);
+    AssertEvents({{ButtonGestureEvent::Click, 900}}, short_press.events);
+
+    // held to the threshold: a long press, and no click on release
+    ButtonGestureConfiguration config;
+    config.repeat_interval_ms = 0;
+    Driver long_press(config);
+    long_press.Hold(true, 601);
+    long_press.Hold(false, 1000);
+    AssertEvents({{ButtonGestureEvent::LongPress, 600}}, long_press.events);
+}
+
+void test_hold_repeat_cadence() {
+    Driver driver(defaults);
+    driver.Hold(true, 1000);
+    driver.Hold(false, 1000);
+    AssertEvents({{ButtonGestureEvent::LongPress, 600},
+                  {ButtonGestureEvent::HoldRepeat, 750},
+                  {ButtonGestureEvent::HoldRepeat, 900}},
+                 driver.events);
+}
+
+void test_hold_repeat_does_not_drift() {
+    // updates every 7 ms: each event on the first update at or after its due time, due times 150 ms apart
+    const uint32_t step_ms = 7;
+    Driver driver(defaults, step_ms);
+    driver.Hold(true, 10000);
+    TEST_ASSERT_TRUE(driver.events.size() > 2);
+    TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(ButtonGestureEvent::LongPress),
+                            static_cast<uint8_t>(driver.events[0].event));
+    const uint32_t long_press_ms = driver.events[0].ms;
+    TEST_ASSERT_TRUE((long_press_ms >= 600) && (long_press_ms < 600 + step_ms));
+    for (size_t i = 1; i < driver.events.size(); i++) {
+        const uint32_t due_ms = long_press_ms + 150 * i;
+        TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(ButtonGestureEvent::HoldRepeat),
+                                static_cast<uint8_t>(driver.events[i].event));
+        TEST_ASSERT_TRUE((driver.events[i].ms >= due_ms) && (driver.events[i].ms < due_ms + step_ms));
+    }
+    // every repeat due before the last update was reported
+    const uint32_t last_ms = (10000 - 1) / step_ms * step_ms;
+    TEST_ASSERT_EQUAL_UINT32(1 + (last_ms - long_press_ms) / 150, driver.events.size());
+}
+
+void test_reset_forgets_gesture() {
+    Driver driver(defaults);
+    driver.Hold(true, 100);
+    driver.Hold(false, 100);
+    driver.Reset();
+    driver.Hold(false, 1000);
+    TEST_ASSERT_EQUAL_UINT32(0, driver.events.size());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_click_waits_for_double_click_window);
+    RUN_TEST(test_double_click_window_edge);
+    RUN_TEST(test_double_click_disabled);
+    RUN_TEST(test_long_press_threshold);
+    RUN_TEST(test_hold_repeat_cadence);
+    RUN_TEST(test_hold_repeat_does_not_drift);
+    RUN_TEST(test_reset_forgets_gesture);
+    return UNITY_END();
+}
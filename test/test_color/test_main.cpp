@@ -0,0 +1,159 @@
+// Integer colour arithmetic of BadgeColor.h against floating point references.
+//
+// Blend8 is checked for every pair of values and amount against the 32-bit formula it folds into 16 bits,
+// and must give exactly a at 0 and b at 255. HsvToRgb is checked over the whole hue circle and a grid of
+// saturation and value against the textbook six-sector conversion, and palette lookups must hit the
+// entries at multiples of 16 and interpolate between them, wrapping from the last entry to the first.
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include <algorithm>
+
+#include "BadgeColor.h"
+
+namespace {
+
+// HSV to RGB in floating point, hue 0 to 256 around the circle
+void ReferenceHsv(const CHSV &hsv, double (&rgb)[3]) {
+    const double v = hsv.v;
+    const double s = hsv.s / 255.0;
+    const double h = hsv.h * 6.0 / 256.0;
+    const int sector = static_cast<int>(h);
+    const double f = h - sector;
+    const double p = v * (1.0 - s);
+    const double q = v * (1.0 - s * f);
+    const double t = v * (1.0 - s * (1.0 - f));
+    const double sectors[6][3] = {{v, t, p}, {q, v, p}, {p, v, t}, {p, q, v}, {t, p, v}, {v, p, q}};
+    for (uint8_t c = 0; c < 3; c++) {
+        rgb[c] = sectors[sector][c];
+    }
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_scale8() {
+    for (uint16_t value = 0; value < 256; value++) {
+        TEST_ASSERT_EQUAL_UINT8(value, Scale8(value, 255));
+        TEST_ASSERT_EQUAL_UINT8(0, Scale8(value, 0));
+        for (uint16_t scale = 0; scale < 256; scale++) {
+            // within one count of value * scale / 255, never above the value
+            TEST_ASSERT_FLOAT_WITHIN(1.0, value * scale / 255.0, Scale8(value, scale));
+            TEST_ASSERT_LESS_OR_EQUAL(value, Scale8(value, scale));
+            if (scale > 0) {
+                TEST_ASSERT_GREATER_OR_EQUAL(Scale8(value, scale - 1), Scale8(value, scale));
+            }
+        }
+    }
+    const CRGB scaled = Scale8(CRGB(200, 100, 50), 127);
+    TEST_ASSERT_EQUAL_UINT8(Scale8(200, 127), scaled.r);
+    TEST_ASSERT_EQUAL_UINT8(Scale8(100, 127), scaled.g);
+    TEST_ASSERT_EQUAL_UINT8(Scale8(50, 127), scaled.b);
+}
+
+void test_add_saturate() {
+    const CRGB sum = AddSaturate(CRGB(200, 100, 0), CRGB(100, 100, 255));
+    TEST_ASSERT_EQUAL_UINT8(255, sum.r);
+    TEST_ASSERT_EQUAL_UINT8(200, sum.g);
+    TEST_ASSERT_EQUAL_UINT8(255, sum.b);
+}
+
+void test_blend8_exact() {
+    for (uint16_t a = 0; a < 256; a++) {
+        for (uint16_t b = 0; b < 256; b++) {
+            TEST_ASSERT_EQUAL_UINT8(a, Blend8(a, b, 0));
+            TEST_ASSERT_EQUAL_UINT8(b, Blend8(a, b, 255));
+            for (uint16_t amount = 0; amount < 256; amount++) {
+                const uint32_t expected = (a * (256UL - amount) + b * (amount + 1UL)) >> 8;
+                if (Blend8(a, b, amount) != expected) {
+                    char message[64];
+                    snprintf(message, sizeof(message), "Blend8(%u, %u, %u)", a, b, amount);
+                    TEST_FAIL_MESSAGE(message);
+                }
+            }
+        }
+    }
+    const CRGB blended = Blend(CRGB(0, 100, 255), CRGB(255, 100, 0), 128);
+    TEST_ASSERT_EQUAL_UINT8(Blend8(0, 255, 128), blended.r);
+    TEST_ASSERT_EQUAL_UINT8(100, blended.g);
+    TEST_ASSERT_EQUAL_UINT8(Blend8(255, 0, 128), blended.b);
+}
+
+void test_hsv_to_rgb() {
+    // grey at zero saturation
+    for (uint16_t v = 0; v < 256; v++) {
+        TEST_ASSERT_TRUE(HsvToRgb(CHSV(77, 0, v)) == CRGB(v, v, v));
+    }
+
+    // primaries and a full sweep with one channel at 255 and one at 0
+    TEST_ASSERT_TRUE(HsvToRgb(CHSV(0, 255, 255)) == CRGB(255, 0, 0));
+    for (uint16_t h = 0; h < 256; h++) {
+        const CRGB rgb = HsvToRgb(CHSV(h, 255, 255));
+        const uint8_t high = std::max(rgb.r, std::max(rgb.g, rgb.b));
+        const uint8_t low = std::min(rgb.r, std::min(rgb.g, rgb.b));
+        TEST_ASSERT_EQUAL_UINT8(255, high);
+        TEST_ASSERT_EQUAL_UINT8(0, low);
+    }
+
+    // against floating point over the hue circle and a grid of saturation and value
+    double worst = 0;
+    for (uint16_t h = 0; h < 256; h++) {
+        for (uint16_t s = 15; s < 256; s += 16) {
+            for (uint16_t v = 15; v < 256; v += 16) {
+                const CHSV hsv(h, s, v);
+                const CRGB rgb = HsvToRgb(hsv);
+                double reference[3];
+                ReferenceHsv(hsv, reference);
+                const uint8_t channels[3] = {rgb.r, rgb.g, rgb.b};
+                for (uint8_t c = 0; c < 3; c++) {
+                    worst = fmax(worst, fabs(channels[c] - reference[c]));
+                }
+            }
+        }
+    }
+    char message[64];
+    snprintf(message, sizeof(message), "HsvToRgb worst error %.2f counts", worst);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(worst < 3.0);
+}
+
+void test_palette_interpolation() {
+    const ColorPalette16 *palettes[] = {&palette_rainbow, &palette_heat, &palette_ocean};
+    for (const ColorPalette16 *palette : palettes) {
+        for (uint16_t index = 0; index < 256; index++) {
+            const uint8_t entry = index >> 4;
+            const CRGB from = palette->entries[entry];
+            const CRGB to = palette->entries[(entry + 1) & 0x0F];
+            const CRGB color = ColorFromPalette(palette, index);
+            if ((index & 0x0F) == 0) {
+                TEST_ASSERT_TRUE(color == from);
+            }
+            // between the two neighbouring entries, on the straight line from one to the other
+            TEST_ASSERT_TRUE(color == Blend(from, to, (index & 0x0F) << 4));
+            TEST_ASSERT_TRUE(color.r >= std::min(from.r, to.r) && color.r <= std::max(from.r, to.r));
+            TEST_ASSERT_TRUE(color.g >= std::min(from.g, to.g) && color.g <= std::max(from.g, to.g));
+            TEST_ASSERT_TRUE(color.b >= std::min(from.b, to.b) && color.b <= std::max(from.b, to.b));
+            TEST_ASSERT_TRUE(ColorFromPalette(palette, index, 100) == Scale8(color, 100));
+        }
+    }
+    // the last entry fades back towards the first
+    const CRGB last = palette_heat.entries[15];
+    const CRGB first = palette_heat.entries[0];
+    TEST_ASSERT_TRUE(ColorFromPalette(&palette_heat, 255) == Blend(last, first, 0xF0));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_scale8);
+    RUN_TEST(test_add_saturate);
+    RUN_TEST(test_blend8_exact);
+    RUN_TEST(test_hsv_to_rgb);
+    RUN_TEST(test_palette_interpolation);
+    return UNITY_END();
+}
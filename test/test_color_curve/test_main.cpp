@@ -0,0 +1,76 @@
+// Contents of the compile-time colour curve tables.
+//
+// The static_asserts in ColorCurve.h only pin the table ends and the direction. Here every entry is checked
+// against the curve evaluated with the host's floating point pow(), and the tables must never fall.
+
+#include <Arduino.h>
+#include <math.h>
+#include <unity.h>
+
+#include "ColorCurve.h"
+
+namespace {
+
+double Gamma22(const double x) {
+    return pow(x, 2.2);
+}
+
+double Cie1931(const double x) {
+    const double lightness = 100.0 * x;
+    return (lightness <= 8.0) ? lightness / 903.3 : pow((lightness + 16.0) / 116.0, 3.0);
+}
+
+void CheckCurve(const ColorCurve curve, double (*reference)(double)) {
+    for (uint16_t i = 0; i < 256; i++) {
+        const double expected = reference(i / 255.0) * 65535.0;
+        // entries are rounded to the nearest duty
+        TEST_ASSERT_FLOAT_WITHIN(0.5 + 1e-6, expected, ColorCurveLookup(curve, i));
+        if (i > 0) {
+            TEST_ASSERT_GREATER_OR_EQUAL(ColorCurveLookup(curve, i - 1), ColorCurveLookup(curve, i));
+        }
+    }
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_linear_scales_to_16_bit() {
+    for (uint16_t i = 0; i < 256; i++) {
+        TEST_ASSERT_EQUAL_UINT16(i * 257, ColorCurveLookup(ColorCurve::Linear, i));
+    }
+}
+
+void test_gamma22_table() {
+    CheckCurve(ColorCurve::Gamma22, Gamma22);
+}
+
+void test_cie1931_table() {
+    CheckCurve(ColorCurve::Cie1931, Cie1931);
+}
+
+void test_curves_rise_after_black() {
+    // every step above black gives more light, except where the gamma curve is still below one duty step
+    for (uint16_t i = 1; i < 256; i++) {
+        TEST_ASSERT_GREATER_THAN(ColorCurveLookup(ColorCurve::Cie1931, i - 1),
+                                 ColorCurveLookup(ColorCurve::Cie1931, i));
+        if (Gamma22(i / 255.0) * 65535.0 >= 1.0) {
+            TEST_ASSERT_GREATER_THAN(ColorCurveLookup(ColorCurve::Gamma22, i - 1),
+                                     ColorCurveLookup(ColorCurve::Gamma22, i));
+        }
+    }
+    // the perceptual curves are darker than linear in the middle
+    TEST_ASSERT_LESS_THAN(ColorCurveLookup(ColorCurve::Linear, 128), ColorCurveLookup(ColorCurve::Gamma22, 128));
+    TEST_ASSERT_LESS_THAN(ColorCurveLookup(ColorCurve::Linear, 128), ColorCurveLookup(ColorCurve::Cie1931, 128));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_linear_scales_to_16_bit);
+    RUN_TEST(test_gamma22_table);
+    RUN_TEST(test_cie1931_table);
+    RUN_TEST(test_curves_rise_after_black);
+    return UNITY_END();
+}
@@ -0,0 +1,230 @@
+// Press-to-event latency and pin samples of Debounce polled from loop() and ticked by the src firmware.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include <algorithm>
+
+#include "../HostTiming.h"
+#include "BadgeEvent.h"
+#include "Debounce.h"
+#include "EventQueue.h"
+
+// event queue of the src firmware
+extern EventQueue<BadgeEvent, 16> events;
+
+namespace {
+
+constexpr uint8_t button_pin = 26;
+// DEBOUNCE_MAX_STEPS of the src firmware
+constexpr uint16_t max_count = 10;
+
+// Timer0 compare A period: prescaler 64, 256 counts at 8 MHz
+constexpr uint32_t tick_us = 64UL * 256UL / (F_CPU / 1000000UL);
+
+constexpr uint32_t run_us = 1000000;
+constexpr uint32_t press_us = 300000;
+constexpr uint32_t release_us = 600000;
+
+struct ModeResult {
+    uint32_t latency_us = 0;
+    uint32_t presses = 0;
+    uint32_t releases = 0;
+    // Update() calls in polled mode, Timer0 and pin-change interrupts in ticked mode
+    uint32_t calls = 0;
+    // digitalRead of the button
+    uint32_t samples = 0;
+};
+
+/**
+ * @brief Run the press and release scenario with loop() passes every loop_us.
+ *
+ * @param ticked Run the src firmware's ticked, pin-change-woken debounce, instead of polling Update() from
+ * loop().
+ */
+ModeResult Run(const bool ticked, const uint32_t loop_us) {
+    hal::Reset();
+    hal::SetRecording(false);
+
+    Debounce polled_debounce;
+    if (ticked) {
+        BadgeEvent event;
+        while (events.Pop(event)) {
+        }
+        setup();
+    } else {
+        pinMode(button_pin, INPUT_PULLUP);
+        DebounceConfiguration config;
+        config.pin = button_pin;
+        config.polarity = HIGH;
+        config.max_count = max_count;
+        config.delay_microseconds = tick_us;
+        polled_debounce.Setup(config);
+    }
+    const uint32_t start_samples = hal::GetReadCount(button_pin);
+    const uint32_t start_interrupts = hal::GetInterruptCount();
+
+    ModeResult result;
+    uint32_t time_us = 0;
+    uint32_t next_loop_us = 0;
+    uint32_t event_us = 0;
+    bool pressed = false;
+    bool released = false;
+
+    while (time_us < run_us) {
+        // next of loop pass and button edge, timer ticks are dispatched on the way
+        uint32_t next_us = next_loop_us;
+        if (!pressed) {
+            next_us = std::min(next_us, press_us);
+        } else if (!released) {
+            next_us = std::min(next_us, release_us);
+        }
+        if (next_us >= run_us) {
+            break;
+        }
+        hal::Advance(next_us - time_us);
+        time_us = next_us;
+
+        if (!pressed && (time_us == press_us)) {
+            pressed = true;
+            hal::SetInput(button_pin, LOW);
+        }
+        if (pressed && !released && (time_us == release_us)) {
+            released = true;
+            hal::SetInput(button_pin, HIGH);
+        }
+
+        if (time_us == next_loop_us) {
+            next_loop_us += loop_us;
+            bool activated = false;
+            bool deactivated = false;
+            if (ticked) {
+                BadgeEvent event;
+                while (events.Pop(event)) {
+                    activated |= (event.type == BadgeEventType::ButtonDown);
+                    deactivated |= (event.type == BadgeEventType::ButtonUp);
+                }
+            } else {
+                polled_debounce.Update();
+                result.calls++;
+                activated = polled_debounce.TakeActivated();
+                deactivated = polled_debounce.TakeDeactivated();
+            }
+            if (activated) {
+                result.presses++;
+                if (event_us == 0) {
+                    event_us = time_us;
+                }
+            }
+            result.releases += deactivated ? 1 : 0;
+        }
+    }
+
+    // ticks up to the end of the window
+    hal::Advance(run_us - time_us);
+
+    if (ticked) {
+        result.calls = hal::GetInterruptCount() - start_interrupts;
+    }
+    result.samples = hal::GetReadCount(button_pin) - start_samples;
+    result.latency_us = event_us - press_us;
+    return result;
+}
+
+void Report(const char *mode, const uint32_t loop_us, const ModeResult &result) {
+    char message[128];
+    snprintf(message, sizeof(message), "%s, %lu us loop: latency %lu us, %lu calls, %lu samples per second", mode,
+             static_cast<unsigned long>(loop_us), static_cast<unsigned long>(result.latency_us),
+             static_cast<unsigned long>(result.calls), static_cast<unsigned long>(result.samples));
+    TEST_MESSAGE(message);
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_ticked_latency_does_not_follow_loop() {
+    const uint32_t loop_periods_us[] = {100, 5000};
+    for (const uint32_t loop_us : loop_periods_us) {
+        const ModeResult polled = Run(false, loop_us);
+        const ModeResult ticked = Run(true, loop_us);
+        Report("polled", loop_us, polled);
+        Report("ticked", loop_us, ticked);
+        TEST_ASSERT_EQUAL_UINT32(1, polled.presses);
+        TEST_ASSERT_EQUAL_UINT32(1, polled.releases);
+        TEST_ASSERT_EQUAL_UINT32(1, ticked.presses);
+        TEST_ASSERT_EQUAL_UINT32(1, ticked.releases);
+
+        // max_count ticks after the press, then up to one loop pass until the event is read
+        TEST_ASSERT_LESS_OR_EQUAL((max_count + 1) * tick_us + loop_us, ticked.latency_us);
+        TEST_ASSERT_GREATER_OR_EQUAL((max_count - 1) * tick_us, ticked.latency_us);
+        // polled samples can be no closer than the loop period
+        const uint32_t polled_sample_us = std::max(loop_us, tick_us);
+        TEST_ASSERT_GREATER_OR_EQUAL((max_count - 1) * polled_sample_us, polled.latency_us);
+    }
+}
+
+void test_samples_per_second() {
+    const uint32_t loop_periods_us[] = {100, 5000};
+    for (const uint32_t loop_us : loop_periods_us) {
+        const ModeResult polled = Run(false, loop_us);
+        const ModeResult ticked = Run(true, loop_us);
+
+        // polled: an Update() call per loop pass, a sample whenever delay_microseconds has passed
+        TEST_ASSERT_EQUAL_UINT32(run_us / loop_us, polled.calls);
+        const uint32_t polled_sample_us = ((tick_us + loop_us - 1) / loop_us) * loop_us;
+        TEST_ASSERT_UINT_WITHIN(1, run_us / polled_sample_us, polled.samples);
+
+        // ticked: every Timer0 compare match plus a pin-change interrupt per edge
+        TEST_ASSERT_EQUAL_UINT32(run_us / tick_us + 2, ticked.calls);
+        // samples only from a wake until the input settles: max_count per edge and one more to fall asleep
+        TEST_ASSERT_LESS_OR_EQUAL(2 * (max_count + 1), ticked.samples);
+        TEST_ASSERT_GREATER_OR_EQUAL(2 * max_count, ticked.samples);
+    }
+}
+
+void test_report_host_cost() {
+    hal::Reset();
+    hal::SetRecording(false);
+    pinMode(button_pin, INPUT_PULLUP);
+    DebounceConfiguration config;
+    config.pin = button_pin;
+    config.polarity = HIGH;
+    config.max_count = max_count;
+    config.delay_microseconds = tick_us;
+
+    constexpr uint32_t rounds = 100000;
+    Debounce polled_debounce;
+    polled_debounce.Setup(config);
+    const double update_ns = TimeCalls([&polled_debounce]() { polled_debounce.Update(); }, rounds);
+
+    // settle once so the ticks measure the idle path the firmware takes between presses
+    Debounce ticked_debounce;
+    ticked_debounce.Setup(config);
+    ticked_debounce.EnableWakeOnChange();
+    ticked_debounce.Tick();
+    const double idle_tick_ns = TimeCalls([&ticked_debounce]() { ticked_debounce.Tick(); }, rounds);
+    ticked_debounce.Wake();
+    const double awake_tick_ns = TimeCalls(
+        [&ticked_debounce]() {
+            ticked_debounce.Wake();
+            ticked_debounce.Tick();
+        },
+        rounds);
+
+    char message[128];
+    snprintf(message, sizeof(message), "host ns per call: Update %.1f, idle Tick %.1f, woken Tick %.1f", update_ns,
+             idle_tick_ns, awake_tick_ns);
+    TEST_MESSAGE(message);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_ticked_latency_does_not_follow_loop);
+    RUN_TEST(test_samples_per_second);
+    RUN_TEST(test_report_host_cost);
+    return UNITY_END();
+}
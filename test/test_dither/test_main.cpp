@@ -0,0 +1,100 @@
+// Time-averaged cathode duty of the refresh scan against the 16-bit CIE target, with and without dithering.
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include "OHS2024Badge.h"
+
+namespace {
+
+constexpr uint16_t num_frames = 256;
+// anode of the first LED, lit for every frame of a one-slot scan once its duty is above zero
+constexpr uint8_t anode_pin = 23;
+// values near black, where one PWM step is a visible jump
+constexpr uint8_t max_value = 63;
+
+struct DitherError {
+    double max = 0;
+    double mean = 0;
+};
+
+/**
+ * @brief Average red output over num_frames scan frames against the curve, for values 1 to max_value.
+ */
+DitherError Measure(const uint8_t dither_bits) {
+    hal::Reset();
+    OHS2024Badge dither_badge;
+    dither_badge.Setup();
+    OHS2024BadgeColorCorrection correction;
+    correction.curve_red = ColorCurve::Cie1931;
+    correction.dither_bits = dither_bits;
+    dither_badge.SetColorCorrection(correction);
+    dither_badge.StartRefresh(100, 1);
+    const OHS2024BadgePins pins;
+
+    DitherError result;
+    double total = 0;
+    for (uint8_t value = 1; value <= max_value; value++) {
+        dither_badge.SetPixels(OHS2024BadgeLEDMask::All, {value, 0, 0});
+        dither_badge.Present();
+        // swap the new frame in and restart the error accumulators from where the last value left them
+        dither_badge.Refresh();
+
+        double sum = 0;
+        for (uint16_t frame = 0; frame < num_frames; frame++) {
+            dither_badge.Refresh();
+            hal::Advance(0);
+            // Present() leaves LEDs out of the scan when their duty rounds to zero, cathodes are active low
+            if (hal::GetOutput(anode_pin) == HIGH) {
+                sum += 255 - hal::GetDuty(pins.pwm_red);
+            }
+        }
+        const double target = ColorCurveLookup(ColorCurve::Cie1931, value) / 65535.0 * 255.0;
+        const double error = fabs(sum / num_frames - target);
+        total += error;
+        if (error > result.max) {
+            result.max = error;
+        }
+    }
+    dither_badge.StopRefresh();
+    result.mean = total / max_value;
+
+    char message[128];
+    snprintf(message, sizeof(message), "dither_bits %u: error over values 1-%u max %.4f, mean %.4f PWM steps",
+             dither_bits, max_value, result.max, result.mean);
+    TEST_MESSAGE(message);
+    return result;
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_undithered_rounds_to_pwm_step() {
+    const DitherError error = Measure(0);
+    // truncation to the 8-bit step: never a whole step off, but close to it for some values
+    TEST_ASSERT_TRUE(error.max < 1.0);
+    TEST_ASSERT_TRUE(error.max > 0.5);
+}
+
+void test_dithered_error_below_fraction_step() {
+    const DitherError undithered = Measure(0);
+    const uint8_t bits[] = {2, 4, 8};
+    for (const uint8_t dither_bits : bits) {
+        const DitherError error = Measure(dither_bits);
+        // only the fraction bits Present() masks off are lost
+        TEST_ASSERT_TRUE(error.max < 1.0 / (1 << dither_bits));
+        TEST_ASSERT_TRUE(error.mean < undithered.mean);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_undithered_rounds_to_pwm_step);
+    RUN_TEST(test_dithered_error_below_fraction_step);
+    return UNITY_END();
+}
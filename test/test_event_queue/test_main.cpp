@@ -0,0 +1,162 @@
+// EventQueue with a producer thread standing in for the interrupt and the test thread as the main loop.
+//
+// Events carry a sequence number and its complement, so a torn copy shows up as a mismatch. The runs
+// are long enough for the 8-bit indices to wrap thousands of times, and the small capacity keeps the
+// producer hitting the full queue.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+
+#include "EventQueue.h"
+
+namespace {
+
+struct SequenceEvent {
+    uint32_t sequence = 0;
+    uint32_t check = 0;
+};
+
+constexpr uint8_t capacity = 8;
+constexpr uint32_t num_events = 1000000;
+
+using SequenceQueue = EventQueue<SequenceEvent, capacity>;
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_fill_drain_across_wraparound() {
+    SequenceQueue queue;
+    SequenceEvent event;
+    uint32_t sequence = 0;
+    uint32_t expected = 0;
+
+    // 100 rounds of fill to full, one rejected push, drain: the indices pass 255 three times
+    for (uint16_t round = 0; round < 100; round++) {
+        for (uint8_t i = 0; i < capacity; i++) {
+            TEST_ASSERT_TRUE(queue.Push({sequence, ~sequence}));
+            sequence++;
+        }
+        TEST_ASSERT_FALSE(queue.Push({sequence, ~sequence}));
+        TEST_ASSERT_FALSE(queue.IsEmpty());
+        while (queue.Pop(event)) {
+            TEST_ASSERT_EQUAL_UINT32(expected, event.sequence);
+            TEST_ASSERT_EQUAL_UINT32(~expected, event.check);
+            expected++;
+        }
+        TEST_ASSERT_TRUE(queue.IsEmpty());
+    }
+    TEST_ASSERT_EQUAL_UINT32(sequence, expected);
+    // the drop count saturates
+    TEST_ASSERT_EQUAL_UINT8(100, queue.GetDropped());
+    for (uint16_t i = 0; i < 300; i++) {
+        for (uint8_t k = 0; k < capacity; k++) {
+            queue.Push({});
+        }
+        queue.Push({});
+        while (queue.Pop(event)) {
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT8(UINT8_MAX, queue.GetDropped());
+}
+
+void test_producer_retries_nothing_lost() {
+    static SequenceQueue queue;
+    std::atomic<uint32_t> full_pushes(0);
+
+    // the producer retries a rejected event, so every number must arrive exactly once and in order
+    std::thread producer([&full_pushes]() {
+        uint32_t sequence = 0;
+        uint32_t full = 0;
+        while (sequence < num_events) {
+            if (queue.Push({sequence, ~sequence})) {
+                sequence++;
+            } else {
+                full++;
+                std::this_thread::yield();
+            }
+        }
+        full_pushes = full;
+    });
+
+    uint32_t expected = 0;
+    uint32_t mismatches = 0;
+    SequenceEvent event;
+    while (expected < num_events) {
+        if (!queue.Pop(event)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if ((event.sequence != expected) || (event.check != ~expected)) {
+            mismatches++;
+            expected = event.sequence;
+        }
+        expected++;
+    }
+    producer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+    TEST_ASSERT_EQUAL_UINT32(num_events, expected);
+    TEST_ASSERT_TRUE(queue.IsEmpty());
+    TEST_ASSERT_FALSE(queue.Pop(event));
+    TEST_ASSERT_GREATER_THAN(0, full_pushes.load());
+}
+
+void test_producer_drops_when_full() {
+    static SequenceQueue queue;
+    std::atomic<uint32_t> accepted(0);
+    std::atomic<bool> done(false);
+
+    // like an interrupt, the producer moves on when the queue is full: what arrives must be exactly the
+    // accepted events, strictly in order
+    std::thread producer([&accepted, &done]() {
+        uint32_t count = 0;
+        for (uint32_t sequence = 0; sequence < num_events; sequence++) {
+            if (queue.Push({sequence, ~sequence})) {
+                count++;
+            }
+        }
+        accepted = count;
+        done = true;
+    });
+
+    uint32_t received = 0;
+    uint32_t last = 0;
+    uint32_t out_of_order = 0;
+    uint32_t torn = 0;
+    SequenceEvent event;
+    while (!done || !queue.IsEmpty()) {
+        if (!queue.Pop(event)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if ((received > 0) && (event.sequence <= last)) {
+            out_of_order++;
+        }
+        if (event.check != ~event.sequence) {
+            torn++;
+        }
+        last = event.sequence;
+        received++;
+    }
+    producer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, out_of_order);
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_EQUAL_UINT32(accepted.load(), received);
+    TEST_ASSERT_GREATER_THAN(0, num_events - received);
+    TEST_ASSERT_GREATER_THAN(0, queue.GetDropped());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fill_drain_across_wraparound);
+    RUN_TEST(test_producer_retries_nothing_lost);
+    RUN_TEST(test_producer_drops_when_full);
+    return UNITY_END();
+}
@@ -0,0 +1,181 @@
+// Oscillator increments, phase continuity, waveform tables, the src breathing period and the old breathing wave.
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include "../HostTiming.h"
+#include "Oscillator.h"
+
+// src firmware
+extern Oscillator anim_breathing;
+
+namespace {
+
+// 2^32 * tick / period, rounded, as SetPeriod() computed it before
+uint32_t ReferenceIncrement(const uint32_t period, const uint32_t tick) {
+    return static_cast<uint32_t>(((static_cast<uint64_t>(tick) << 32) + period / 2) / period);
+}
+
+// FastLED triwave8 and ease8InOutQuad with the fixed scale8
+uint8_t QuadWave8(uint8_t in) {
+    if (in & 0x80) {
+        in = 255 - in;
+    }
+    const uint8_t i = in << 1;
+    uint8_t j = i;
+    if (j & 0x80) {
+        j = 255 - j;
+    }
+    const uint8_t jj = (static_cast<uint16_t>(j) * (1 + j)) >> 8;
+    uint8_t jj2 = jj << 1;
+    if (i & 0x80) {
+        jj2 = 255 - jj2;
+    }
+    return jj2;
+}
+
+// Breathing before the oscillator: time wrapped at the period, scaled to a phase byte every frame
+struct OldBreathing {
+    uint32_t period_ms = 1000;
+    uint32_t step_ms = 20;
+    uint32_t time_ms = 0;
+
+    uint8_t Tick() {
+        time_ms += step_ms;
+        if (time_ms >= period_ms) {
+            time_ms -= period_ms;
+        }
+        return QuadWave8(static_cast<uint8_t>((time_ms * UINT8_MAX) / period_ms));
+    }
+};
+
+}  // namespace
+
+void setUp() {
+    hal::Reset();
+}
+
+void tearDown() {}
+
+void test_increment_matches_exact_division() {
+    const uint32_t periods[] = {1, 2, 3, 7, 1000, 2000, 2000000, 0x7FFFFFFFUL, 0x80000000UL, 0x80000001UL,
+                                UINT32_MAX};
+    const uint32_t ticks[] = {0, 1, 2, 20, 999, 1000, 1001, 20480, 65535, 0x7FFFFFFFUL, 0x80000000UL, UINT32_MAX};
+    Oscillator oscillator;
+    for (const uint32_t period : periods) {
+        for (const uint32_t tick : ticks) {
+            oscillator.SetPeriod(period, tick);
+            TEST_ASSERT_EQUAL_UINT32(ReferenceIncrement(period, tick), oscillator.GetIncrement());
+        }
+    }
+    // random pairs over the whole range
+    randomSeed(1);
+    for (uint16_t n = 0; n < 10000; n++) {
+        const uint32_t period = (static_cast<uint32_t>(random(0x10000)) << 16) | random(0x10000);
+        const uint32_t tick = (static_cast<uint32_t>(random(0x10000)) << 16) | random(0x10000);
+        if (period == 0) {
+            continue;
+        }
+        oscillator.SetPeriod(period, tick);
+        TEST_ASSERT_EQUAL_UINT32(ReferenceIncrement(period, tick), oscillator.GetIncrement());
+    }
+    oscillator.SetPeriod(0, 20);
+    TEST_ASSERT_EQUAL_UINT32(0, oscillator.GetIncrement());
+}
+
+void test_set_period_keeps_phase() {
+    Oscillator oscillator;
+    oscillator.SetPeriod(2000, 20);
+    uint32_t previous = oscillator.GetPhase();
+    for (uint16_t n = 0; n < 1000; n++) {
+        // a new period every 37 ticks, alternating slow and fast
+        if ((n % 37) == 0) {
+            const uint32_t phase = oscillator.GetPhase();
+            oscillator.SetPeriod(((n / 37) % 2) ? 300 : 5000, 20);
+            TEST_ASSERT_EQUAL_UINT32(phase, oscillator.GetPhase());
+        }
+        oscillator.Tick();
+        // every tick advances by exactly the increment in effect, so there is no jump at a change
+        TEST_ASSERT_EQUAL_UINT32(oscillator.GetIncrement(), oscillator.GetPhase() - previous);
+        previous = oscillator.GetPhase();
+    }
+
+    // the period is the same whatever unit it is given in
+    Oscillator ms;
+    Oscillator us;
+    ms.SetPeriod(2000, 20);
+    us.SetPeriod(2000000, 20000);
+    TEST_ASSERT_EQUAL_UINT32(ms.GetIncrement(), us.GetIncrement());
+}
+
+void test_waveform_tables() {
+    Oscillator oscillator;
+    for (uint16_t i = 0; i < 256; i++) {
+        oscillator.SetPhase(static_cast<uint32_t>(i) << 24);
+        const double sine = 127.5 + 127.5 * sin(2.0 * M_PI * i / 256.0);
+        TEST_ASSERT_FLOAT_WITHIN(0.5 + 1e-6, sine, oscillator.Sine());
+        TEST_ASSERT_EQUAL_UINT8(QuadWave8(i), oscillator.Quad());
+        TEST_ASSERT_EQUAL_UINT8((i < 128) ? 2 * i : 2 * (255 - i), oscillator.Triangle());
+        TEST_ASSERT_EQUAL_UINT8(i, oscillator.Sawtooth());
+        TEST_ASSERT_EQUAL_UINT8(oscillator.Sine(), oscillator.Output(OscillatorWave::Sine));
+        TEST_ASSERT_EQUAL_UINT8(oscillator.Quad(), oscillator.Output(OscillatorWave::Quad));
+        TEST_ASSERT_EQUAL_UINT8(oscillator.Triangle(), oscillator.Output(OscillatorWave::Triangle));
+        TEST_ASSERT_EQUAL_UINT8(oscillator.Sawtooth(), oscillator.Output(OscillatorWave::Sawtooth));
+    }
+}
+
+void test_src_breathing_period() {
+    // 10 periods of 2 s, frame ticks posted from Timer0 and applied by loop()
+    setup();
+    const uint32_t start_phase = anim_breathing.GetPhase();
+    while (micros() < 20000000UL) {
+        loop();
+        hal::Advance(100);
+    }
+    // within a frame of where it started
+    const int32_t error = static_cast<int32_t>(anim_breathing.GetPhase() - start_phase);
+    char message[96];
+    snprintf(message, sizeof(message), "src breathing after 20 s: %.2f frames off the start phase",
+             static_cast<double>(error) / anim_breathing.GetIncrement());
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(static_cast<uint32_t>(abs(error)) <= anim_breathing.GetIncrement());
+}
+
+void test_cost_against_old_breathing() {
+    OldBreathing old_breathing;
+    Oscillator oscillator;
+    oscillator.SetPeriod(old_breathing.period_ms, old_breathing.step_ms);
+
+    // same wave within the rounding of the old phase byte
+    for (uint16_t n = 0; n < 500; n++) {
+        oscillator.Tick();
+        const int16_t difference = static_cast<int16_t>(oscillator.Quad()) - old_breathing.Tick();
+        TEST_ASSERT_TRUE(abs(difference) <= 4);
+    }
+
+    constexpr uint32_t rounds = 1000000;
+    volatile uint8_t sink = 0;
+    const double old_ns = TimeCalls([&old_breathing, &sink]() { sink = old_breathing.Tick(); }, rounds);
+    const double oscillator_ns = TimeCalls(
+        [&oscillator, &sink]() {
+            oscillator.Tick();
+            sink = oscillator.Quad();
+        },
+        rounds);
+    char message[96];
+    snprintf(message, sizeof(message), "host ns per frame: old breathing %.2f, Oscillator Tick + Quad %.2f", old_ns,
+             oscillator_ns);
+    TEST_MESSAGE(message);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_increment_matches_exact_division);
+    RUN_TEST(test_set_period_keeps_phase);
+    RUN_TEST(test_waveform_tables);
+    RUN_TEST(test_src_breathing_period);
+    RUN_TEST(test_cost_against_old_breathing);
+    return UNITY_END();
+}
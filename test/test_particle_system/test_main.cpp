@@ -0,0 +1,148 @@
+// ParticleSystem behaviour, and a per-frame cost that grows linearly with the pool size.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include <chrono>
+
+#include "ParticleSystem.h"
+
+namespace {
+
+constexpr uint8_t num_leds = static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs);
+
+/**
+ * @brief Host nanoseconds per frame of a full pool, the fastest of five runs.
+ */
+template <uint8_t Capacity>
+double FrameNs() {
+    constexpr uint32_t frames = 20000;
+    ParticleSystem<Capacity> particles;
+    OHS2024BadgeColor pixels[num_leds] = {};
+    uint32_t checksum = 0;
+    double best_ns = 1e12;
+    randomSeed(1);
+    for (uint8_t run = 0; run < 5; run++) {
+        double run_ns = 0;
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            // refill outside the timed part so every frame runs on a full pool
+            while (particles.Spawn(random(ParticleSystem<Capacity>::max_position + 1), random(-24, 25),
+                                   {200, 40, 120}, 8)) {
+            }
+            const auto start = std::chrono::steady_clock::now();
+            particles.Update();
+            particles.Render(pixels);
+            run_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            checksum += pixels[frame % num_leds].r;
+            for (OHS2024BadgeColor &pixel : pixels) {
+                pixel = {};
+            }
+        }
+        if (run_ns < best_ns) {
+            best_ns = run_ns;
+        }
+    }
+    // keeps the rendered frames observable
+    TEST_ASSERT_TRUE(checksum > 0);
+    return best_ns / frames;
+}
+
+}  // namespace
+
+void setUp() {
+    hal::Reset();
+}
+
+void tearDown() {}
+
+void test_render_splits_between_neighbours() {
+    ParticleSystem<1> particles;
+    OHS2024BadgeColor pixels[num_leds] = {};
+
+    // halfway between the second and third LED of the layout
+    TEST_ASSERT_TRUE(particles.Spawn(0x180, 0, {255, 0, 0}, 0));
+    TEST_ASSERT_FALSE(particles.Spawn(0, 0, {255, 0, 0}, 0));
+    particles.Render(pixels);
+    const uint8_t first = static_cast<uint8_t>(particle_layout[1]);
+    const uint8_t second = static_cast<uint8_t>(particle_layout[2]);
+    TEST_ASSERT_UINT_WITHIN(2, 128, pixels[first].r);
+    TEST_ASSERT_UINT_WITHIN(2, 128, pixels[second].r);
+    for (uint8_t i = 0; i < num_leds; i++) {
+        if ((i != first) && (i != second)) {
+            TEST_ASSERT_EQUAL_UINT8(0, pixels[i].r);
+        }
+        TEST_ASSERT_EQUAL_UINT8(0, pixels[i].g);
+    }
+}
+
+void test_particles_fade_and_leave() {
+    ParticleSystem<4> particles;
+    TEST_ASSERT_FALSE(particles.Spawn(-1, 0, {255, 255, 255}, 0));
+    TEST_ASSERT_FALSE(particles.Spawn(ParticleSystem<4>::max_position + 1, 0, {255, 255, 255}, 0));
+
+    // fast decay, a mover that leaves past the last LED, and a slow fade with no decay at all
+    particles.Spawn(0x200, 0, {255, 255, 255}, 128);
+    particles.Spawn(0, 127, {255, 255, 255}, 0);
+    particles.Spawn(0x100, 0, {255, 255, 255}, 0);
+    TEST_ASSERT_EQUAL_UINT8(3, particles.GetCount());
+
+    // frame on which the count first dropped to 2, 1 and 0
+    uint16_t removed_at[3] = {};
+    uint16_t frames = 0;
+    while ((particles.GetCount() > 0) && (frames < 1000)) {
+        particles.Update();
+        frames++;
+        for (uint8_t left = 0; left < 3; left++) {
+            if ((particles.GetCount() <= left) && (removed_at[2 - left] == 0)) {
+                removed_at[2 - left] = frames;
+            }
+        }
+    }
+    // a decay of 128/256 a little more than halves brightness, 255 fades out in 7 frames
+    TEST_ASSERT_EQUAL_UINT16(7, removed_at[0]);
+    // 127/256 LED per frame passes the last LED at 0x700 on frame 15
+    TEST_ASSERT_EQUAL_UINT16(15, removed_at[1]);
+    // brightness drops at least one step per frame, so even no decay ends within 255 frames
+    TEST_ASSERT_LESS_OR_EQUAL(UINT8_MAX, removed_at[2]);
+    TEST_ASSERT_EQUAL_UINT8(0, particles.GetCount());
+
+    particles.Spawn(0, 0, {255, 255, 255}, 0);
+    particles.Clear();
+    TEST_ASSERT_EQUAL_UINT8(0, particles.GetCount());
+}
+
+void test_overlapping_particles_saturate() {
+    ParticleSystem<8> particles;
+    OHS2024BadgeColor pixels[num_leds] = {};
+    for (uint8_t i = 0; i < 8; i++) {
+        particles.Spawn(0, 0, {100, 0, 0}, 0);
+    }
+    particles.Render(pixels);
+    TEST_ASSERT_EQUAL_UINT8(255, pixels[static_cast<uint8_t>(particle_layout[0])].r);
+}
+
+void test_frame_cost_is_linear() {
+    const double ns_8 = FrameNs<8>();
+    const double ns_16 = FrameNs<16>();
+    const double ns_32 = FrameNs<32>();
+    const double ns_64 = FrameNs<64>();
+
+    char message[128];
+    snprintf(message, sizeof(message), "host ns per frame: 8 particles %.1f, 16 %.1f, 32 %.1f, 64 %.1f", ns_8,
+             ns_16, ns_32, ns_64);
+    TEST_MESSAGE(message);
+
+    // eight times the particles may cost at most eight times as much, with room for timer resolution
+    TEST_ASSERT_TRUE(ns_64 < 8 * ns_8 * 1.5);
+    TEST_ASSERT_TRUE(ns_64 > ns_8);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_render_splits_between_neighbours);
+    RUN_TEST(test_particles_fade_and_leave);
+    RUN_TEST(test_overlapping_particles_saturate);
+    RUN_TEST(test_frame_cost_is_linear);
+    return UNITY_END();
+}
@@ -0,0 +1,172 @@
+// PortDebounce gives the same edges as one Debounce per input, at most a sample apart, in less host time.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include <chrono>
+
+#include "Debounce.h"
+#include "PortDebounce.h"
+
+namespace {
+
+constexpr uint8_t num_inputs = 8;
+constexpr uint32_t sample_us = 2000;
+
+// D0 - D7 are PD0 - PD7
+const uint8_t input_pins[num_inputs] = {0, 1, 2, 3, 4, 5, 6, 7};
+
+PortDebounce port_debounce;
+Debounce pin_debounce[num_inputs];
+
+void SetupDebounce(const uint32_t delay_microseconds) {
+    for (uint8_t i = 0; i < num_inputs; i++) {
+        pinMode(input_pins[i], INPUT_PULLUP);
+    }
+
+    PortDebounceConfiguration port_config;
+    port_config.port_pin = input_pins[0];
+    port_config.mask = 0xFF;
+    port_config.polarity = 0xFF;
+    port_config.delay_microseconds = delay_microseconds;
+    port_debounce.Setup(port_config);
+
+    for (uint8_t i = 0; i < num_inputs; i++) {
+        DebounceConfiguration config;
+        config.pin = input_pins[i];
+        config.polarity = HIGH;
+        config.max_count = 4;
+        config.delay_microseconds = delay_microseconds;
+        pin_debounce[i] = Debounce();
+        pin_debounce[i].Setup(config);
+    }
+}
+
+/**
+ * @brief Input level of a pin at a time: pressed (LOW) for a while, with contact bounce on both edges.
+ */
+uint8_t InputLevel(const uint8_t i, const uint32_t time_us) {
+    const uint32_t press_us = 10000 + i * 3700;
+    const uint32_t release_us = press_us + 40000 + i * 1100;
+    const uint32_t bounce_us = 1500;
+    uint8_t level = ((time_us >= press_us) && (time_us < release_us)) ? LOW : HIGH;
+    const uint32_t edges_us[] = {press_us, release_us};
+    for (const uint32_t edge_us : edges_us) {
+        // contacts chatter every 150 us for the bounce time after each edge
+        if ((time_us >= edge_us) && (time_us < edge_us + bounce_us) && (((time_us - edge_us) / 150) % 2)) {
+            level = !level;
+        }
+    }
+    return level;
+}
+
+// Nanoseconds per update of all inputs
+template <typename Function>
+double TimeUpdates(Function function) {
+    constexpr uint32_t rounds = 50000;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < rounds; n++) {
+        function();
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / rounds;
+}
+
+}  // namespace
+
+void setUp() {
+    hal::Reset();
+}
+
+void tearDown() {}
+
+void test_same_edges_as_debounce() {
+    SetupDebounce(sample_us);
+
+    uint8_t port_presses[num_inputs] = {};
+    uint8_t port_releases[num_inputs] = {};
+    uint8_t pin_presses[num_inputs] = {};
+    uint8_t pin_releases[num_inputs] = {};
+    uint32_t port_press_us[num_inputs] = {};
+    uint32_t pin_press_us[num_inputs] = {};
+
+    for (uint32_t time_us = 0; time_us < 120000; time_us += 50) {
+        for (uint8_t i = 0; i < num_inputs; i++) {
+            hal::SetInput(input_pins[i], InputLevel(i, time_us));
+        }
+        hal::Advance(50);
+
+        port_debounce.Update();
+        const uint8_t activated = port_debounce.TakeActivated();
+        const uint8_t deactivated = port_debounce.TakeDeactivated();
+        for (uint8_t i = 0; i < num_inputs; i++) {
+            pin_debounce[i].Update();
+            if (activated & _BV(i)) {
+                port_presses[i]++;
+                port_press_us[i] = micros();
+            }
+            port_releases[i] += (deactivated & _BV(i)) ? 1 : 0;
+            if (pin_debounce[i].TakeActivated()) {
+                pin_presses[i]++;
+                pin_press_us[i] = micros();
+            }
+            pin_releases[i] += pin_debounce[i].TakeDeactivated() ? 1 : 0;
+        }
+    }
+
+    for (uint8_t i = 0; i < num_inputs; i++) {
+        TEST_ASSERT_EQUAL_UINT8(1, port_presses[i]);
+        TEST_ASSERT_EQUAL_UINT8(1, port_releases[i]);
+        TEST_ASSERT_EQUAL_UINT8(1, pin_presses[i]);
+        TEST_ASSERT_EQUAL_UINT8(1, pin_releases[i]);
+        TEST_ASSERT_UINT_WITHIN(sample_us, pin_press_us[i], port_press_us[i]);
+    }
+    TEST_ASSERT_EQUAL_HEX8(0, port_debounce.GetState());
+}
+
+void test_glitch_is_ignored() {
+    SetupDebounce(sample_us);
+
+    // one sample low on every input
+    for (uint8_t i = 0; i < num_inputs; i++) {
+        hal::SetInput(input_pins[i], LOW);
+    }
+    hal::Advance(sample_us);
+    port_debounce.Update();
+    for (uint8_t i = 0; i < num_inputs; i++) {
+        hal::SetInput(input_pins[i], HIGH);
+    }
+    for (uint8_t n = 0; n < 8; n++) {
+        hal::Advance(sample_us);
+        port_debounce.Update();
+    }
+    TEST_ASSERT_EQUAL_HEX8(0, port_debounce.GetState());
+    TEST_ASSERT_EQUAL_HEX8(0, port_debounce.TakeActivated());
+}
+
+void test_benchmark_update_all_inputs() {
+    hal::SetRecording(false);
+    SetupDebounce(0);
+
+    const double port_ns = TimeUpdates([]() { port_debounce.Update(); });
+    const double pin_ns = TimeUpdates([]() {
+        for (uint8_t i = 0; i < num_inputs; i++) {
+            pin_debounce[i].Update();
+        }
+    });
+
+    char message[96];
+    snprintf(message, sizeof(message), "host ns per update of %u inputs: PortDebounce %.1f, %u x Debounce %.1f",
+             num_inputs, port_ns, num_inputs, pin_ns);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(port_ns < pin_ns);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_same_edges_as_debounce);
+    RUN_TEST(test_glitch_is_ignored);
+    RUN_TEST(test_benchmark_update_all_inputs);
+    return UNITY_END();
+}
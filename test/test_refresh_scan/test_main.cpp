@@ -0,0 +1,441 @@
+// Perceived colour of each LED under the multiplexed refresh scan.
+//
+// The scan runs on the shim's Timer2 for 100 scan frames and the recorded anode and cathode changes are
+// integrated into the average colour each LED shows. Every LED is lit for one slot of the scan, so its
+// average scaled by the scan length must match its framebuffer colour. Through a BadgeEffectPlayer
+// transition every LED must show the weighted sum of what it shows in either effect on its own scan, so
+// a Next() between two single-colour modes keeps the average output constant instead of dropping to 1/8.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include "BadgeEffect.h"
+#include "OHS2024Badge.h"
+
+namespace {
+
+OHS2024Badge scan_badge;
+
+constexpr uint8_t num_leds = static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs);
+const uint8_t anode_pins[num_leds] = {23, 4, 3, 19, 15, 18, 17, 16};
+const OHS2024BadgePins cathode_pins = OHS2024BadgePins();
+
+struct Perceived {
+    double r = 0;
+    double g = 0;
+    double b = 0;
+};
+
+/**
+ * @brief Run the scan for a window and average the light of each LED, 0 to 255 per channel.
+ */
+void PerceiveWindow(const uint32_t us, Perceived (&perceived)[num_leds]) {
+    // levels at the start of the window
+    uint8_t anode[num_leds];
+    for (uint8_t i = 0; i < num_leds; i++) {
+        anode[i] = hal::GetOutput(anode_pins[i]);
+    }
+    uint8_t duty[3] = {hal::GetDuty(cathode_pins.pwm_red), hal::GetDuty(cathode_pins.pwm_green),
+                       hal::GetDuty(cathode_pins.pwm_blue)};
+
+    hal::ClearEvents();
+    const uint32_t start_us = micros();
+    hal::Advance(us);
+    uint32_t last_us = start_us;
+    double sums[num_leds][3] = {};
+
+    uint32_t num_events = 0;
+    const hal::PinEvent *events = hal::GetEvents(&num_events);
+    for (uint32_t n = 0; n <= num_events; n++) {
+        const uint32_t time_us = (n < num_events) ? events[n].time_us : start_us + us;
+        const double dt = time_us - last_us;
+        for (uint8_t i = 0; i < num_leds; i++) {
+            if (anode[i]) {
+                // cathodes are active low
+                for (uint8_t c = 0; c < 3; c++) {
+                    sums[i][c] += dt * (255 - duty[c]);
+                }
+            }
+        }
+        last_us = time_us;
+        if (n == num_events) {
+            break;
+        }
+
+        const hal::PinEvent &event = events[n];
+        if (event.pwm) {
+            const uint8_t c = (event.pin == cathode_pins.pwm_red)     ? 0
+                              : (event.pin == cathode_pins.pwm_green) ? 1
+                                                                      : 2;
+            duty[c] = event.value;
+            continue;
+        }
+        for (uint8_t i = 0; i < num_leds; i++) {
+            if (event.pin == anode_pins[i]) {
+                anode[i] = event.value;
+            }
+        }
+    }
+    for (uint8_t i = 0; i < num_leds; i++) {
+        perceived[i] = {sums[i][0] / us, sums[i][1] / us, sums[i][2] / us};
+    }
+}
+
+/**
+ * @brief Run the scan for whole scan frames and average the light of each LED, 0 to 255 per channel.
+ */
+void Perceive(const uint16_t frames, const uint8_t scan_length, Perceived (&perceived)[num_leds]) {
+    // Timer2 clock select to prescaler, the scan raises one compare match per slot
+    const uint16_t prescalers[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+    const uint32_t slot_cycles = static_cast<uint32_t>(OCR2A + 1) * prescalers[TCCR2B & 0x07];
+    const uint32_t frame_us = static_cast<uint32_t>(slot_cycles * scan_length / (F_CPU / 1000000UL));
+
+    // one frame to swap in the presented table, so the window starts in steady state
+    hal::Advance(frame_us);
+    PerceiveWindow(frame_us * frames, perceived);
+}
+
+void AssertPerceived(const OHS2024BadgeColor &expected, const Perceived &perceived, const uint8_t scan_length) {
+    // duty is 8-bit, integration over whole frames is exact up to microsecond timestamps
+    const double tolerance = 1.0;
+    TEST_ASSERT_FLOAT_WITHIN(tolerance, expected.r, perceived.r * scan_length);
+    TEST_ASSERT_FLOAT_WITHIN(tolerance, expected.g, perceived.g * scan_length);
+    TEST_ASSERT_FLOAT_WITHIN(tolerance, expected.b, perceived.b * scan_length);
+}
+
+// Single colour on a mask of LEDs, black elsewhere
+template <byte Mask, uint8_t Red, uint8_t Green, uint8_t Blue>
+struct FillAnimation {
+    void Start(uint32_t) {}
+    void Update(uint32_t, OHS2024BadgeColor *pixels) {
+        for (uint8_t i = 0; i < num_leds; i++) {
+            pixels[i] = (Mask & (1 << i)) ? OHS2024BadgeColor(Red, Green, Blue) : OHS2024BadgeColor();
+        }
+    }
+};
+
+// A colour per LED, needing a slot per LED
+struct ColoursAnimation {
+    void Start(uint32_t) {}
+    void Update(uint32_t, OHS2024BadgeColor *pixels) {
+        for (uint8_t i = 0; i < num_leds; i++) {
+            pixels[i] = OHS2024BadgeColor(30 * i, 255 - 20 * i, 255);
+        }
+    }
+};
+
+using RedHeadAndEyes = FillAnimation<OHS2024BadgeLEDMask::Head | OHS2024BadgeLEDMask::Eyes, 255, 0, 0>;
+using GreenEyesAndBody = FillAnimation<OHS2024BadgeLEDMask::Eyes | OHS2024BadgeLEDMask::Body, 0, 255, 0>;
+
+// wipes are asked for and fall back to a crossfade in time where the scans are short
+constexpr BadgeEffect transition_effects[] PROGMEM = {
+    MakeBadgeEffect<RedHeadAndEyes>(1, BadgeTransitionType::Wipe),
+    MakeBadgeEffect<GreenEyesAndBody>(1, BadgeTransitionType::Wipe),
+    MakeBadgeEffect<ColoursAnimation>(num_leds, BadgeTransitionType::Dissolve),
+};
+constexpr uint8_t num_transition_effects = sizeof(transition_effects) / sizeof(transition_effects[0]);
+
+constexpr uint16_t transition_refresh_hz = 200;
+constexpr uint32_t transition_frame_ms = 20;
+constexpr uint16_t transition_ms = 600;
+
+/**
+ * @brief Perceived colours of every rendered frame of a player from one Next() until the transition ends.
+ *
+ * Frames are rendered and presented the way the DefaultBadge sketch does, restarting the refresh when the
+ * player's scan length changes, and each is measured over two scan frames once it is swapped in.
+ *
+ * @return Number of frames measured.
+ */
+template <uint8_t StateSize>
+uint8_t PerceiveTransition(BadgeEffectPlayer<StateSize> &player, const uint8_t from,
+                           Perceived (&frames)[40][num_leds]) {
+    player.Start(from, millis(), false);
+    uint8_t scan_length = player.GetScanLength();
+    scan_badge.StartRefresh(transition_refresh_hz, scan_length);
+
+    const uint32_t scan_frame_us = 1000000UL / transition_refresh_hz;
+    uint8_t num_frames = 0;
+    bool next = false;
+    while (num_frames < 40) {
+        const uint32_t frame_start_us = micros();
+        if (!next && (num_frames == 2)) {
+            next = true;
+            player.Next(millis());
+        }
+        player.Render(millis(), scan_badge.BeginFrame());
+        if (player.GetScanLength() != scan_length) {
+            scan_length = player.GetScanLength();
+            scan_badge.StartRefresh(transition_refresh_hz, scan_length);
+        }
+        player.Present(scan_badge);
+
+        // swapped in at the next scan frame boundary
+        while (scan_badge.IsPresentPending()) {
+            hal::Advance(10);
+        }
+        PerceiveWindow(2 * scan_frame_us, frames[num_frames]);
+        num_frames++;
+        hal::Advance(transition_frame_ms * 1000UL - (micros() - frame_start_us));
+        if ((num_frames > 4) && (num_frames * transition_frame_ms > transition_ms + 4 * transition_frame_ms)) {
+            break;
+        }
+    }
+    return num_frames;
+}
+
+/**
+ * @brief Check that every frame is the weighted sum of the two effects shown on their own scans.
+ *
+ * The weight of each frame is fitted from the measurement, then every LED and channel must be within
+ * tolerance of outgoing / outgoing_scan * (1 - weight) + incoming / incoming_scan * weight.
+ *
+ * @return Number of frames with a weight strictly between 0 and 1.
+ */
+uint8_t AssertWeightedSums(const Perceived (&frames)[40][num_leds], const uint8_t num_frames,
+                           const OHS2024BadgeColor (&outgoing)[num_leds], const uint8_t outgoing_scan,
+                           const OHS2024BadgeColor (&incoming)[num_leds], const uint8_t incoming_scan) {
+    const double tolerance = 4.0;
+    uint8_t mixed_frames = 0;
+    for (uint8_t f = 0; f < num_frames; f++) {
+        double a[num_leds * 3];
+        double b[num_leds * 3];
+        double p[num_leds * 3];
+        for (uint8_t i = 0; i < num_leds; i++) {
+            const uint8_t from[3] = {outgoing[i].r, outgoing[i].g, outgoing[i].b};
+            const uint8_t to[3] = {incoming[i].r, incoming[i].g, incoming[i].b};
+            const double seen[3] = {frames[f][i].r, frames[f][i].g, frames[f][i].b};
+            for (uint8_t c = 0; c < 3; c++) {
+                a[3 * i + c] = static_cast<double>(from[c]) / outgoing_scan;
+                b[3 * i + c] = static_cast<double>(to[c]) / incoming_scan;
+                p[3 * i + c] = seen[c];
+            }
+        }
+        // least squares weight of p = a + (b - a) * weight
+        double numerator = 0;
+        double denominator = 0;
+        for (uint8_t n = 0; n < num_leds * 3; n++) {
+            numerator += (p[n] - a[n]) * (b[n] - a[n]);
+            denominator += (b[n] - a[n]) * (b[n] - a[n]);
+        }
+        const double weight = numerator / denominator;
+        TEST_ASSERT_TRUE((weight > -0.02) && (weight < 1.02));
+        mixed_frames += ((weight > 0.05) && (weight < 0.95)) ? 1 : 0;
+        for (uint8_t n = 0; n < num_leds * 3; n++) {
+            const double expected = a[n] + (b[n] - a[n]) * weight;
+            if (fabs(p[n] - expected) > tolerance) {
+                char message[96];
+                snprintf(message, sizeof(message), "frame %u LED %u channel %u: %.1f, expected %.1f", f, n / 3, n % 3,
+                         p[n], expected);
+                TEST_FAIL_MESSAGE(message);
+            }
+        }
+    }
+    return mixed_frames;
+}
+
+}  // namespace
+
+ISR(TIMER2_COMPA_vect) {
+    scan_badge.Refresh();
+}
+
+void setUp() {
+    hal::Reset();
+    scan_badge = OHS2024Badge();
+    scan_badge.Setup();
+}
+
+void tearDown() {
+    scan_badge.StopRefresh();
+}
+
+void test_every_led_its_own_colour() {
+    const OHS2024BadgeColor colors[num_leds] = {
+        {255, 0, 0},   {0, 255, 0},   {0, 0, 255},   {255, 255, 0},
+        {0, 255, 255}, {255, 0, 255}, {128, 64, 32}, {10, 200, 90},
+    };
+    scan_badge.StartRefresh(100);
+    for (uint8_t i = 0; i < num_leds; i++) {
+        scan_badge.SetPixel(static_cast<OHS2024BadgeLED>(i), colors[i]);
+    }
+    TEST_ASSERT_TRUE(scan_badge.Present());
+
+    Perceived perceived[num_leds];
+    Perceive(100, num_leds, perceived);
+    for (uint8_t i = 0; i < num_leds; i++) {
+        AssertPerceived(colors[i], perceived[i], num_leds);
+    }
+}
+
+void test_shared_colours_share_a_slot() {
+    const OHS2024BadgeColor red = {255, 0, 0};
+    const OHS2024BadgeColor blue = {0, 0, 200};
+    const OHS2024BadgeColor black = {};
+    scan_badge.StartRefresh(100);
+    scan_badge.SetPixels(OHS2024BadgeLEDMask::Eyes, red);
+    scan_badge.SetPixels(OHS2024BadgeLEDMask::Body, blue);
+    TEST_ASSERT_TRUE(scan_badge.Present());
+
+    // lit LEDs keep their 1/8 duty cycle, the head stays dark
+    Perceived perceived[num_leds];
+    Perceive(100, num_leds, perceived);
+    for (uint8_t i = 0; i < num_leds; i++) {
+        const byte bit = 1 << i;
+        const OHS2024BadgeColor &expected =
+            (bit & OHS2024BadgeLEDMask::Eyes) ? red : (bit & OHS2024BadgeLEDMask::Body) ? blue : black;
+        AssertPerceived(expected, perceived[i], num_leds);
+    }
+}
+
+void test_shorter_scan_is_brighter() {
+    const OHS2024BadgeColor colors[3] = {{200, 0, 0}, {0, 200, 0}, {0, 0, 200}};
+    const uint8_t scan_length = 3;
+    scan_badge.StartRefresh(100, scan_length);
+    scan_badge.SetPixels(OHS2024BadgeLEDMask::Head, colors[0]);
+    scan_badge.SetPixels(OHS2024BadgeLEDMask::Eyes, colors[1]);
+    scan_badge.SetPixels(OHS2024BadgeLEDMask::Body, colors[2]);
+    TEST_ASSERT_TRUE(scan_badge.Present());
+
+    Perceived perceived[num_leds];
+    Perceive(100, scan_length, perceived);
+    for (uint8_t i = 0; i < num_leds; i++) {
+        const byte bit = 1 << i;
+        const uint8_t k = (bit & OHS2024BadgeLEDMask::Head) ? 0 : (bit & OHS2024BadgeLEDMask::Eyes) ? 1 : 2;
+        AssertPerceived(colors[k], perceived[i], scan_length);
+    }
+}
+
+void test_colours_beyond_scan_length_stay_dark() {
+    const OHS2024BadgeColor colors[3] = {{200, 0, 0}, {0, 200, 0}, {0, 0, 200}};
+    const uint8_t scan_length = 2;
+    scan_badge.StartRefresh(100, scan_length);
+    scan_badge.SetPixels(OHS2024BadgeLEDMask::Head, colors[0]);
+    scan_badge.SetPixels(OHS2024BadgeLEDMask::Eyes, colors[1]);
+    scan_badge.SetPixels(OHS2024BadgeLEDMask::Body, colors[2]);
+    TEST_ASSERT_FALSE(scan_badge.Present());
+
+    // slots are taken in LED order, so the body colour is the one left out
+    Perceived perceived[num_leds];
+    Perceive(100, scan_length, perceived);
+    for (uint8_t i = 0; i < num_leds; i++) {
+        const byte bit = 1 << i;
+        const OHS2024BadgeColor expected = (bit & OHS2024BadgeLEDMask::Head)   ? colors[0]
+                                           : (bit & OHS2024BadgeLEDMask::Eyes) ? colors[1]
+                                                                               : OHS2024BadgeColor();
+        AssertPerceived(expected, perceived[i], scan_length);
+    }
+}
+
+void test_new_frame_replaces_old() {
+    const OHS2024BadgeColor green = {0, 255, 0};
+    scan_badge.StartRefresh(100);
+    scan_badge.SetPixels(OHS2024BadgeLEDMask::All, {255, 0, 0});
+    scan_badge.Present();
+    hal::Advance(50000);
+    scan_badge.SetPixels(OHS2024BadgeLEDMask::All, green);
+    scan_badge.Present();
+    hal::Advance(20000);
+    TEST_ASSERT_FALSE(scan_badge.IsPresentPending());
+
+    Perceived perceived[num_leds];
+    Perceive(100, num_leds, perceived);
+    for (uint8_t i = 0; i < num_leds; i++) {
+        AssertPerceived(green, perceived[i], num_leds);
+    }
+}
+
+void test_dropped_frames_only_count_while_refreshing() {
+    // nothing takes pending frames before refresh starts, so replacing them drops nothing
+    for (uint8_t n = 0; n < 3; n++) {
+        scan_badge.SetPixels(OHS2024BadgeLEDMask::All, {n, 0, 0});
+        scan_badge.Present();
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, scan_badge.GetDroppedFrames());
+
+    scan_badge.StartRefresh(100);
+    hal::Advance(20000);
+    TEST_ASSERT_FALSE(scan_badge.IsPresentPending());
+    TEST_ASSERT_EQUAL_UINT16(0, scan_badge.GetDroppedFrames());
+
+    // two frames within one scan frame, the first is never shown
+    scan_badge.Present();
+    scan_badge.Present();
+    hal::Advance(20000);
+    scan_badge.Present();
+    hal::Advance(20000);
+    TEST_ASSERT_EQUAL_UINT16(1, scan_badge.GetDroppedFrames());
+}
+
+void test_transition_keeps_brightness() {
+    BadgeEffectPlayer<BadgeEffectMaxStateSize(transition_effects)> player;
+    BadgeEffectPlayerConfiguration config = {};
+    config.effects = transition_effects;
+    config.num_effects = num_transition_effects;
+    config.num_modes = num_transition_effects;
+    config.transition_ms = transition_ms;
+    player.Setup(config);
+
+    Perceived frames[40][num_leds];
+    const uint8_t num_frames = PerceiveTransition(player, 0, frames);
+
+    // red head and eyes hand over to green eyes and body at full brightness
+    for (uint8_t f = 0; f < num_frames; f++) {
+        double total = 0;
+        for (uint8_t i = 0; i < num_leds; i++) {
+            total += frames[f][i].r + frames[f][i].g + frames[f][i].b;
+        }
+        const double average = total / num_leds;
+        if (fabs(average - 5 * 255.0 / num_leds) > 3.0) {
+            char message[64];
+            snprintf(message, sizeof(message), "frame %u: average output %.1f", f, average);
+            TEST_FAIL_MESSAGE(message);
+        }
+    }
+
+    OHS2024BadgeColor red[num_leds];
+    OHS2024BadgeColor green[num_leds];
+    RedHeadAndEyes().Update(0, red);
+    GreenEyesAndBody().Update(0, green);
+    const uint8_t mixed_frames = AssertWeightedSums(frames, num_frames, red, 1, green, 1);
+    // 600 ms of 20 ms frames
+    TEST_ASSERT_GREATER_OR_EQUAL(25, mixed_frames);
+}
+
+void test_transition_between_scan_lengths() {
+    BadgeEffectPlayer<BadgeEffectMaxStateSize(transition_effects)> player;
+    BadgeEffectPlayerConfiguration config = {};
+    config.effects = transition_effects;
+    config.num_effects = num_transition_effects;
+    config.num_modes = num_transition_effects;
+    config.transition_ms = transition_ms;
+    player.Setup(config);
+
+    OHS2024BadgeColor green[num_leds];
+    OHS2024BadgeColor colours[num_leds];
+    OHS2024BadgeColor red[num_leds];
+    GreenEyesAndBody().Update(0, green);
+    ColoursAnimation().Update(0, colours);
+    RedHeadAndEyes().Update(0, red);
+
+    // single colour into a slot per LED and back: each LED moves between its brightness on either scan
+    Perceived frames[40][num_leds];
+    uint8_t num_frames = PerceiveTransition(player, 1, frames);
+    TEST_ASSERT_GREATER_OR_EQUAL(25, AssertWeightedSums(frames, num_frames, green, 1, colours, num_leds));
+    num_frames = PerceiveTransition(player, 2, frames);
+    TEST_ASSERT_GREATER_OR_EQUAL(25, AssertWeightedSums(frames, num_frames, colours, num_leds, red, 1));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_led_its_own_colour);
+    RUN_TEST(test_shared_colours_share_a_slot);
+    RUN_TEST(test_shorter_scan_is_brighter);
+    RUN_TEST(test_colours_beyond_scan_length_stay_dark);
+    RUN_TEST(test_new_frame_replaces_old);
+    RUN_TEST(test_dropped_frames_only_count_while_refreshing);
+    RUN_TEST(test_transition_keeps_brightness);
+    RUN_TEST(test_transition_between_scan_lengths);
+    return UNITY_END();
+}
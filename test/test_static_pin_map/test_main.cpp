@@ -0,0 +1,194 @@
+// OHS2024BadgeT with the compile-time pin map: same pins and registers as OHS2024Badge, and no state of its own.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include <type_traits>
+
+#include "OHS2024BadgeT.h"
+
+namespace {
+
+using StaticBadge = OHS2024BadgeT<>;
+
+const uint8_t anode_pins[] = {23, 4, 3, 19, 15, 18, 17, 16};
+
+uint8_t AnodeLevels() {
+    hal::Advance(0);
+    uint8_t levels = 0;
+    for (uint8_t i = 0; i < sizeof(anode_pins); i++) {
+        levels |= hal::GetOutput(anode_pins[i]) << i;
+    }
+    return levels;
+}
+
+// Every single LED is one bit, so constant-argument calls take the single-bit branch of WritePort
+template <typename Pin>
+constexpr bool IsSingleBit() {
+    return (Pin::mask != 0) && ((Pin::mask & (Pin::mask - 1)) == 0);
+}
+static_assert(IsSingleBit<OHS2024BadgeStaticPins::HeadRight>() && IsSingleBit<OHS2024BadgeStaticPins::HeadTop>() &&
+                  IsSingleBit<OHS2024BadgeStaticPins::HeadLeft>() && IsSingleBit<OHS2024BadgeStaticPins::EyeRight>() &&
+                  IsSingleBit<OHS2024BadgeStaticPins::EyeLeft>() && IsSingleBit<OHS2024BadgeStaticPins::BodyRight>() &&
+                  IsSingleBit<OHS2024BadgeStaticPins::BodyCenter>() && IsSingleBit<OHS2024BadgeStaticPins::BodyLeft>(),
+              "Static pin map must place each LED on one bit");
+
+template <typename Pin>
+void AssertResolvesTo(const uint8_t pin) {
+    TEST_ASSERT_TRUE(portOutputRegister(digitalPinToPort(pin)) == &_SFR_MEM8(Pin::port));
+    TEST_ASSERT_TRUE(portModeRegister(digitalPinToPort(pin)) == &_SFR_MEM8(Pin::ddr));
+    TEST_ASSERT_EQUAL_HEX8(digitalPinToBitMask(pin), Pin::mask);
+}
+
+// Simulated data space after a call, with PINx brought up to date
+struct Registers {
+    uint8_t sfr[sizeof(hal_sfr)];
+};
+
+Registers Snapshot() {
+    hal::Advance(0);
+    Registers registers;
+    for (uint16_t i = 0; i < sizeof(hal_sfr); i++) {
+        registers.sfr[i] = hal_sfr[i];
+    }
+    return registers;
+}
+
+void Restore(const Registers &registers) {
+    for (uint16_t i = 0; i < sizeof(hal_sfr); i++) {
+        hal_sfr[i] = registers.sfr[i];
+    }
+}
+
+// Run the same call on both classes from the same register state and compare the state they leave
+template <typename RuntimeCall, typename StaticCall>
+void AssertSameRegisters(RuntimeCall runtime_call, StaticCall static_call) {
+    const Registers before = Snapshot();
+    runtime_call();
+    const Registers runtime_after = Snapshot();
+    Restore(before);
+    static_call();
+    const Registers static_after = Snapshot();
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(runtime_after.sfr, static_after.sfr, sizeof(hal_sfr));
+}
+
+}  // namespace
+
+void setUp() {
+    hal::Reset();
+}
+
+void tearDown() {}
+
+void test_single_leds_match() {
+    OHS2024Badge runtime_badge;
+    runtime_badge.Setup();
+    const uint8_t runtime_off = AnodeLevels();
+    StaticBadge::Setup();
+    TEST_ASSERT_EQUAL_HEX8(runtime_off, AnodeLevels());
+
+    for (uint8_t i = 0; i < static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs); i++) {
+        const OHS2024BadgeLED led = static_cast<OHS2024BadgeLED>(i);
+        runtime_badge.TurnOnLED(led);
+        const uint8_t expected = AnodeLevels();
+        TEST_ASSERT_EQUAL_HEX8(1 << i, expected);
+        runtime_badge.TurnOffLED(led);
+
+        StaticBadge::TurnOnLED(led);
+        TEST_ASSERT_EQUAL_HEX8(expected, AnodeLevels());
+        StaticBadge::TurnOffLED(led);
+        TEST_ASSERT_EQUAL_HEX8(0, AnodeLevels());
+    }
+}
+
+void test_masks_and_groups_match() {
+    OHS2024Badge runtime_badge;
+    runtime_badge.Setup();
+    StaticBadge::Setup();
+
+    for (uint16_t mask = 0; mask <= OHS2024BadgeLEDMask::All; mask++) {
+        runtime_badge.SetLEDMask(mask);
+        const uint8_t expected = AnodeLevels();
+        StaticBadge::SetLEDMask(OHS2024BadgeLEDMask::None);
+        StaticBadge::SetLEDMask(mask);
+        TEST_ASSERT_EQUAL_HEX8(expected, AnodeLevels());
+    }
+
+    StaticBadge::SetLEDMask(OHS2024BadgeLEDMask::None);
+    StaticBadge::TurnOnHeadLEDs();
+    TEST_ASSERT_EQUAL_HEX8(OHS2024BadgeLEDMask::Head, AnodeLevels());
+    StaticBadge::TurnOnEyeLEDs();
+    StaticBadge::TurnOnBodyLEDs();
+    TEST_ASSERT_EQUAL_HEX8(OHS2024BadgeLEDMask::All, AnodeLevels());
+    StaticBadge::TurnOffHeadLEDs();
+    StaticBadge::TurnOffBodyLEDs();
+    TEST_ASSERT_EQUAL_HEX8(OHS2024BadgeLEDMask::Eyes, AnodeLevels());
+    StaticBadge::TurnOffEyeLEDs();
+    TEST_ASSERT_EQUAL_HEX8(OHS2024BadgeLEDMask::None, AnodeLevels());
+}
+
+void test_static_badge_holds_no_state() {
+    TEST_ASSERT_TRUE(std::is_empty<StaticBadge>::value);
+
+    // pin numbers and resolved port map; the port map holds pointers, 2 bytes each on the AVR
+    char message[96];
+    snprintf(message, sizeof(message), "pin map RAM: OHS2024Badge %u bytes (host), OHS2024BadgeT 0 bytes",
+             static_cast<unsigned>(sizeof(OHS2024BadgePins) + sizeof(OHS2024BadgePortMap)));
+    TEST_MESSAGE(message);
+}
+
+void test_static_pins_resolve_like_arduino() {
+    const OHS2024BadgePins pins;
+    AssertResolvesTo<OHS2024BadgeStaticPins::HeadRight>(pins.head_right);
+    AssertResolvesTo<OHS2024BadgeStaticPins::HeadTop>(pins.head_top);
+    AssertResolvesTo<OHS2024BadgeStaticPins::HeadLeft>(pins.head_left);
+    AssertResolvesTo<OHS2024BadgeStaticPins::EyeRight>(pins.eye_right);
+    AssertResolvesTo<OHS2024BadgeStaticPins::EyeLeft>(pins.eye_left);
+    AssertResolvesTo<OHS2024BadgeStaticPins::BodyRight>(pins.body_right);
+    AssertResolvesTo<OHS2024BadgeStaticPins::BodyCenter>(pins.body_center);
+    AssertResolvesTo<OHS2024BadgeStaticPins::BodyLeft>(pins.body_left);
+    TEST_ASSERT_EQUAL_UINT8(pins.pwm_red, OHS2024BadgeStaticPins::pwm_red);
+    TEST_ASSERT_EQUAL_UINT8(pins.pwm_green, OHS2024BadgeStaticPins::pwm_green);
+    TEST_ASSERT_EQUAL_UINT8(pins.pwm_blue, OHS2024BadgeStaticPins::pwm_blue);
+}
+
+void test_same_register_writes() {
+    hal::SetRecording(false);
+    OHS2024Badge runtime_badge;
+    AssertSameRegisters([&runtime_badge]() { runtime_badge.Setup(); }, []() { StaticBadge::Setup(); });
+
+    for (uint8_t i = 0; i < static_cast<uint8_t>(OHS2024BadgeLED::NumLEDs); i++) {
+        const OHS2024BadgeLED led = static_cast<OHS2024BadgeLED>(i);
+        AssertSameRegisters([&runtime_badge, led]() { runtime_badge.TurnOnLED(led); },
+                            [led]() { StaticBadge::TurnOnLED(led); });
+        AssertSameRegisters([&runtime_badge, led]() { runtime_badge.TurnOffLED(led); },
+                            [led]() { StaticBadge::TurnOffLED(led); });
+    }
+    for (uint16_t mask = 0; mask <= OHS2024BadgeLEDMask::All; mask++) {
+        AssertSameRegisters([&runtime_badge, mask]() { runtime_badge.SetLEDMask(mask); },
+                            [mask]() { StaticBadge::SetLEDMask(mask); });
+    }
+    AssertSameRegisters([&runtime_badge]() { runtime_badge.TurnOnHeadLEDs(); },
+                        []() { StaticBadge::TurnOnHeadLEDs(); });
+    AssertSameRegisters([&runtime_badge]() { runtime_badge.TurnOnEyeLEDs(); },
+                        []() { StaticBadge::TurnOnEyeLEDs(); });
+    AssertSameRegisters([&runtime_badge]() { runtime_badge.TurnOnBodyLEDs(); },
+                        []() { StaticBadge::TurnOnBodyLEDs(); });
+    AssertSameRegisters([&runtime_badge]() { runtime_badge.TurnOffHeadLEDs(); },
+                        []() { StaticBadge::TurnOffHeadLEDs(); });
+    AssertSameRegisters([&runtime_badge]() { runtime_badge.TurnOffEyeLEDs(); },
+                        []() { StaticBadge::TurnOffEyeLEDs(); });
+    AssertSameRegisters([&runtime_badge]() { runtime_badge.TurnOffBodyLEDs(); },
+                        []() { StaticBadge::TurnOffBodyLEDs(); });
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_leds_match);
+    RUN_TEST(test_masks_and_groups_match);
+    RUN_TEST(test_static_badge_holds_no_state);
+    RUN_TEST(test_static_pins_resolve_like_arduino);
+    RUN_TEST(test_same_register_writes);
+    return UNITY_END();
+}